@@ -60,6 +60,8 @@ struct OutsForAmount {
 struct TransactionShortInfo {
   Crypto::Hash txId;
   TransactionPrefix txPrefix;
+  // Empty if the node didn't provide global output indexes
+  std::vector<uint32_t> globalIndexes;
 };
 
 struct BlockShortEntry {
@@ -67,6 +69,7 @@ struct BlockShortEntry {
   bool hasBlock;
   CryptoNote::BlockTemplate block;
   std::vector<TransactionShortInfo> txsShortInfo;
+  std::vector<uint32_t> baseTransactionGlobalIndexes;
 };
 
 struct BlockHeaderInfo {
@@ -0,0 +1,158 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Common {
+
+// Bounded least recently used cache split into independently locked shards, so concurrent readers rarely wait for
+// each other. Values read from the source of truth are inserted with the generation taken before the read; the writer
+// calls invalidateReads() after changing the source, so a reader that raced with it can't put a stale value back.
+template<class Key, class Value, class KeyHash = std::hash<Key>>
+class ShardedLruCache {
+public:
+  ShardedLruCache(size_t capacity, size_t shardCount) :
+    m_shards(shardCount), m_shardCapacity(std::max<size_t>(capacity / shardCount, 1)), m_generation(0), m_hits(0), m_misses(0) {
+    for (auto& shard : m_shards) {
+      shard.reset(new Shard());
+    }
+  }
+
+  ShardedLruCache(const ShardedLruCache&) = delete;
+  ShardedLruCache& operator=(const ShardedLruCache&) = delete;
+
+  bool find(const Key& key, Value& value) {
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      ++m_misses;
+      return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    value = it->second->second;
+    ++m_hits;
+    return true;
+  }
+
+  // Neither counted as a hit or a miss nor moved to the front
+  bool contains(const Key& key) {
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.index.count(key) != 0;
+  }
+
+  uint64_t getGeneration() const {
+    return m_generation.load();
+  }
+
+  // Does nothing if the source changed after generation was taken
+  void insert(const Key& key, const Value& value, uint64_t generation) {
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (m_generation.load() == generation) {
+      doUpdate(shard, key, value);
+    }
+  }
+
+  void invalidateReads() {
+    ++m_generation;
+  }
+
+  // Writer side, stores the new value regardless of the generation
+  void update(const Key& key, const Value& value) {
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    doUpdate(shard, key, value);
+  }
+
+  void clear() {
+    for (auto& shard : m_shards) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->index.clear();
+      shard->entries.clear();
+    }
+  }
+
+  uint64_t getHits() const {
+    return m_hits.load();
+  }
+
+  uint64_t getMisses() const {
+    return m_misses.load();
+  }
+
+  size_t size() const {
+    size_t result = 0;
+    for (auto& shard : m_shards) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      result += shard->index.size();
+    }
+
+    return result;
+  }
+
+private:
+  typedef std::list<std::pair<Key, Value>> Entries;
+
+  struct Shard {
+    std::mutex mutex;
+    Entries entries;
+    std::unordered_map<Key, typename Entries::iterator, KeyHash> index;
+  };
+
+  Shard& getShard(const Key& key) {
+    // Spread keys whose hashes only differ in the low bits, the unordered_map of the shard uses those
+    return *m_shards[(KeyHash()(key) >> 16) % m_shards.size()];
+  }
+
+  void doUpdate(Shard& shard, const Key& key, const Value& value) {
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      it->second->second = value;
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      return;
+    }
+
+    shard.entries.emplace_front(key, value);
+    shard.index.emplace(key, shard.entries.begin());
+    if (shard.index.size() > m_shardCapacity) {
+      shard.index.erase(shard.entries.back().first);
+      shard.entries.pop_back();
+    }
+  }
+
+  std::vector<std::unique_ptr<Shard>> m_shards;
+  const size_t m_shardCapacity;
+  std::atomic<uint64_t> m_generation;
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+};
+
+}
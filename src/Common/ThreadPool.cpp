@@ -0,0 +1,135 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace Common {
+
+namespace {
+
+struct ParallelForState {
+  ParallelForState(size_t count, const std::function<void(size_t)>& job) : count(count), job(job), next(0), finished(0) {
+  }
+
+  // Returns false when all indexes are claimed. job is only touched for claimed indexes, the caller of parallelFor
+  // doesn't return before those are finished, so helpers that start late never see a dangling reference.
+  bool runOne() {
+    size_t index = next.fetch_add(1);
+    if (index >= count) {
+      return false;
+    }
+
+    try {
+      job(index);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (++finished == count) {
+      allFinished.notify_all();
+    }
+
+    return true;
+  }
+
+  const size_t count;
+  const std::function<void(size_t)>& job;
+  std::atomic<size_t> next;
+  size_t finished;
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable allFinished;
+};
+
+}
+
+ThreadPool::ThreadPool(size_t threadCount) : m_jobs(std::numeric_limits<size_t>::max()) {
+  for (size_t i = 1; i < threadCount; ++i) {
+    m_workers.emplace_back(&ThreadPool::workerProcedure, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  m_jobs.close();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::getThreadCount() const {
+  return m_workers.size() + 1;
+}
+
+void ThreadPool::post(std::function<void()>&& job) {
+  if (m_workers.empty() || !m_jobs.push(std::move(job))) {
+    job();
+  }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& job) {
+  if (count == 0) {
+    return;
+  }
+
+  if (count == 1 || m_workers.empty()) {
+    for (size_t i = 0; i < count; ++i) {
+      job(i);
+    }
+
+    return;
+  }
+
+  auto state = std::make_shared<ParallelForState>(count, job);
+  size_t helpers = std::min(m_workers.size(), count - 1);
+  for (size_t i = 0; i < helpers; ++i) {
+    m_jobs.push([state] {
+      while (state->runOne()) {
+      }
+    });
+  }
+
+  while (state->runOne()) {
+  }
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->allFinished.wait(lock, [&state] { return state->finished == state->count; });
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+void ThreadPool::workerProcedure() {
+  std::function<void()> job;
+  while (m_jobs.pop(job)) {
+    job();
+    job = nullptr;
+  }
+}
+
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "BlockingQueue.h"
+
+namespace Common {
+
+// Fixed set of worker threads executing posted jobs. The thread count includes the thread calling parallelFor(),
+// so a pool of one thread doesn't start any workers and runs everything in the caller.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threadCount);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t getThreadCount() const;
+
+  // Queue job for execution on one of the workers, runs it in place if there are none.
+  void post(std::function<void()>&& job);
+
+  // Call job(i) for every i in [0, count) and return when all calls are finished. The calling thread takes part in the
+  // work, so it is safe to call from inside a job. The first exception thrown by a job is rethrown here.
+  void parallelFor(size_t count, const std::function<void(size_t)>& job);
+
+private:
+  void workerProcedure();
+
+  BlockingQueue<std::function<void()>> m_jobs;
+  std::vector<std::thread> m_workers;
+};
+
+}
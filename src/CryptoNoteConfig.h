@@ -127,7 +127,14 @@ const uint8_t  BLOCK_MINOR_VERSION_1                         =  1;
 
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  10000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  100;    //by default, blocks count in blocks downloading
+const size_t   BLOCKS_SYNCHRONIZING_MIN_COUNT                =  10;     //batch size of a slow peer never gets below this
+const size_t   BLOCKS_SYNCHRONIZING_MAX_COUNT                =  500;    //nor above this for a fast one
+const size_t   BLOCKS_SYNCHRONIZING_MAX_RESPONSE_SIZE        =  4 * 1024 * 1024; //batch size is cut to keep responses below this
+const uint64_t BLOCKS_SYNCHRONIZING_RESPONSE_TIME            =  3000;   //milliseconds, batch size shrinks if a response takes longer
+const uint64_t BLOCKS_SYNCHRONIZING_REQUEST_TIMEOUT          =  30000;  //milliseconds, a peer not answering a blocks request by then is dropped
+const size_t   BLOCKS_SYNCHRONIZING_MAX_BUFFERED_SIZE        =  64 * 1024 * 1024; //blocks received ahead of the chain top
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
+const size_t   CURRENCY_PROTOCOL_MAX_OBJECT_REQUEST_COUNT    =  500;    //blocks or transactions a peer may request at once
 
 const int      P2P_DEFAULT_PORT                              =  33802;
 const int      RPC_DEFAULT_PORT                              =  33888;
@@ -151,6 +158,19 @@ const uint32_t P2P_DEFAULT_CONNECTION_TIMEOUT                = 5000;          //
 const uint32_t P2P_DEFAULT_PING_CONNECTION_TIMEOUT           = 2000;          // 2 seconds
 const uint64_t P2P_DEFAULT_INVOKE_TIMEOUT                    = 60 * 2 * 1000; // 2 minutes
 const size_t   P2P_DEFAULT_HANDSHAKE_INVOKE_TIMEOUT          = 5000;          // 5 seconds
+const uint32_t P2P_TX_INVENTORY_INTERVAL                     = 250;           // milliseconds
+// Hashes remembered per peer, half of them at least. Covers 30 transactions a second, several times the chain's
+// throughput, over the 240 seconds a transaction may be requested from its announcers in turn. A power of two.
+const size_t   P2P_TX_INVENTORY_KNOWN_LIMIT                  = 16384;
+const uint32_t P2P_TX_REQUEST_TIMEOUT                        = 30;            // seconds
+const size_t   P2P_TX_INVENTORY_MAX_COUNT                    = 10000;         // hashes per announcement
+const size_t   P2P_TX_REQUESTS_LIMIT                         = 50000;         // transactions requested and not received yet
+const size_t   P2P_TX_REQUESTS_PER_PEER_LIMIT                = 5000;
+const size_t   P2P_TX_ANNOUNCERS_LIMIT                       = 8;             // other announcers remembered per transaction
+const size_t   P2P_COMPACT_BLOCKS_PENDING_LIMIT              = 16;            // compact blocks waiting for their transactions
+const size_t   P2P_COMPACT_BLOCKS_PENDING_PER_PEER_LIMIT     = 2;
+const size_t   P2P_COMPACT_BLOCK_ANNOUNCERS_LIMIT            = 8;             // other announcers remembered per compact block
+const uint32_t P2P_BLOCK_TXS_REQUEST_TIMEOUT                 = 10;            // seconds
 const char     P2P_STAT_TRUSTED_PUB_KEY[]                    = "";
 
 const char* const SEED_NODES[] = {
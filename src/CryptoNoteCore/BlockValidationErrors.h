@@ -37,7 +37,9 @@ enum class BlockValidationError {
   CHECKPOINT_BLOCK_HASH_MISMATCH,
   PROOF_OF_WORK_TOO_WEAK,
   NOT_ENOUGH_TRANSACTIONS,
-  TRANSACTION_ABSENT_IN_POOL
+  TRANSACTION_ABSENT_IN_POOL,
+  TRANSACTION_HASH_MISMATCH,
+  CUMULATIVE_FEE_OVERFLOW
 };
 
 // custom category:
@@ -70,6 +72,8 @@ public:
       case BlockValidationError::PROOF_OF_WORK_TOO_WEAK: return "Proof of work is too weak";
       case BlockValidationError::NOT_ENOUGH_TRANSACTIONS: return "New block must have at least one transaction";
       case BlockValidationError::TRANSACTION_ABSENT_IN_POOL: return "Block's transaction is absent in transaction pool";
+      case BlockValidationError::TRANSACTION_HASH_MISMATCH: return "Block's transaction doesn't match its hash";
+      case BlockValidationError::CUMULATIVE_FEE_OVERFLOW: return "Block's cumulative fee overflow";
       default: return "Unknown error";
     }
   }
@@ -97,6 +97,17 @@ void CachedBlockInfo::serialize(ISerializer& s) {
   s(alreadyGeneratedTransactions, "already_generated_transaction_count");
 }
 
+void BlockSummary::serialize(ISerializer& s) {
+  s(timestamp, "timestamp");
+  s(blockSize, "block_size");
+  s(reward, "reward");
+  s(totalFeeAmount, "total_fee_amount");
+  s(transactionCount, "transaction_count");
+  s(difficulty, "difficulty");
+  s(sizeMedian, "size_median");
+  s(penalty, "penalty");
+}
+
 void OutputGlobalIndexesForAmount::serialize(ISerializer& s) {
   s(startIndex, "start_index");
   s(outputs, "outputs");
@@ -489,6 +500,16 @@ std::vector<Crypto::Hash> BlockchainCache::getBlockHashes(uint32_t startBlockInd
   return hashes;
 }
 
+std::map<uint32_t, BlockSummary> BlockchainCache::getBlockSummaries(uint32_t startBlockIndex, size_t maxCount) const {
+  // Only the database cache keeps block summaries, blocks of this segment have none
+  if (startBlockIndex >= startIndex) {
+    return {};
+  }
+
+  assert(parent != nullptr);
+  return parent->getBlockSummaries(startBlockIndex, std::min(maxCount, static_cast<size_t>(startIndex - startBlockIndex)));
+}
+
 IBlockchainCache* BlockchainCache::getParent() const {
   return parent;
 }
@@ -894,6 +915,21 @@ std::vector<Crypto::Hash> BlockchainCache::getBlockHashesByTimestamps(uint64_t t
   return blockHashes;
 }
 
+LookupCacheStatistics BlockchainCache::getLookupCacheStatistics() const {
+  if (parent != nullptr) {
+    return parent->getLookupCacheStatistics();
+  }
+
+  return LookupCacheStatistics();
+}
+
+// Lookups that this segment answers itself never hit the database, the rest is up to the root
+void BlockchainCache::prefetchLookups(const LookupBatch& lookups) const {
+  if (parent != nullptr) {
+    parent->prefetchLookups(lookups);
+  }
+}
+
 ExtractOutputKeysResult BlockchainCache::extractKeyOutputIndexes(uint64_t amount,
                                                                  Common::ArrayView<uint32_t> globalIndexes,
                                                                  std::vector<PackedOutIndex>& outIndexes) const {
@@ -151,6 +151,7 @@ public:
 
   Crypto::Hash getBlockHash(uint32_t blockIndex) const override;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t startIndex, size_t maxCount) const override;
+  virtual std::map<uint32_t, BlockSummary> getBlockSummaries(uint32_t startIndex, size_t maxCount) const override;
 
   virtual IBlockchainCache* getParent() const override;
   virtual void setParent(IBlockchainCache* p) override;
@@ -188,6 +189,8 @@ public:
 
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const override;
+  virtual LookupCacheStatistics getLookupCacheStatistics() const override;
+  virtual void prefetchLookups(const LookupBatch& lookups) const override;
 
 private:
 
@@ -122,6 +122,11 @@ BlockchainReadBatch& BlockchainReadBatch::requestKeyOutputInfo(IBlockchainCache:
   return *this;
 }
 
+BlockchainReadBatch& BlockchainReadBatch::requestBlockSummary(uint32_t blockIndex) {
+  state.blockSummaries.emplace(blockIndex, BlockSummary());
+  return *this;
+}
+
 BlockchainReadResult BlockchainReadBatch::extractResult() {
   assert(resultSubmitted);
   auto st = std::move(state);
@@ -151,6 +156,7 @@ std::vector<std::string> BlockchainReadBatch::getRawKeys() const {
   DB::serializeKeys(rawKeys, DB::PAYMENT_ID_TO_TX_HASH_PREFIX, state.transactionHashesByPaymentIds);
   DB::serializeKeys(rawKeys, DB::TIMESTAMP_TO_BLOCKHASHES_PREFIX, state.blockHashesByTimestamp);
   DB::serializeKeys(rawKeys, DB::KEY_OUTPUT_KEY_PREFIX, state.keyOutputKeys);
+  DB::serializeKeys(rawKeys, DB::BLOCK_INDEX_TO_BLOCK_SUMMARY_PREFIX, state.blockSummaries);
 
   if (state.lastBlockIndex.second) {
     rawKeys.emplace_back(DB::serializeKey(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DB::LAST_BLOCK_INDEX_KEY));
@@ -248,6 +254,10 @@ const KeyOutputKeyResult& BlockchainReadResult::getKeyOutputInfo() const {
   return state.keyOutputKeys;
 }
 
+const std::unordered_map<uint32_t, BlockSummary>& BlockchainReadResult::getBlockSummaries() const {
+  return state.blockSummaries;
+}
+
 void BlockchainReadBatch::submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) {
   assert(state.size() == values.size());
   assert(values.size() == resultStates.size());
@@ -269,6 +279,7 @@ void BlockchainReadBatch::submitRawResult(const std::vector<std::string>& values
   DB::deserializeValues(state.transactionHashesByPaymentIds, iter, DB::PAYMENT_ID_TO_TX_HASH_PREFIX);
   DB::deserializeValues(state.blockHashesByTimestamp, iter, DB::TIMESTAMP_TO_BLOCKHASHES_PREFIX);
   DB::deserializeValues(state.keyOutputKeys, iter, DB::KEY_OUTPUT_KEY_PREFIX);
+  DB::deserializeValues(state.blockSummaries, iter, DB::BLOCK_INDEX_TO_BLOCK_SUMMARY_PREFIX);
 
   DB::deserializeValue(state.lastBlockIndex, iter, DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX);
   DB::deserializeValue(state.keyOutputAmountsCount, iter, DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX);
@@ -291,6 +302,7 @@ keyOutputGlobalIndexesForAmounts(std::move(state.keyOutputGlobalIndexesForAmount
 rawBlocks(std::move(state.rawBlocks)),
 blockHashesByTimestamp(std::move(state.blockHashesByTimestamp)),
 keyOutputKeys(std::move(state.keyOutputKeys)),
+blockSummaries(std::move(state.blockSummaries)),
 closestTimestampBlockIndex(std::move(state.closestTimestampBlockIndex)),
 lastBlockIndex(std::move(state.lastBlockIndex)),
 keyOutputAmountsCount(std::move(state.keyOutputAmountsCount)),
@@ -316,6 +328,7 @@ size_t BlockchainReadState::size() const {
     transactionHashesByPaymentIds.size() +
     blockHashesByTimestamp.size() +
     keyOutputKeys.size() +
+    blockSummaries.size() +
     (lastBlockIndex.second ? 1 : 0) +
     (keyOutputAmountsCount.second ? 1 : 0) +
     (transactionsCount.second ? 1 : 0);
@@ -68,6 +68,7 @@ struct BlockchainReadState {
   std::unordered_map<std::pair<Crypto::Hash, uint32_t>, Crypto::Hash> transactionHashesByPaymentIds;
   std::unordered_map<uint64_t, std::vector<Crypto::Hash>> blockHashesByTimestamp;
   KeyOutputKeyResult keyOutputKeys;
+  std::unordered_map<uint32_t, BlockSummary> blockSummaries;
 
   std::pair<uint32_t, bool> lastBlockIndex = { 0, false };
   std::pair<uint32_t, bool> keyOutputAmountsCount = { {}, false };
@@ -105,6 +106,7 @@ public:
   const std::unordered_map<uint64_t, std::vector<Crypto::Hash> >& getBlockHashesByTimestamp() const;
   const std::pair<uint64_t, bool>& getTransactionsCount() const;
   const KeyOutputKeyResult& getKeyOutputInfo() const;
+  const std::unordered_map<uint32_t, BlockSummary>& getBlockSummaries() const;
 
 private:
   BlockchainReadState state;
@@ -133,6 +135,7 @@ public:
   BlockchainReadBatch& requestBlockHashesByTimestamp(uint64_t timestamp);
   BlockchainReadBatch& requestTransactionsCount();
   BlockchainReadBatch& requestKeyOutputInfo(IBlockchainCache::Amount amount, IBlockchainCache::GlobalOutputIndex globalIndex);
+  BlockchainReadBatch& requestBlockSummary(uint32_t blockIndex);
 
   std::vector<std::string> getRawKeys() const override;
   void submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) override;
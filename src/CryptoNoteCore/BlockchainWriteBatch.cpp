@@ -100,6 +100,11 @@ BlockchainWriteBatch& BlockchainWriteBatch::insertTimestamp(uint64_t timestamp,
   return *this;
 }
 
+BlockchainWriteBatch& BlockchainWriteBatch::insertBlockSummary(uint32_t blockIndex, const BlockSummary& summary) {
+  rawDataToInsert.emplace_back(DB::serialize(DB::BLOCK_INDEX_TO_BLOCK_SUMMARY_PREFIX, blockIndex, summary));
+  return *this;
+}
+
 BlockchainWriteBatch& BlockchainWriteBatch::insertKeyOutputInfo(IBlockchainCache::Amount amount, IBlockchainCache::GlobalOutputIndex globalIndex,
                                                             const KeyOutputInfo& outputInfo) {
   rawDataToInsert.emplace_back(DB::serialize(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(amount, globalIndex), outputInfo));
@@ -171,6 +176,11 @@ BlockchainWriteBatch& BlockchainWriteBatch::removeKeyOutputAmounts(uint32_t keyO
   return *this;
 }
 
+BlockchainWriteBatch& BlockchainWriteBatch::removeBlockSummary(uint32_t blockIndex) {
+  rawKeysToRemove.emplace_back(DB::serializeKey(DB::BLOCK_INDEX_TO_BLOCK_SUMMARY_PREFIX, blockIndex));
+  return *this;
+}
+
 BlockchainWriteBatch&BlockchainWriteBatch::removeKeyOutputInfo(IBlockchainCache::Amount amount, IBlockchainCache::GlobalOutputIndex globalIndex) {
   rawKeysToRemove.emplace_back(DB::serializeKey(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(amount, globalIndex)));
   return *this;
@@ -39,6 +39,7 @@ public:
   BlockchainWriteBatch& insertClosestTimestampBlockIndex(uint64_t timestamp, uint32_t blockIndex);
   BlockchainWriteBatch& insertKeyOutputAmounts(const std::set<IBlockchainCache::Amount>& amounts, uint32_t totalKeyOutputAmountsCount);
   BlockchainWriteBatch& insertTimestamp(uint64_t timestamp, const std::vector<Crypto::Hash>& blockHashes);
+  BlockchainWriteBatch& insertBlockSummary(uint32_t blockIndex, const BlockSummary& summary);
   BlockchainWriteBatch& insertKeyOutputInfo(IBlockchainCache::Amount amount, IBlockchainCache::GlobalOutputIndex globalIndex, const KeyOutputInfo& outputInfo);
 
   BlockchainWriteBatch& removeSpentKeyImages(uint32_t blockIndex, const std::vector<Crypto::KeyImage>& spentKeyImages);
@@ -50,6 +51,7 @@ public:
   BlockchainWriteBatch& removeClosestTimestampBlockIndex(uint64_t timestamp);
   BlockchainWriteBatch& removeTimestamp(uint64_t timestamp);
   BlockchainWriteBatch& removeKeyOutputAmounts(uint32_t keyOutputAmountsToRemoveCount, uint32_t totalKeyOutputAmountsCount);
+  BlockchainWriteBatch& removeBlockSummary(uint32_t blockIndex);
   BlockchainWriteBatch& removeKeyOutputInfo(IBlockchainCache::Amount amount, IBlockchainCache::GlobalOutputIndex globalIndex);
 
   std::vector<std::pair<std::string, std::string>> extractRawDataToInsert() override;
@@ -40,6 +40,7 @@
 #include "CryptoNoteCore/UpgradeManager.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h"
 
+#include <System/InterruptedException.h>
 #include <System/Timer.h>
 
 #include "TransactionApi.h"
@@ -118,6 +119,22 @@ Crypto::Hash getBlockHash(const RawBlock& block) {
   return CachedBlock(blockTemplate).getBlockHash();
 }
 
+// Everything validateTransactionInputs looks up in the blockchain for the inputs of the transaction
+void collectLookups(const CachedTransaction& transaction, LookupBatch& lookups) {
+  for (const auto& input : transaction.getTransaction().inputs) {
+    if (input.type() == typeid(KeyInput)) {
+      const KeyInput& in = boost::get<KeyInput>(input);
+      lookups.keyImages.push_back(in.keyImage);
+
+      uint32_t globalIndex = 0;
+      for (auto offset : in.outputIndexes) {
+        globalIndex += offset;
+        lookups.keyOutputs.emplace_back(in.amount, globalIndex);
+      }
+    }
+  }
+}
+
 TransactionValidatorState extractSpentOutputs(const CachedTransaction& transaction) {
   TransactionValidatorState spentOutputs;
   const auto& cryptonoteTransaction = transaction.getTransaction();
@@ -184,6 +201,7 @@ uint32_t findCommonRoot(IMainChainStorage& storage, IBlockchainCache& rootSegmen
 }
 
 const std::chrono::seconds OUTDATED_TRANSACTION_POLLING_INTERVAL = std::chrono::seconds(60);
+const size_t RING_SIGNATURE_CACHE_GENERATION_SIZE = 100000;
 
 }
 
@@ -191,7 +209,8 @@ Core::Core(const Currency& currency, Logging::ILogger& logger, Checkpoints&& che
            std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainchainStorage)
     : currency(currency), dispatcher(dispatcher), contextGroup(dispatcher), logger(logger, "Core"), checkpoints(std::move(checkpoints)),
       upgradeManager(new UpgradeManager()), blockchainCacheFactory(std::move(blockchainCacheFactory)),
-      mainChainStorage(std::move(mainchainStorage)), initialized(false) {
+      mainChainStorage(std::move(mainchainStorage)), initialized(false), poolTransactionSizeBound(0), threadPool(nullptr),
+      writerActive(false) {
 
   upgradeManager->addMajorBlockVersion(BLOCK_MAJOR_VERSION_2, currency.upgradeHeight(BLOCK_MAJOR_VERSION_2));
   upgradeManager->addMajorBlockVersion(BLOCK_MAJOR_VERSION_3, currency.upgradeHeight(BLOCK_MAJOR_VERSION_3));
@@ -358,6 +377,29 @@ void Core::getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<R
   }
 }
 
+void Core::getBlockViews(const std::vector<Crypto::Hash>& blockHashes, std::vector<RawBlockView>& blocks,
+                         std::vector<Crypto::Hash>& missedHashes) const {
+  throwIfNotInitialized();
+
+  for (const auto& hash : blockHashes) {
+    IBlockchainCache* blockchainSegment = findSegmentContainingBlock(hash);
+    if (blockchainSegment == nullptr) {
+      missedHashes.push_back(hash);
+      continue;
+    }
+
+    uint32_t blockIndex = blockchainSegment->getBlockIndex(hash);
+    assert(blockIndex <= blockchainSegment->getTopBlockIndex());
+
+    // The main chain storage holds every block of the main chain at its own index
+    if (mainChainSet.count(blockchainSegment) != 0) {
+      blocks.push_back(mainChainStorage->getBlockViewByIndex(blockIndex));
+    } else {
+      blocks.push_back(RawBlockView::fromRawBlock(blockchainSegment->getBlockByIndex(blockIndex)));
+    }
+  }
+}
+
 void Core::copyTransactionsToPool(IBlockchainCache* alt) {
   assert(alt != nullptr);
   while (alt != nullptr) {
@@ -365,7 +407,7 @@ void Core::copyTransactionsToPool(IBlockchainCache* alt) {
       break;
     auto transactions = alt->getRawTransactions(alt->getTransactionHashes());
     for (auto& transaction : transactions) {
-      if (addTransactionToPool(std::move(transaction))) {
+      if (addSerializedTransactionToPool(transaction)) {
         // TODO: send notification
       }
     }
@@ -406,8 +448,8 @@ bool Core::queryBlocks(const std::vector<Crypto::Hash>& blockHashes, uint64_t ti
   }
 }
 
-bool Core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockHashes, uint64_t timestamp, uint32_t& startIndex,
-                           uint32_t& currentIndex, uint32_t& fullOffset, std::vector<BlockShortInfo>& entries) const {
+bool Core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockHashes, uint64_t timestamp, bool includeGlobalIndexes,
+                           uint32_t& startIndex, uint32_t& currentIndex, uint32_t& fullOffset, std::vector<BlockShortInfo>& entries) const {
   assert(entries.empty());
   assert(!chainsLeaves.empty());
   assert(!chainsStorage.empty());
@@ -444,7 +486,7 @@ bool Core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockHashes, ui
       return true;
     }
 
-    fillQueryBlockShortInfo(fullOffset, currentIndex, BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, entries);
+    fillQueryBlockShortInfo(fullOffset, currentIndex, BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, includeGlobalIndexes, entries);
 
     return true;
   } catch (std::exception& e) {
@@ -555,6 +597,10 @@ Difficulty Core::getDifficultyForNextBlock() const {
   return currency.nextDifficulty(nextBlockMajorVersion, topBlockIndex, timestamps, difficulties);
 }
 
+bool Core::isInCheckpointZone(uint32_t blockIndex) const {
+  return checkpoints.isInCheckpointZone(blockIndex);
+}
+
 std::vector<Crypto::Hash> Core::findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds,
                                                          size_t maxCount, uint32_t& totalBlockCount,
                                                          uint32_t& startBlockIndex) const {
@@ -569,7 +615,13 @@ std::vector<Crypto::Hash> Core::findBlockchainSupplement(const std::vector<Crypt
 }
 
 std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock) {
+  return addBlock(cachedBlock, std::move(rawBlock), std::vector<CachedTransaction>());
+}
+
+std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock, std::vector<CachedTransaction>&& transactions) {
   throwIfNotInitialized();
+  WriteLock lock(*this);
+
   uint32_t blockIndex = cachedBlock.getBlockIndex();
   Crypto::Hash blockHash = cachedBlock.getBlockHash();
   std::ostringstream os;
@@ -593,11 +645,23 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
     return error::AddBlockErrorCode::REJECTED_AS_ORPHANED;
   }
 
-  std::vector<CachedTransaction> transactions;
   uint64_t cumulativeSize = 0;
-  if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize)) {
-    logger(Logging::DEBUGGING) << "Couldn't deserialize raw block transactions in block " << blockStr;
-    return error::AddBlockErrorCode::DESERIALIZATION_FAILED;
+  if (!rawBlock.transactions.empty() && transactions.size() == rawBlock.transactions.size()) {
+    for (const auto& rawTransaction : rawBlock.transactions) {
+      if (rawTransaction.size() > currency.maxTxSize()) {
+        logger(Logging::INFO) << "Raw transaction size " << rawTransaction.size() << " is too big.";
+        logger(Logging::DEBUGGING) << "Couldn't deserialize raw block transactions in block " << blockStr;
+        return error::AddBlockErrorCode::DESERIALIZATION_FAILED;
+      }
+
+      cumulativeSize += rawTransaction.size();
+    }
+  } else {
+    transactions.clear();
+    if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize)) {
+      logger(Logging::DEBUGGING) << "Couldn't deserialize raw block transactions in block " << blockStr;
+      return error::AddBlockErrorCode::DESERIALIZATION_FAILED;
+    }
   }
 
   auto coinbaseTransactionSize = getObjectBinarySize(blockTemplate.baseTransaction);
@@ -607,6 +671,18 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
   auto previousBlockIndex = cache->getBlockIndex(previousBlockHash);
 
+  // Blocks in the checkpoint zone skip the proof of work, reject one not matching its checkpoint before anything else
+  bool isCheckpointed = checkpoints.isInCheckpointZone(previousBlockIndex + 1);
+  bool isCheckpoint = false;
+  if (isCheckpointed && !checkpoints.checkBlock(previousBlockIndex + 1, cachedBlock.getBlockHash(), isCheckpoint)) {
+    logger(Logging::WARNING) << "Checkpoint block hash mismatch for block " << blockStr;
+    return error::BlockValidationError::CHECKPOINT_BLOCK_HASH_MISMATCH;
+  }
+
+  // Only a block whose own hash was just verified against a checkpoint has its transactions committed to, nothing has
+  // verified the blocks between two checkpoints yet when they arrive, so they get the full transaction checks
+  bool isVerifiedByCheckpoint = isCheckpointed && isCheckpoint;
+
   bool addOnTop = cache->getTopBlockIndex() == previousBlockIndex;
   auto maxBlockCumulativeSize = currency.maxBlockCumulativeSize(previousBlockIndex + 1);
   if (cumulativeBlockSize > maxBlockCumulativeSize) {
@@ -633,25 +709,27 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
   }
 
   uint64_t cumulativeFee = 0;
-  for (const auto& transaction : transactions) {
-    uint64_t fee = 0;
-    auto transactionValidationResult = validateTransaction(transaction, validatorState, cache, fee, previousBlockIndex);
-    if (transactionValidationResult) {
-      const auto hash = transaction.getTransactionHash();
+  size_t failedTransactionIndex = 0;
+  std::error_code transactionValidationResult;
+  if (isVerifiedByCheckpoint) {
+    transactionValidationResult = validateCheckpointedTransactions(blockTemplate, transactions, validatorState, cumulativeFee, failedTransactionIndex);
+  } else {
+    transactionValidationResult = validateBlockTransactions(transactions, validatorState, cache, previousBlockIndex, cumulativeFee, failedTransactionIndex);
+  }
 
-      logger(Logging::DEBUGGING) << "Failed to validate transaction " << hash << ": " << transactionValidationResult.message();
+  if (transactionValidationResult) {
+    const auto hash = transactions[failedTransactionIndex].getTransactionHash();
 
-      if (transactionPool->checkIfTransactionPresent(hash))
-      {
-        logger(Logging::DEBUGGING) << "Removing invalid transaction " << hash << " from transaction pool...";
-        transactionPool->removeTransaction(hash);
-        notifyObservers(makeDelTransactionMessage({hash}, Messages::DeleteTransaction::Reason::NotActual));
-      }
+    logger(Logging::DEBUGGING) << "Failed to validate transaction " << hash << ": " << transactionValidationResult.message();
 
-      return transactionValidationResult;
+    if (transactionPool->checkIfTransactionPresent(hash))
+    {
+      logger(Logging::DEBUGGING) << "Removing invalid transaction " << hash << " from transaction pool...";
+      transactionPool->removeTransaction(hash);
+      notifyObservers(makeDelTransactionMessage({hash}, Messages::DeleteTransaction::Reason::NotActual));
     }
 
-    cumulativeFee += fee;
+    return transactionValidationResult;
   }
 
   uint64_t reward = 0;
@@ -672,12 +750,7 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
     return error::BlockValidationError::BLOCK_REWARD_MISMATCH;
   }
 
-  if (checkpoints.isInCheckpointZone(cachedBlock.getBlockIndex())) {
-    if (!checkpoints.checkBlock(cachedBlock.getBlockIndex(), cachedBlock.getBlockHash())) {
-      logger(Logging::WARNING) << "Checkpoint block hash mismatch for block " << blockStr;
-      return error::BlockValidationError::CHECKPOINT_BLOCK_HASH_MISMATCH;
-    }
-  } else if (!currency.checkProofOfWork(cachedBlock, currentDifficulty)) {
+  if (!isCheckpointed && !currency.checkProofOfWork(cachedBlock, currentDifficulty)) {
     logger(Logging::WARNING) << "Proof of work too weak for block " << blockStr;
     return error::BlockValidationError::PROOF_OF_WORK_TOO_WEAK;
   }
@@ -718,8 +791,13 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
           std::swap(chainsLeaves[0], chainsLeaves[endpointIndex]);
           updateMainChainSet();
 
+          uint32_t splitBlockIndex = chainsLeaves[endpointIndex]->getStartBlockIndex();
+          for (auto segment = chainsLeaves[endpointIndex]; mainChainSet.count(segment) == 0; segment = segment->getParent()) {
+            splitBlockIndex = segment->getStartBlockIndex();
+          }
+
           updateBlockMedianSize();
-          actualizePoolTransactions();
+          actualizePoolTransactions(splitBlockIndex);
           copyTransactionsToPool(chainsLeaves[endpointIndex]);
 
           switchMainChainStorage(chainsLeaves[0]->getStartBlockIndex(), *chainsLeaves[0]);
@@ -787,32 +865,106 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
   return ret;
 }
 
-void Core::actualizePoolTransactions() {
+// Blocks below splitBlockIndex are shared by the old and the new main chain. Transactions referencing only outputs from
+// them keep valid ring signatures, so they go through the checks depending on the chain state alone. The others are
+// validated in full.
+void Core::actualizePoolTransactions(uint32_t splitBlockIndex) {
   auto& pool = *transactionPool;
   auto hashes = pool.getTransactionHashes();
+  IBlockchainCache* mainChain = chainsLeaves[0];
+
+  if (!checkpoints.isInCheckpointZone(getTopBlockIndex() + 1)) {
+    LookupBatch lookups;
+    for (auto& hash : hashes) {
+      collectLookups(pool.getTransaction(hash), lookups);
+    }
+
+    mainChain->prefetchLookups(lookups);
+  }
+
+  // Segments count outputs from their own start only
+  IBlockchainCache* splitSegment = mainChain;
+  while (splitSegment->getStartBlockIndex() > splitBlockIndex) {
+    splitSegment = splitSegment->getParent();
+  }
+
+  std::unordered_map<uint64_t, size_t> sharedOutputsCounts;
+  auto referencesNewOutputs = [&](const CachedTransaction& transaction) {
+    for (const auto& input : transaction.getTransaction().inputs) {
+      if (input.type() != typeid(KeyInput)) {
+        continue;
+      }
+
+      const KeyInput& in = boost::get<KeyInput>(input);
+      auto it = sharedOutputsCounts.find(in.amount);
+      if (it == sharedOutputsCounts.end()) {
+        it = sharedOutputsCounts.emplace(in.amount, splitSegment->getKeyOutputsCountForAmount(in.amount, splitBlockIndex)).first;
+      }
+
+      uint64_t globalIndex = 0;
+      for (auto offset : in.outputIndexes) {
+        globalIndex += offset;
+      }
+
+      if (globalIndex >= it->second) {
+        return true;
+      }
+    }
+
+    return false;
+  };
 
+  auto maxTransactionSize = getMaximumTransactionSize();
+  poolTransactionSizeBound = 0;
   for (auto& hash : hashes) {
-    auto tx = pool.getTransaction(hash);
-    pool.removeTransaction(hash);
+    const auto& transaction = pool.getTransaction(hash);
+    if (referencesNewOutputs(transaction)) {
+      auto tx = transaction;
+      pool.removeTransaction(hash);
+
+      if (!addTransactionToPool(std::move(tx))) {
+        notifyObservers(makeDelTransactionMessage({hash}, Messages::DeleteTransaction::Reason::NotActual));
+      }
+
+      continue;
+    }
 
-    if (!addTransactionToPool(std::move(tx))) {
+    TransactionValidatorState state;
+    uint64_t fee = 0;
+    std::vector<RingSignatureCheck> signatureChecks;
+    auto error = validateTransactionInputs(transaction, 0, state, mainChain, fee, getTopBlockIndex(), signatureChecks);
+    auto size = transaction.getTransactionBinaryArray().size();
+    if (error || size > maxTransactionSize) {
+      logger(Logging::DEBUGGING) << "Transaction " << hash << " is not valid on the new main chain";
+      pool.removeTransaction(hash);
       notifyObservers(makeDelTransactionMessage({hash}, Messages::DeleteTransaction::Reason::NotActual));
+    } else {
+      poolTransactionSizeBound = std::max(poolTransactionSizeBound, size);
     }
   }
 }
 
 void Core::actualizePoolTransactionsLite(const TransactionValidatorState& validatorState) {
   auto& pool = *transactionPool;
-  auto hashes = pool.getTransactionHashes();
 
-  for (auto& hash : hashes) {
-    auto tx = pool.getTransaction(hash);
+  for (auto& hash : pool.getConflictingTransactionHashes(validatorState)) {
+    pool.removeTransaction(hash);
+    notifyObservers(makeDelTransactionMessage({ hash }, Messages::DeleteTransaction::Reason::NotActual));
+  }
 
-    auto txState = extractSpentOutputs(tx);
+  auto maxTransactionSize = getMaximumTransactionSize();
+  if (poolTransactionSizeBound <= maxTransactionSize) {
+    return;
+  }
 
-    if (hasIntersections(validatorState, txState) || tx.getTransactionBinaryArray().size() > getMaximumTransactionSize()) {
+  poolTransactionSizeBound = 0;
+  for (auto& hash : pool.getTransactionHashes()) {
+    auto size = pool.getTransaction(hash).getTransactionBinaryArray().size();
+    if (size > maxTransactionSize) {
       pool.removeTransaction(hash);
       notifyObservers(makeDelTransactionMessage({ hash }, Messages::DeleteTransaction::Reason::NotActual));
+    } else {
+      poolTransactionSizeBound = std::max(poolTransactionSizeBound, size);
     }
   }
 }
@@ -958,6 +1110,108 @@ bool Core::getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_
 bool Core::addTransactionToPool(const BinaryArray& transactionBinaryArray) {
   throwIfNotInitialized();
 
+  WriteLock lock(*this);
+  return addSerializedTransactionToPool(transactionBinaryArray);
+}
+
+std::vector<bool> Core::addTransactionsToPool(const std::vector<BinaryArray>& transactionBinaryArrays) {
+  throwIfNotInitialized();
+
+  std::vector<boost::optional<CachedTransaction>> transactions(transactionBinaryArrays.size());
+  auto parseTransaction = [&] (size_t i) {
+    Transaction transaction;
+    if (fromBinaryArray<Transaction>(transaction, transactionBinaryArrays[i])) {
+      transactions[i] = CachedTransaction(std::move(transaction));
+      transactions[i]->getTransactionHash();
+      transactions[i]->getTransactionPrefixHash();
+      transactions[i]->getTransactionFee();
+    }
+  };
+
+  if (threadPool != nullptr) {
+    threadPool->parallelFor(transactions.size(), parseTransaction);
+  } else {
+    for (size_t i = 0; i < transactions.size(); ++i) {
+      parseTransaction(i);
+    }
+  }
+
+  // Only the dispatcher modifies the chain and the pool, so they are read without blocking the readers until the
+  // transactions are pushed
+  uint32_t blockIndex = getTopBlockIndex();
+  Crypto::Hash topBlockHash = getTopBlockHash();
+  if (!checkpoints.isInCheckpointZone(blockIndex + 1)) {
+    LookupBatch lookups;
+    for (const auto& transaction : transactions) {
+      if (transaction) {
+        collectLookups(*transaction, lookups);
+      }
+    }
+
+    chainsLeaves[0]->prefetchLookups(lookups);
+  }
+
+  std::vector<bool> added(transactions.size(), false);
+  std::vector<TransactionValidatorState> validatorStates(transactions.size());
+  std::vector<RingSignatureCheck> signatureChecks;
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    if (!transactions[i]) {
+      logger(Logging::WARNING) << "Couldn't add transaction to pool due to deserialization error";
+      continue;
+    }
+
+    auto checkCount = signatureChecks.size();
+    added[i] = checkTransactionForPool(*transactions[i], i, validatorStates[i], signatureChecks);
+    if (!added[i]) {
+      signatureChecks.erase(signatureChecks.begin() + checkCount, signatureChecks.end());
+    }
+  }
+
+  std::vector<uint8_t> validSignatures;
+  verifyRingSignatures(signatureChecks, blockIndex, validSignatures);
+  for (size_t i = 0; i < signatureChecks.size(); ++i) {
+    auto transactionIndex = signatureChecks[i].transactionIndex;
+    if (validSignatures[i] == 0 && added[transactionIndex]) {
+      std::error_code error = error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+      logger(Logging::DEBUGGING) << "Transaction " << transactions[transactionIndex]->getTransactionHash()
+        << " is not valid. Reason: " << error.message();
+      added[transactionIndex] = false;
+    }
+  }
+
+  std::vector<Crypto::Hash> addedHashes;
+  {
+    WriteLock lock(*this);
+    // Other contexts run while the lock is awaited, a block added meanwhile may spend the same outputs
+    bool chainChanged = getTopBlockHash() != topBlockHash;
+    for (size_t i = 0; i < transactions.size(); ++i) {
+      if (!added[i]) {
+        continue;
+      }
+
+      if (chainChanged) {
+        validatorStates[i] = TransactionValidatorState();
+        added[i] = isTransactionValidForPool(*transactions[i], validatorStates[i]);
+      } else {
+        added[i] = isFusionTransactionAllowed(*transactions[i]);
+      }
+
+      auto transactionHash = transactions[i]->getTransactionHash();
+      added[i] = added[i] && pushTransactionToPool(std::move(*transactions[i]), std::move(validatorStates[i]));
+      if (added[i]) {
+        addedHashes.push_back(transactionHash);
+      }
+    }
+  }
+
+  if (!addedHashes.empty()) {
+    notifyObservers(makeAddTransactionMessage(std::move(addedHashes)));
+  }
+
+  return added;
+}
+
+bool Core::addSerializedTransactionToPool(const BinaryArray& transactionBinaryArray) {
   Transaction transaction;
   if (!fromBinaryArray<Transaction>(transaction, transactionBinaryArray)) {
     logger(Logging::WARNING) << "Couldn't add transaction to pool due to deserialization error";
@@ -982,19 +1236,40 @@ bool Core::addTransactionToPool(CachedTransaction&& cachedTransaction) {
     return false;
   }
 
+  return pushTransactionToPool(std::move(cachedTransaction), std::move(validatorState));
+}
+
+bool Core::pushTransactionToPool(CachedTransaction&& cachedTransaction, TransactionValidatorState&& validatorState) {
   auto transactionHash = cachedTransaction.getTransactionHash();
+  auto transactionSize = cachedTransaction.getTransactionBinaryArray().size();
   if (!transactionPool->pushTransaction(std::move(cachedTransaction), std::move(validatorState))) {
     logger(Logging::DEBUGGING) << "Failed to push transaction " << transactionHash << " to pool, already exists";
     return false;
   }
 
+  poolTransactionSizeBound = std::max(poolTransactionSizeBound, transactionSize);
   logger(Logging::DEBUGGING) << "Transaction " << transactionHash << " has been added to pool";
   return true;
 }
 
 bool Core::isTransactionValidForPool(const CachedTransaction& cachedTransaction, TransactionValidatorState& validatorState) {
-  uint64_t fee;
+  std::vector<RingSignatureCheck> signatureChecks;
+  if (!isFusionTransactionAllowed(cachedTransaction) || !checkTransactionForPool(cachedTransaction, 0, validatorState, signatureChecks)) {
+    return false;
+  }
+
+  size_t failedTransactionIndex;
+  if (!checkRingSignatures(signatureChecks, getTopBlockIndex(), failedTransactionIndex)) {
+    std::error_code error = error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+    logger(Logging::DEBUGGING) << "Transaction " << cachedTransaction.getTransactionHash()
+      << " is not valid. Reason: " << error.message();
+    return false;
+  }
+
+  return true;
+}
 
+bool Core::isFusionTransactionAllowed(const CachedTransaction& cachedTransaction) const {
   /* If there are already a certain number of fusion transactions in the pool, then do not try to add another */
   if (cachedTransaction.getTransactionFee() == 0 && transactionPool->getFusionTransactionCount() >= CryptoNote::parameters::FUSION_TX_MAX_POOL_COUNT)
   {
@@ -1002,7 +1277,13 @@ bool Core::isTransactionValidForPool(const CachedTransaction& cachedTransaction,
     return false;
   }
 
-  if (auto validationResult = validateTransaction(cachedTransaction, validatorState, chainsLeaves[0], fee, getTopBlockIndex())) {
+  return true;
+}
+
+bool Core::checkTransactionForPool(const CachedTransaction& cachedTransaction, size_t transactionIndex, TransactionValidatorState& validatorState,
+                                   std::vector<RingSignatureCheck>& signatureChecks) {
+  uint64_t fee;
+  if (auto validationResult = validateTransactionInputs(cachedTransaction, transactionIndex, validatorState, chainsLeaves[0], fee, getTopBlockIndex(), signatureChecks)) {
     logger(Logging::DEBUGGING) << "Transaction " << cachedTransaction.getTransactionHash()
       << " is not valid. Reason: " << validationResult.message();
     return false;
@@ -1032,6 +1313,19 @@ std::vector<Crypto::Hash> Core::getPoolTransactionHashes() const {
   return transactionPool->getTransactionHashes();
 }
 
+void Core::getPoolTransactions(const std::vector<Crypto::Hash>& transactionHashes, std::vector<BinaryArray>& transactions,
+                               std::vector<Crypto::Hash>& missedHashes) const {
+  throwIfNotInitialized();
+
+  for (const auto& hash : transactionHashes) {
+    if (transactionPool->checkIfTransactionPresent(hash)) {
+      transactions.push_back(transactionPool->getTransaction(hash).getTransactionBinaryArray());
+    } else {
+      missedHashes.push_back(hash);
+    }
+  }
+}
+
 bool Core::getPoolChanges(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes,
                           std::vector<BinaryArray>& addedTransactions,
                           std::vector<Crypto::Hash>& deletedTransactions) const {
@@ -1139,7 +1433,19 @@ bool Core::getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, c
 
   size_t transactionsSize;
   uint64_t fee;
-  fillBlockTemplate(b, medianSize, currency.maxBlockCumulativeSize(height), transactionsSize, fee);
+  {
+    std::lock_guard<std::mutex> lock(blockTemplateMutex);
+    uint64_t poolVersion = transactionPool->getVersion();
+    if (!blockTemplateTransactions || blockTemplateTransactions->previousBlockHash != b.previousBlockHash ||
+        blockTemplateTransactions->poolVersion != poolVersion) {
+      fillBlockTemplate(b, medianSize, currency.maxBlockCumulativeSize(height), transactionsSize, fee);
+      blockTemplateTransactions = BlockTemplateTransactions{b.previousBlockHash, poolVersion, b.transactionHashes, transactionsSize, fee};
+    } else {
+      b.transactionHashes = blockTemplateTransactions->transactionHashes;
+      transactionsSize = blockTemplateTransactions->transactionsSize;
+      fee = blockTemplateTransactions->fee;
+    }
+  }
 
   /*
      two-phase miner transaction generation: we don't know exact block size until we prepare block, but we don't know
@@ -1174,19 +1480,21 @@ bool Core::getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, c
     if (coinbaseBlobSize < cumulativeSize - transactionsSize) {
       size_t delta = cumulativeSize - transactionsSize - coinbaseBlobSize;
       b.baseTransaction.extra.insert(b.baseTransaction.extra.end(), delta, 0);
+      coinbaseBlobSize = getObjectBinarySize(b.baseTransaction);
       // here  could be 1 byte difference, because of extra field counter is varint, and it can become from 1-byte len
       // to 2-bytes len.
-      if (cumulativeSize != transactionsSize + getObjectBinarySize(b.baseTransaction)) {
-        if (!(cumulativeSize + 1 == transactionsSize + getObjectBinarySize(b.baseTransaction))) {
+      if (cumulativeSize != transactionsSize + coinbaseBlobSize) {
+        if (!(cumulativeSize + 1 == transactionsSize + coinbaseBlobSize)) {
           logger(Logging::ERROR, Logging::BRIGHT_RED)
               << "unexpected case: cumulative_size=" << cumulativeSize
               << " + 1 is not equal txs_cumulative_size=" << transactionsSize
-              << " + get_object_blobsize(b.baseTransaction)=" << getObjectBinarySize(b.baseTransaction);
+              << " + get_object_blobsize(b.baseTransaction)=" << coinbaseBlobSize;
           return false;
         }
 
         b.baseTransaction.extra.resize(b.baseTransaction.extra.size() - 1);
-        if (cumulativeSize != transactionsSize + getObjectBinarySize(b.baseTransaction)) {
+        coinbaseBlobSize = getObjectBinarySize(b.baseTransaction);
+        if (cumulativeSize != transactionsSize + coinbaseBlobSize) {
           // fuck, not lucky, -1 makes varint-counter size smaller, in that case we continue to grow with
           // cumulative_size
           logger(Logging::TRACE, Logging::BRIGHT_RED)
@@ -1199,11 +1507,11 @@ bool Core::getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, c
             << "Setting extra for block: " << b.baseTransaction.extra.size() << ", try_count=" << tryCount;
       }
     }
-    if (!(cumulativeSize == transactionsSize + getObjectBinarySize(b.baseTransaction))) {
+    if (!(cumulativeSize == transactionsSize + coinbaseBlobSize)) {
       logger(Logging::ERROR, Logging::BRIGHT_RED)
           << "unexpected case: cumulative_size=" << cumulativeSize
           << " is not equal txs_cumulative_size=" << transactionsSize
-          << " + get_object_blobsize(b.baseTransaction)=" << getObjectBinarySize(b.baseTransaction);
+          << " + get_object_blobsize(b.baseTransaction)=" << coinbaseBlobSize;
       return false;
     }
 
@@ -1230,6 +1538,11 @@ CoreStatistics Core::getCoreStatistics() const {
   return result;
 }
 
+LookupCacheStatistics Core::getLookupCacheStatistics() const {
+  throwIfNotInitialized();
+  return chainsLeaves[0]->getLookupCacheStatistics();
+}
+
 size_t Core::getPoolTransactionCount() const {
   throwIfNotInitialized();
   return transactionPool->getTransactionCount();
@@ -1329,11 +1642,11 @@ bool Core::extractTransactions(const std::vector<BinaryArray>& rawTransactions,
   return true;
 }
 
-std::error_code Core::validateTransaction(const CachedTransaction& cachedTransaction, TransactionValidatorState& state,
-                                          IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex) {
-  // TransactionValidatorState currentState;
+std::error_code Core::validateTransactionInputs(const CachedTransaction& cachedTransaction, size_t transactionIndex,
+                                                TransactionValidatorState& state, IBlockchainCache* cache, uint64_t& fee,
+                                                uint32_t blockIndex, std::vector<RingSignatureCheck>& signatureChecks) {
   const auto& transaction = cachedTransaction.getTransaction();
-auto error = validateSemantic(transaction, fee, blockIndex);
+  auto error = validateSemantic(transaction, fee, blockIndex);
   if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
     return error;
   }
@@ -1373,14 +1686,9 @@ auto error = validateSemantic(transaction, fee, blockIndex);
           return error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT;
         }
 
-        std::vector<const Crypto::PublicKey*> outputKeyPointers;
-        outputKeyPointers.reserve(outputKeys.size());
-        std::for_each(outputKeys.begin(), outputKeys.end(), [&outputKeyPointers] (const Crypto::PublicKey& key) { outputKeyPointers.push_back(&key); });
-        if (!Crypto::check_ring_signature(cachedTransaction.getTransactionPrefixHash(), in.keyImage, outputKeyPointers.data(),
-                                          outputKeyPointers.size(), transaction.signatures[inputIndex].data(),
-                                          blockIndex > parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX)) {
-          return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
-        }
+        // Prefix hash is cached lazily, compute it here so signature checks only read it
+        cachedTransaction.getTransactionPrefixHash();
+        signatureChecks.push_back({&cachedTransaction, transactionIndex, inputIndex, std::move(outputKeys)});
       }
 
     } else {
@@ -1394,6 +1702,177 @@ auto error = validateSemantic(transaction, fee, blockIndex);
   return error::TransactionValidationError::VALIDATION_SUCCESS;
 }
 
+std::error_code Core::validateBlockTransactions(const std::vector<CachedTransaction>& transactions, TransactionValidatorState& state,
+                                                IBlockchainCache* cache, uint32_t blockIndex, uint64_t& cumulativeFee,
+                                                size_t& failedTransactionIndex) {
+  if (!checkpoints.isInCheckpointZone(blockIndex + 1)) {
+    LookupBatch lookups;
+    for (const auto& transaction : transactions) {
+      collectLookups(transaction, lookups);
+    }
+
+    cache->prefetchLookups(lookups);
+  }
+
+  std::error_code error = error::TransactionValidationError::VALIDATION_SUCCESS;
+  std::vector<RingSignatureCheck> signatureChecks;
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    uint64_t fee = 0;
+    error = validateTransactionInputs(transactions[i], i, state, cache, fee, blockIndex, signatureChecks);
+    if (error) {
+      failedTransactionIndex = i;
+      break;
+    }
+
+    cumulativeFee += fee;
+  }
+
+  // Stateful checks stop at the first failure, so every collected signature comes before it and a bad one takes precedence
+  if (!checkRingSignatures(signatureChecks, blockIndex, failedTransactionIndex)) {
+    return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+  }
+
+  return error;
+}
+
+// The checkpoint hash commits to the transaction hashes listed in the block, so once the transactions are known to match
+// them only the spent key images and the fee are needed. The sums are still checked, the fee goes into the reward check.
+std::error_code Core::validateCheckpointedTransactions(const BlockTemplate& block, const std::vector<CachedTransaction>& transactions,
+                                                       TransactionValidatorState& state, uint64_t& cumulativeFee,
+                                                       size_t& failedTransactionIndex) {
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    failedTransactionIndex = i;
+    if (transactions[i].getTransactionHash() != block.transactionHashes[i]) {
+      return error::BlockValidationError::TRANSACTION_HASH_MISMATCH;
+    }
+
+    const auto& transaction = transactions[i].getTransaction();
+    uint64_t inputAmount = 0;
+    for (const auto& input : transaction.inputs) {
+      if (input.type() != typeid(KeyInput)) {
+        return error::TransactionValidationError::INPUT_UNKNOWN_TYPE;
+      }
+
+      const KeyInput& in = boost::get<KeyInput>(input);
+      if (!state.spentKeyImages.insert(in.keyImage).second) {
+        return error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
+      }
+
+      if (std::numeric_limits<uint64_t>::max() - in.amount < inputAmount) {
+        return error::TransactionValidationError::INPUTS_AMOUNT_OVERFLOW;
+      }
+
+      inputAmount += in.amount;
+    }
+
+    uint64_t outputAmount = 0;
+    for (const auto& output : transaction.outputs) {
+      if (std::numeric_limits<uint64_t>::max() - output.amount < outputAmount) {
+        return error::TransactionValidationError::OUTPUTS_AMOUNT_OVERFLOW;
+      }
+
+      outputAmount += output.amount;
+    }
+
+    if (outputAmount > inputAmount) {
+      return error::TransactionValidationError::WRONG_AMOUNT;
+    }
+
+    uint64_t fee = inputAmount - outputAmount;
+    if (std::numeric_limits<uint64_t>::max() - fee < cumulativeFee) {
+      return error::BlockValidationError::CUMULATIVE_FEE_OVERFLOW;
+    }
+
+    cumulativeFee += fee;
+  }
+
+  return error::TransactionValidationError::VALIDATION_SUCCESS;
+}
+
+bool Core::checkRingSignatures(const std::vector<RingSignatureCheck>& signatureChecks, uint32_t blockIndex, size_t& failedTransactionIndex) const {
+  std::vector<uint8_t> valid;
+  verifyRingSignatures(signatureChecks, blockIndex, valid);
+
+  auto invalid = std::find(valid.begin(), valid.end(), 0);
+  if (invalid != valid.end()) {
+    failedTransactionIndex = signatureChecks[std::distance(valid.begin(), invalid)].transactionIndex;
+    return false;
+  }
+
+  return true;
+}
+
+void Core::verifyRingSignatures(const std::vector<RingSignatureCheck>& signatureChecks, uint32_t blockIndex, std::vector<uint8_t>& valid) const {
+  valid.assign(signatureChecks.size(), 0);
+  bool checkKeyImage = blockIndex > parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX;
+
+  // Transaction hashes are computed lazily, so the keys are built here rather than on the pool threads
+  std::vector<Crypto::Hash> cacheKeys;
+  cacheKeys.reserve(signatureChecks.size());
+  BinaryArray keyData;
+  for (const auto& check : signatureChecks) {
+    const auto& transactionHash = check.transaction->getTransactionHash();
+    uint32_t inputIndex = static_cast<uint32_t>(check.inputIndex);
+    keyData.clear();
+    keyData.insert(keyData.end(), transactionHash.data, transactionHash.data + sizeof(transactionHash.data));
+    keyData.insert(keyData.end(), reinterpret_cast<const uint8_t*>(&inputIndex), reinterpret_cast<const uint8_t*>(&inputIndex) + sizeof(inputIndex));
+    keyData.push_back(checkKeyImage ? 1 : 0);
+    for (const auto& key : check.outputKeys) {
+      keyData.insert(keyData.end(), key.data, key.data + sizeof(key.data));
+    }
+
+    cacheKeys.push_back(Crypto::cn_fast_hash(keyData.data(), keyData.size()));
+  }
+
+  std::vector<uint8_t> cached(signatureChecks.size(), 0);
+  {
+    std::lock_guard<std::mutex> lock(ringSignatureCacheMutex);
+    for (size_t i = 0; i < cacheKeys.size(); ++i) {
+      cached[i] = validRingSignatures.count(cacheKeys[i]) != 0 || previousValidRingSignatures.count(cacheKeys[i]) != 0;
+      valid[i] = cached[i];
+    }
+  }
+
+  auto checkSignature = [&] (size_t i) {
+    if (cached[i]) {
+      return;
+    }
+
+    const auto& check = signatureChecks[i];
+    const auto& transaction = check.transaction->getTransaction();
+    const KeyInput& in = boost::get<KeyInput>(transaction.inputs[check.inputIndex]);
+
+    std::vector<const Crypto::PublicKey*> outputKeyPointers;
+    outputKeyPointers.reserve(check.outputKeys.size());
+    std::for_each(check.outputKeys.begin(), check.outputKeys.end(), [&outputKeyPointers] (const Crypto::PublicKey& key) { outputKeyPointers.push_back(&key); });
+    valid[i] = Crypto::check_ring_signature(check.transaction->getTransactionPrefixHash(), in.keyImage, outputKeyPointers.data(),
+                                            outputKeyPointers.size(), transaction.signatures[check.inputIndex].data(),
+                                            checkKeyImage);
+  };
+
+  if (threadPool != nullptr) {
+    threadPool->parallelFor(signatureChecks.size(), checkSignature);
+  } else {
+    for (size_t i = 0; i < signatureChecks.size(); ++i) {
+      checkSignature(i);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(ringSignatureCacheMutex);
+  for (size_t i = 0; i < cacheKeys.size(); ++i) {
+    if (valid[i] == 0 || cached[i] != 0) {
+      continue;
+    }
+
+    if (validRingSignatures.size() >= RING_SIGNATURE_CACHE_GENERATION_SIZE) {
+      previousValidRingSignatures.swap(validRingSignatures);
+      validRingSignatures.clear();
+    }
+
+    validRingSignatures.insert(cacheKeys[i]);
+  }
+}
+
 std::error_code Core::validateSemantic(const Transaction& transaction, uint64_t& fee, uint32_t blockIndex) {
   if (transaction.inputs.empty()) {
     return error::TransactionValidationError::EMPTY_INPUTS;
@@ -1574,6 +2053,7 @@ const Currency& Core::getCurrency() const {
 
 void Core::save() {
   throwIfNotInitialized();
+  WriteLock lock(*this);
 
   deleteAlternativeChains();
   mergeMainChainSegments();
@@ -1848,7 +2328,7 @@ void Core::fillQueryBlockFullInfo(uint32_t fullOffset, uint32_t currentIndex, si
   }
 }
 
-void Core::fillQueryBlockShortInfo(uint32_t fullOffset, uint32_t currentIndex, size_t maxItemsCount,
+void Core::fillQueryBlockShortInfo(uint32_t fullOffset, uint32_t currentIndex, size_t maxItemsCount, bool includeGlobalIndexes,
                                    std::vector<BlockShortInfo>& entries) const {
   assert(currentIndex >= fullOffset);
 
@@ -1860,9 +2340,17 @@ void Core::fillQueryBlockShortInfo(uint32_t fullOffset, uint32_t currentIndex, s
     RawBlock rawBlock = getRawBlock(segment, blockIndex);
 
     BlockShortInfo blockShortInfo;
-    blockShortInfo.block = std::move(rawBlock.block);
     blockShortInfo.blockId = segment->getBlockHash(blockIndex);
 
+    if (includeGlobalIndexes) {
+      CachedTransaction baseTransaction(std::move(extractBlockTemplate(rawBlock).baseTransaction));
+      if (!segment->getTransactionGlobalIndexes(baseTransaction.getTransactionHash(), blockShortInfo.baseTransactionGlobalIndexes)) {
+        throw std::runtime_error("Couldn't get base transaction global indexes");
+      }
+    }
+
+    blockShortInfo.block = std::move(rawBlock.block);
+
     blockShortInfo.txPrefixes.reserve(rawBlock.transactions.size());
     for (auto& rawTransaction : rawBlock.transactions) {
       TransactionPrefixInfo prefixInfo;
@@ -1875,6 +2363,10 @@ void Core::fillQueryBlockShortInfo(uint32_t fullOffset, uint32_t currentIndex, s
         throw std::runtime_error("Couldn't deserialize transaction");
       }
 
+      if (includeGlobalIndexes && !segment->getTransactionGlobalIndexes(prefixInfo.txHash, prefixInfo.globalIndexes)) {
+        throw std::runtime_error("Couldn't get transaction global indexes");
+      }
+
       prefixInfo.txPrefix = std::move(static_cast<TransactionPrefix&>(transaction));
       blockShortInfo.txPrefixes.emplace_back(std::move(prefixInfo));
     }
@@ -1935,9 +2427,9 @@ void Core::fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t max
 
   TransactionSpentInputsChecker spentInputsChecker;
 
-  std::vector<CachedTransaction> poolTransactions = transactionPool->getPoolTransactions();
-  for (auto it = poolTransactions.rbegin(); it != poolTransactions.rend() && it->getTransactionFee() == 0; ++it) {
-    const CachedTransaction& transaction = *it;
+  std::vector<const CachedTransaction*> poolTransactions = transactionPool->getPoolTransactionReferences();
+  for (auto it = poolTransactions.rbegin(); it != poolTransactions.rend() && (*it)->getTransactionFee() == 0; ++it) {
+    const CachedTransaction& transaction = **it;
 
     auto transactionBlobSize = transaction.getTransactionBinaryArray().size();
     if (currency.fusionTxMaxSize() < transactionsSize + transactionBlobSize) {
@@ -1951,7 +2443,8 @@ void Core::fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t max
     }
   }
 
-  for (const auto& cachedTransaction : poolTransactions) {
+  for (const auto* poolTransaction : poolTransactions) {
+    const CachedTransaction& cachedTransaction = *poolTransaction;
     size_t blockSizeLimit = (cachedTransaction.getTransactionFee() == 0) ? medianSize : maxTotalSize;
 
     if (blockSizeLimit < transactionsSize + cachedTransaction.getTransactionBinaryArray().size()) {
@@ -2155,6 +2648,44 @@ BlockDetails Core::getBlockDetails(const Crypto::Hash& blockHash) const {
   return blockDetails;
 }
 
+std::vector<BlockSummary> Core::getBlockSummaries(uint32_t startIndex, uint32_t maxCount) const {
+  throwIfNotInitialized();
+
+  IBlockchainCache* mainChain = chainsLeaves[0];
+  if (startIndex > mainChain->getTopBlockIndex()) {
+    return {};
+  }
+
+  uint32_t count = std::min(maxCount, mainChain->getTopBlockIndex() - startIndex + 1);
+  auto storedSummaries = mainChain->getBlockSummaries(startIndex, count);
+
+  std::vector<BlockSummary> summaries;
+  summaries.reserve(count);
+  for (uint32_t blockIndex = startIndex; blockIndex < startIndex + count; ++blockIndex) {
+    auto it = storedSummaries.find(blockIndex);
+    if (it != storedSummaries.end()) {
+      summaries.push_back(it->second);
+      continue;
+    }
+
+    // Blocks held in memory segments and blocks stored before summaries were introduced have no stored summary
+    BlockDetails blockDetails = getBlockDetails(blockIndex);
+
+    BlockSummary summary;
+    summary.timestamp = blockDetails.timestamp;
+    summary.blockSize = blockDetails.blockSize;
+    summary.reward = blockDetails.reward;
+    summary.totalFeeAmount = blockDetails.totalFeeAmount;
+    summary.transactionCount = static_cast<uint32_t>(blockDetails.transactions.size());
+    summary.difficulty = blockDetails.difficulty;
+    summary.sizeMedian = blockDetails.sizeMedian;
+    summary.penalty = blockDetails.penalty;
+    summaries.push_back(summary);
+  }
+
+  return summaries;
+}
+
 TransactionDetails Core::getTransactionDetails(const Crypto::Hash& transactionHash) const {
   throwIfNotInitialized();
 
@@ -2404,7 +2935,12 @@ void Core::transactionPoolCleaningProcedure() {
     for (;;) {
       timer.sleep(OUTDATED_TRANSACTION_POLLING_INTERVAL);
 
-      auto deletedTransactions = transactionPool->clean();
+      std::vector<Crypto::Hash> deletedTransactions;
+      {
+        WriteLock lock(*this);
+        deletedTransactions = transactionPool->clean();
+      }
+
       notifyObservers(makeDelTransactionMessage(std::move(deletedTransactions), Messages::DeleteTransaction::Reason::Outdated));
     }
   } catch (System::InterruptedException&) {
@@ -2424,6 +2960,72 @@ void Core::updateBlockMedianSize() {
   blockMedianSize = std::max(Common::medianValue(lastBlockSizes), static_cast<uint64_t>(nextBlockGrantedFullRewardZone));
 }
 
+void Core::setThreadPool(Common::ThreadPool* threadPool) {
+  this->threadPool = threadPool;
+}
+
+boost::shared_lock<boost::shared_mutex> Core::lockForReading() const {
+  return boost::shared_lock<boost::shared_mutex>(readersMutex);
+}
+
+Core::WriteLock::WriteLock(Core& core) : core(core) {
+  bool interrupted = false;
+  if (core.writerActive) {
+    // The releasing writer hands the turn over, so the order of requests is kept
+    System::Event turn(core.dispatcher);
+    core.waitingWriters.push_back(&turn);
+    while (!turn.get()) {
+      try {
+        turn.wait();
+      } catch (System::InterruptedException&) {
+        interrupted = true;
+      }
+    }
+  } else {
+    core.writerActive = true;
+  }
+
+  if (!core.readersMutex.try_lock()) {
+    // The mutex is locked and unlocked on the same thread, this one waits for the readers and holds it until released
+    System::Event locked(core.dispatcher);
+    owner = std::thread([&core, &locked](std::future<void> release) {
+      core.readersMutex.lock();
+      auto lockedEvent = &locked;
+      core.dispatcher.remoteSpawn([=] { lockedEvent->set(); });
+      release.wait();
+      core.readersMutex.unlock();
+    }, released.get_future());
+
+    while (!locked.get()) {
+      try {
+        locked.wait();
+      } catch (System::InterruptedException&) {
+        interrupted = true;
+      }
+    }
+  }
+
+  if (interrupted) {
+    core.dispatcher.interrupt();
+  }
+}
+
+Core::WriteLock::~WriteLock() {
+  if (owner.joinable()) {
+    released.set_value();
+    owner.join();
+  } else {
+    core.readersMutex.unlock();
+  }
+
+  if (core.waitingWriters.empty()) {
+    core.writerActive = false;
+  } else {
+    core.waitingWriters.front()->set();
+    core.waitingWriters.pop_front();
+  }
+}
+
 size_t Core::getMaximumTransactionSize() const {
   assert(blockMedianSize * 2 > currency.minerTxBlobReservedSize());
   size_t maximumSize = std::min(blockMedianSize * 2, currency.maxBlockCumulativeSize(getTopBlockIndex() + 1)) - currency.minerTxBlobReservedSize();
@@ -17,6 +17,10 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 #include "BlockchainCache.h"
@@ -40,7 +44,14 @@
 
 #include "CryptoNoteCore/MinerConfig.h"
 
+#include <Common/ThreadPool.h>
+
 #include <System/ContextGroup.h>
+#include <System/Event.h>
+
+#include <boost/optional.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
 
 namespace CryptoNote {
 
@@ -68,9 +79,10 @@ public:
 
   virtual std::vector<RawBlock> getBlocks(uint32_t minIndex, uint32_t count) const override;
   virtual void getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<RawBlock>& blocks, std::vector<Crypto::Hash>& missedHashes) const override;
+  virtual void getBlockViews(const std::vector<Crypto::Hash>& blockHashes, std::vector<RawBlockView>& blocks, std::vector<Crypto::Hash>& missedHashes) const override;
   virtual bool queryBlocks(const std::vector<Crypto::Hash>& blockHashes, uint64_t timestamp,
     uint32_t& startIndex, uint32_t& currentIndex, uint32_t& fullOffset, std::vector<BlockFullInfo>& entries) const override;
-  virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockHashes, uint64_t timestamp,
+  virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockHashes, uint64_t timestamp, bool includeGlobalIndexes,
     uint32_t& startIndex, uint32_t& currentIndex, uint32_t& fullOffset, std::vector<BlockShortInfo>& entries) const override;
 
   virtual bool hasTransaction(const Crypto::Hash& transactionHash) const override;
@@ -79,8 +91,10 @@ public:
 
   virtual Difficulty getBlockDifficulty(uint32_t blockIndex) const override;
   virtual Difficulty getDifficultyForNextBlock() const override;
+  virtual bool isInCheckpointZone(uint32_t blockIndex) const override;
 
   virtual std::error_code addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock) override;
+  virtual std::error_code addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock, std::vector<CachedTransaction>&& transactions) override;
   virtual std::error_code addBlock(RawBlock&& rawBlock) override;
 
   virtual std::error_code submitBlock(BinaryArray&& rawBlockTemplate) override;
@@ -89,8 +103,10 @@ public:
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
 
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) override;
+  virtual std::vector<bool> addTransactionsToPool(const std::vector<BinaryArray>& transactionBinaryArrays) override;
 
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const override;
+  virtual void getPoolTransactions(const std::vector<Crypto::Hash>& transactionHashes, std::vector<BinaryArray>& transactions, std::vector<Crypto::Hash>& missedHashes) const override;
   virtual bool getPoolChanges(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes, std::vector<BinaryArray>& addedTransactions,
     std::vector<Crypto::Hash>& deletedTransactions) const override;
   virtual bool getPoolChangesLite(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes, std::vector<TransactionPrefixInfo>& addedTransactions,
@@ -99,9 +115,17 @@ public:
   virtual bool getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, const BinaryArray& extraNonce, Difficulty& difficulty, uint32_t& height) const override;
 
   virtual CoreStatistics getCoreStatistics() const override;
+  virtual LookupCacheStatistics getLookupCacheStatistics() const override;
 
   size_t getMaximumTransactionSize() const;
 
+  // Ring signatures are verified on this pool if set, pool must outlive the core
+  void setThreadPool(Common::ThreadPool* threadPool);
+
+  // Threads other than the dispatcher's hold this while they read from the core, so they see the chain and the pool
+  // as of one moment. Adding blocks and pool transactions waits for them.
+  boost::shared_lock<boost::shared_mutex> lockForReading() const;
+
   //ICoreInformation
   virtual size_t getPoolTransactionCount() const override;
   virtual size_t getBlockchainTransactionCount() const override;
@@ -121,6 +145,7 @@ public:
 
   virtual BlockDetails getBlockDetails(const Crypto::Hash& blockHash) const override;
   BlockDetails getBlockDetails(const uint32_t blockHeight) const;
+  virtual std::vector<BlockSummary> getBlockSummaries(uint32_t startIndex, uint32_t maxCount) const override;
   virtual TransactionDetails getTransactionDetails(const Crypto::Hash& transactionHash) const override;
   virtual std::vector<Crypto::Hash> getAlternativeBlockHashesByIndex(uint32_t blockIndex) const override;
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const override;
@@ -146,12 +171,68 @@ private:
   bool initialized;
 
   size_t blockMedianSize;
+  // No pool transaction is bigger, the pool is scanned for oversized transactions only when the size limit drops below it
+  size_t poolTransactionSizeBound;
+  Common::ThreadPool* threadPool;
+  mutable boost::shared_mutex readersMutex;
+
+  // Exclusive counterpart of lockForReading(). Writers of the dispatcher get it one at a time, in the order they asked for
+  // it. While a reader holds the mutex, a helper thread waits for it and owns it until the lock is released, so other
+  // contexts of the dispatcher keep running.
+  class WriteLock {
+  public:
+    explicit WriteLock(Core& core);
+    WriteLock(const WriteLock&) = delete;
+    WriteLock& operator=(const WriteLock&) = delete;
+    ~WriteLock();
+
+  private:
+    Core& core;
+    std::promise<void> released;
+    std::thread owner;
+  };
+
+  bool writerActive;
+  std::deque<System::Event*> waitingWriters;
+
+  // Transactions picked for the last block template, reused while neither the top block nor the pool change
+  struct BlockTemplateTransactions {
+    Crypto::Hash previousBlockHash;
+    uint64_t poolVersion;
+    std::vector<Crypto::Hash> transactionHashes;
+    size_t transactionsSize;
+    uint64_t fee;
+  };
+
+  mutable std::mutex blockTemplateMutex;
+  mutable boost::optional<BlockTemplateTransactions> blockTemplateTransactions;
+
+  // Ring signatures found valid, keyed by a hash of the transaction hash, the input index and the ring members, so a
+  // transaction verified in the pool isn't verified again when its block arrives. The older generation is dropped when
+  // the newer one fills up.
+  mutable std::mutex ringSignatureCacheMutex;
+  mutable std::unordered_set<Crypto::Hash> validRingSignatures;
+  mutable std::unordered_set<Crypto::Hash> previousValidRingSignatures;
+
+  struct RingSignatureCheck {
+    const CachedTransaction* transaction;
+    size_t transactionIndex;
+    size_t inputIndex;
+    std::vector<Crypto::PublicKey> outputKeys;
+  };
 
   void throwIfNotInitialized() const;
   bool extractTransactions(const std::vector<BinaryArray>& rawTransactions, std::vector<CachedTransaction>& transactions, uint64_t& cumulativeSize);
 
   std::error_code validateSemantic(const Transaction& transaction, uint64_t& fee, uint32_t blockIndex);
-  std::error_code validateTransaction(const CachedTransaction& transaction, TransactionValidatorState& state, IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex);
+  std::error_code validateTransactionInputs(const CachedTransaction& transaction, size_t transactionIndex, TransactionValidatorState& state,
+    IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex, std::vector<RingSignatureCheck>& signatureChecks);
+  std::error_code validateBlockTransactions(const std::vector<CachedTransaction>& transactions, TransactionValidatorState& state,
+    IBlockchainCache* cache, uint32_t blockIndex, uint64_t& cumulativeFee, size_t& failedTransactionIndex);
+  std::error_code validateCheckpointedTransactions(const BlockTemplate& block, const std::vector<CachedTransaction>& transactions,
+    TransactionValidatorState& state, uint64_t& cumulativeFee, size_t& failedTransactionIndex);
+  bool checkRingSignatures(const std::vector<RingSignatureCheck>& signatureChecks, uint32_t blockIndex, size_t& failedTransactionIndex) const;
+  void verifyRingSignatures(const std::vector<RingSignatureCheck>& signatureChecks, uint32_t blockIndex, std::vector<uint8_t>& valid) const;
 
   uint32_t findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds) const;
   std::vector<Crypto::Hash> getBlockHashes(uint32_t startBlockIndex, uint32_t maxCount) const;
@@ -179,7 +260,8 @@ private:
   size_t pushBlockHashes(uint32_t startIndex, uint32_t fullOffset, size_t maxItemsCount, std::vector<BlockFullInfo>& entries) const;
   bool notifyObservers(BlockchainMessage&& msg);
   void fillQueryBlockFullInfo(uint32_t fullOffset, uint32_t currentIndex, size_t maxItemsCount, std::vector<BlockFullInfo>& entries) const;
-  void fillQueryBlockShortInfo(uint32_t fullOffset, uint32_t currentIndex, size_t maxItemsCount, std::vector<BlockShortInfo>& entries) const;
+  void fillQueryBlockShortInfo(uint32_t fullOffset, uint32_t currentIndex, size_t maxItemsCount, bool includeGlobalIndexes,
+                               std::vector<BlockShortInfo>& entries) const;
 
   void getTransactionPoolDifference(const std::vector<Crypto::Hash>& knownHashes, std::vector<Crypto::Hash>& newTransactions, std::vector<Crypto::Hash>& deletedTransactions) const;
 
@@ -195,13 +277,19 @@ private:
                        const IBlockchainCache& cache);
   void copyTransactionsToPool(IBlockchainCache* alt);
 
-  void actualizePoolTransactions();
+  void actualizePoolTransactions(uint32_t splitBlockIndex);
   void actualizePoolTransactionsLite(const TransactionValidatorState& validatorState); //Checks pool txs only for double spend.
 
   void transactionPoolCleaningProcedure();
   void updateBlockMedianSize();
   bool addTransactionToPool(CachedTransaction&& cachedTransaction);
+  bool addSerializedTransactionToPool(const BinaryArray& transactionBinaryArray);
+  bool pushTransactionToPool(CachedTransaction&& cachedTransaction, TransactionValidatorState&& validatorState);
   bool isTransactionValidForPool(const CachedTransaction& cachedTransaction, TransactionValidatorState& validatorState);
+  bool isFusionTransactionAllowed(const CachedTransaction& cachedTransaction) const;
+  // Everything isTransactionValidForPool checks except the ring signatures, which are appended to signatureChecks
+  bool checkTransactionForPool(const CachedTransaction& cachedTransaction, size_t transactionIndex, TransactionValidatorState& validatorState,
+                               std::vector<RingSignatureCheck>& signatureChecks);
 
   void initRootSegment();
   void importBlocksFromStorage();
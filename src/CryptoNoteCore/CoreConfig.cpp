@@ -17,12 +17,24 @@
 
 #include "CoreConfig.h"
 
+#include <algorithm>
+#include <thread>
+
 #include "Common/Util.h"
 #include "Common/CommandLine.h"
 
 namespace CryptoNote {
 
-CoreConfig::CoreConfig() {
+namespace {
+
+const size_t DEFAULT_VALIDATION_THREADS = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+const command_line::arg_descriptor<size_t> argValidationThreads = { "validation-threads", "Number of threads used to verify block signatures", DEFAULT_VALIDATION_THREADS };
+const command_line::arg_descriptor<bool>   argMappedBlocksStorage = { "mapped-blocks-storage", "Keep blocks in memory mapped segment files, blocks of the old storage are imported on first start", false };
+
+} //namespace
+
+CoreConfig::CoreConfig() : validationThreads(DEFAULT_VALIDATION_THREADS), mappedBlocksStorage(false) {
   configFolder = Tools::getDefaultDataDirectory();
 }
 
@@ -31,8 +43,18 @@ void CoreConfig::init(const boost::program_options::variables_map& options) {
     configFolder = command_line::get_arg(options, command_line::arg_data_dir);
     configFolderDefaulted = options[command_line::arg_data_dir.name].defaulted();
   }
+
+  if (options.count(argValidationThreads.name) != 0 && !options[argValidationThreads.name].defaulted()) {
+    validationThreads = command_line::get_arg(options, argValidationThreads);
+  }
+
+  if (options.count(argMappedBlocksStorage.name) != 0 && !options[argMappedBlocksStorage.name].defaulted()) {
+    mappedBlocksStorage = command_line::get_arg(options, argMappedBlocksStorage);
+  }
 }
 
 void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, argValidationThreads);
+  command_line::add_arg(desc, argMappedBlocksStorage);
 }
 } //namespace CryptoNote
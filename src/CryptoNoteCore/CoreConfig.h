@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 #include <boost/program_options.hpp>
@@ -32,6 +33,8 @@ public:
 
   std::string configFolder;
   bool configFolderDefaulted = true;
+  size_t validationThreads;
+  bool mappedBlocksStorage;
 };
 
 } //namespace CryptoNote
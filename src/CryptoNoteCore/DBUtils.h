@@ -27,7 +27,7 @@
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
 #include "Common/StdInputStream.h"
-#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryInputBufferSerializer.h"
 
 namespace CryptoNote {
 namespace DB {
@@ -62,6 +62,8 @@ namespace DB {
 
   const std::string KEY_OUTPUT_KEY_PREFIX = "j";
 
+  const std::string BLOCK_INDEX_TO_BLOCK_SUMMARY_PREFIX = "k";
+
   template <class Value>
   std::string serialize(const Value& value, const std::string& name) {
     CryptoNote::KVBinaryOutputStreamSerializer serializer;
@@ -88,9 +90,7 @@ namespace DB {
 
   template <class Value>
   void deserialize(const std::string& serialized, Value& value, const std::string& name) {
-    std::stringstream ss(serialized);
-    Common::StdInputStream stream(ss);
-    CryptoNote::KVBinaryInputStreamSerializer serializer(stream);
+    CryptoNote::KVBinaryInputBufferSerializer serializer(serialized.data(), serialized.size());
     serializer(value, name);
   }
 
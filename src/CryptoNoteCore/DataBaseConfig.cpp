@@ -40,6 +40,7 @@ const command_line::arg_descriptor<uint16_t>    argBackgroundThreadsCount = { "d
 const command_line::arg_descriptor<uint32_t>    argMaxOpenFiles = { "db-max-open-files", "Number of open files that can be used by the database", DEFAULT_MAX_OPEN_FILES};
 const command_line::arg_descriptor<uint64_t>    argWriteBufferSize = { "db-write-buffer-size", "Size of database write buffer in megabytes", WRITE_BUFFER_MB_DEFAULT_SIZE};
 const command_line::arg_descriptor<uint64_t>    argReadCacheSize = { "db-read-cache-size", "Size of database read cache in megabytes", READ_BUFFER_MB_DEFAULT_SIZE};
+const command_line::arg_descriptor<bool>        argUseColumnFamilies = { "db-column-families", "Keep every database index in its own column family, an existing database is converted on start", false};
 
 } //namespace
 
@@ -48,6 +49,7 @@ void DataBaseConfig::initOptions(boost::program_options::options_description& de
   command_line::add_arg(desc, argMaxOpenFiles);
   command_line::add_arg(desc, argWriteBufferSize);
   command_line::add_arg(desc, argReadCacheSize);
+  command_line::add_arg(desc, argUseColumnFamilies);
 }
 
 DataBaseConfig::DataBaseConfig() :
@@ -56,7 +58,8 @@ DataBaseConfig::DataBaseConfig() :
   maxOpenFiles(DEFAULT_MAX_OPEN_FILES),
   writeBufferSize(WRITE_BUFFER_MB_DEFAULT_SIZE * MEGABYTE),
   readCacheSize(READ_BUFFER_MB_DEFAULT_SIZE * MEGABYTE),
-  testnet(false) {
+  testnet(false),
+  useColumnFamilies(false) {
 }
 
 bool DataBaseConfig::init(const boost::program_options::variables_map& vm) {
@@ -80,6 +83,10 @@ bool DataBaseConfig::init(const boost::program_options::variables_map& vm) {
     dataDir = command_line::get_arg(vm, command_line::arg_data_dir);
   }
 
+  if (vm.count(argUseColumnFamilies.name) != 0 && !vm[argUseColumnFamilies.name].defaulted()) {
+    useColumnFamilies = command_line::get_arg(vm, argUseColumnFamilies);
+  }
+
   configFolderDefaulted = vm[command_line::arg_data_dir.name].defaulted();
 
   return true;
@@ -113,6 +120,10 @@ bool DataBaseConfig::getTestnet() const {
   return testnet;
 }
 
+bool DataBaseConfig::getUseColumnFamilies() const {
+  return useColumnFamilies;
+}
+
 void DataBaseConfig::setConfigFolderDefaulted(bool defaulted) {
   configFolderDefaulted = defaulted;
 }
@@ -140,3 +151,7 @@ void DataBaseConfig::setReadCacheSize(uint64_t readCacheSize) {
 void DataBaseConfig::setTestnet(bool testnet) {
   this->testnet = testnet;
 }
+
+void DataBaseConfig::setUseColumnFamilies(bool useColumnFamilies) {
+  this->useColumnFamilies = useColumnFamilies;
+}
@@ -38,6 +38,7 @@ public:
   uint64_t getWriteBufferSize() const; //Bytes
   uint64_t getReadCacheSize() const; //Bytes
   bool getTestnet() const;
+  bool getUseColumnFamilies() const;
 
   void setConfigFolderDefaulted(bool defaulted);
   void setDataDir(const std::string& dataDir);
@@ -46,6 +47,7 @@ public:
   void setWriteBufferSize(uint64_t writeBufferSize); //Bytes
   void setReadCacheSize(uint64_t readCacheSize); //Bytes
   void setTestnet(bool testnet);
+  void setUseColumnFamilies(bool useColumnFamilies);
 
 private:
   bool configFolderDefaulted;
@@ -55,5 +57,6 @@ private:
   uint64_t writeBufferSize;
   uint64_t readCacheSize;
   bool testnet;
+  bool useColumnFamilies;
 };
 } //namespace CryptoNote
@@ -24,6 +24,7 @@
 
 #include <boost/iterator/iterator_facade.hpp>
 
+#include <Common/Math.h>
 #include <Common/ShuffleGenerator.h>
 
 #include "BlockchainUtils.h"
@@ -40,6 +41,9 @@ namespace CryptoNote {
 namespace {
 
 const uint32_t ONE_DAY_SECONDS = 60 * 60 * 24;
+const size_t SPENT_KEY_IMAGES_CACHE_SIZE = 200000;
+const size_t KEY_OUTPUTS_CACHE_SIZE = 200000;
+const size_t LOOKUP_CACHE_SHARD_COUNT = 16;
 const CachedBlockInfo NULL_CACHED_BLOCK_INFO {NULL_HASH, 0, 0, 0, 0, 0};
 
 bool requestPackedOutputs(IBlockchainCache::Amount amount, Common::ArrayView<uint32_t> globalIndexes, IDataBase& database, std::vector<PackedOutIndex>& result) {
@@ -441,7 +445,8 @@ struct DatabaseBlockchainCache::ExtendedPushedBlockInfo {
 
 
 DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger)
-    : currency(curr), database(dataBase), blockchainCacheFactory(blockchainCacheFactory), logger(_logger, "DatabaseBlockchainCache") {
+    : currency(curr), database(dataBase), blockchainCacheFactory(blockchainCacheFactory), logger(_logger, "DatabaseBlockchainCache"),
+      spentKeyImagesCache(SPENT_KEY_IMAGES_CACHE_SIZE, LOOKUP_CACHE_SHARD_COUNT), keyOutputsCache(KEY_OUTPUTS_CACHE_SIZE, LOOKUP_CACHE_SHARD_COUNT) {
   DatabaseVersionReadBatch readBatch;
   auto ec = database.read(readBatch);
   if (ec) {
@@ -552,7 +557,7 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
     auto& validatorState = std::get<2>(*it);
     uint64_t timestamp = std::get<3>(*it);
 
-    writeBatch.removeCachedBlock(blockHash, blockIndex).removeRawBlock(blockIndex);
+    writeBatch.removeCachedBlock(blockHash, blockIndex).removeRawBlock(blockIndex).removeBlockSummary(blockIndex);
     requestDeleteSpentOutputs(writeBatch,
                               blockIndex,
                               validatorState);
@@ -588,6 +593,17 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
     throw std::runtime_error(err.message());
   }
 
+  // Key images spent by the moved blocks are unspent now and global indexes of their outputs may be reused
+  spentKeyImagesCache.invalidateReads();
+  for (const auto& deletingBlock : deletingBlocks) {
+    for (const auto& keyImage : std::get<2>(deletingBlock).spentKeyImages) {
+      spentKeyImagesCache.update(keyImage, INVALID_BLOCK_INDEX);
+    }
+  }
+
+  keyOutputsCache.invalidateReads();
+  keyOutputsCache.clear();
+
   cutTail(unitsCache, currentTop + 1 - splitBlockIndex);
 
   children.push_back(cache.get());
@@ -911,6 +927,8 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   txHashes.insert(txHashes.begin(), cachedBaseTransaction.getTransactionHash());
 
   batch.insertCachedBlock(blockInfo, getTopBlockIndex() + 1, txHashes);
+  batch.insertBlockSummary(getTopBlockIndex() + 1, makeBlockSummary(getTopBlockIndex() + 1, cachedBlock, cachedBaseTransaction, cachedTransactions,
+                                                                    rawBlock, blockSize, blockDifficulty, lastBlockInfo.alreadyGeneratedCoins));
   batch.insertRawBlock(getTopBlockIndex() + 1, std::move(rawBlock));
 
   auto transactionIndex = 0;
@@ -940,6 +958,12 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
 
   topBlockIndex = *topBlockIndex + 1;
   topBlockHash = cachedBlock.getBlockHash();
+
+  spentKeyImagesCache.invalidateReads();
+  for (const auto& keyImage : validatorState.spentKeyImages) {
+    spentKeyImagesCache.update(keyImage, *topBlockIndex);
+  }
+
   logger(Logging::DEBUGGING) << "push block " << cachedBlock.getBlockHash() << " completed";
 
   unitsCache.push_back(blockInfo);
@@ -948,22 +972,71 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   }
 }
 
+// Computes the same figures Core::getBlockDetails reports, for a block about to become the new top block
+BlockSummary DatabaseBlockchainCache::makeBlockSummary(uint32_t blockIndex, const CachedBlock& cachedBlock, const CachedTransaction& cachedBaseTransaction,
+                                                       const std::vector<CachedTransaction>& cachedTransactions, const RawBlock& rawBlock,
+                                                       uint64_t transactionsCumulativeSize, Difficulty blockDifficulty,
+                                                       uint64_t previousGeneratedCoins) const {
+  const auto& block = cachedBlock.getBlock();
+
+  BlockSummary summary;
+  summary.timestamp = block.timestamp;
+  summary.blockSize = rawBlock.block.size() + transactionsCumulativeSize - cachedBaseTransaction.getTransactionBinaryArray().size();
+  summary.transactionCount = static_cast<uint32_t>(cachedTransactions.size() + 1);
+  summary.difficulty = blockDifficulty;
+
+  for (const auto& output : block.baseTransaction.outputs) {
+    summary.reward += output.amount;
+  }
+
+  for (const auto& transaction : cachedTransactions) {
+    summary.totalFeeAmount += transaction.getTransactionFee();
+  }
+
+  if (blockIndex == 0) {
+    return summary;
+  }
+
+  auto lastBlocksSizes = getLastBlocksSizes(currency.rewardBlocksWindow(), blockIndex - 1, UseGenesis(true));
+  summary.sizeMedian = Common::medianValue(lastBlocksSizes);
+
+  uint64_t baseReward = 0;
+  uint64_t currentReward = 0;
+  int64_t emissionChange = 0;
+  if (!currency.getBlockReward(block.majorVersion, summary.sizeMedian, 0, previousGeneratedCoins, 0, baseReward, emissionChange) ||
+      !currency.getBlockReward(block.majorVersion, summary.sizeMedian, transactionsCumulativeSize, previousGeneratedCoins, 0, currentReward, emissionChange)) {
+    return summary;
+  }
+
+  if (baseReward != 0 && baseReward >= currentReward) {
+    summary.penalty = static_cast<double>(baseReward - currentReward) / static_cast<double>(baseReward);
+  }
+
+  return summary;
+}
+
 PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex) const {
   return getExtendedPushedBlockInfo(blockIndex).pushedBlockInfo;
 }
 
 bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const {
-  auto batch = BlockchainReadBatch().requestBlockIndexBySpentKeyImage(keyImage);
-  auto res = database.read(batch);
-  if (res) {
-    logger(Logging::ERROR) << "checkIfSpent failed, request to database failed: " << res.message();
-    return false;
-  }
+  uint32_t spentBlockIndex;
+  if (!spentKeyImagesCache.find(keyImage, spentBlockIndex)) {
+    auto generation = spentKeyImagesCache.getGeneration();
+    auto batch = BlockchainReadBatch().requestBlockIndexBySpentKeyImage(keyImage);
+    auto res = database.read(batch);
+    if (res) {
+      logger(Logging::ERROR) << "checkIfSpent failed, request to database failed: " << res.message();
+      return false;
+    }
 
-  auto readResult = batch.extractResult();
-  auto it = readResult.getBlockIndexesBySpentKeyImages().find(keyImage);
+    auto readResult = batch.extractResult();
+    auto it = readResult.getBlockIndexesBySpentKeyImages().find(keyImage);
+    spentBlockIndex = it != readResult.getBlockIndexesBySpentKeyImages().end() ? it->second : INVALID_BLOCK_INDEX;
+    spentKeyImagesCache.insert(keyImage, spentBlockIndex, generation);
+  }
 
-  return it != readResult.getBlockIndexesBySpentKeyImages().end() && it->second <= blockIndex;
+  return spentBlockIndex != INVALID_BLOCK_INDEX && spentBlockIndex <= blockIndex;
 }
 
 bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage) const {
@@ -1031,6 +1104,7 @@ ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputReferences(
 }
 
 uint32_t DatabaseBlockchainCache::getTopBlockIndex() const {
+  std::lock_guard<std::recursive_mutex> lock(lazyValuesMutex);
   if (!topBlockIndex) {
     auto batch = BlockchainReadBatch().requestLastBlockIndex();
     auto result = database.read(batch);
@@ -1060,6 +1134,7 @@ uint8_t DatabaseBlockchainCache::getBlockMajorVersionForHeight(uint32_t height)
 }
 
 uint64_t DatabaseBlockchainCache::getCachedTransactionsCount() const {
+  std::lock_guard<std::recursive_mutex> lock(lazyValuesMutex);
   if (!transactionsCount) {
     auto batch = BlockchainReadBatch().requestTransactionsCount();
     auto result = database.read(batch);
@@ -1082,6 +1157,7 @@ uint64_t DatabaseBlockchainCache::getCachedTransactionsCount() const {
 }
 
 const Crypto::Hash& DatabaseBlockchainCache::getStartBlockHash() const {
+  std::lock_guard<std::recursive_mutex> lock(lazyValuesMutex);
   if (!startBlockHash) {
     auto batch = BlockchainReadBatch().requestCachedBlock(getStartBlockIndex());
     auto result = readDatabase(batch);
@@ -1091,6 +1167,7 @@ const Crypto::Hash& DatabaseBlockchainCache::getStartBlockHash() const {
 }
 
 const Crypto::Hash& DatabaseBlockchainCache::getTopBlockHash() const {
+  std::lock_guard<std::recursive_mutex> lock(lazyValuesMutex);
   if (!topBlockHash) {
     auto batch = BlockchainReadBatch().requestCachedBlock(getTopBlockIndex());
     auto result = readDatabase(batch);
@@ -1342,6 +1419,25 @@ std::vector<Crypto::Hash> DatabaseBlockchainCache::getBlockHashes(uint32_t start
   return hashes;
 }
 
+std::map<uint32_t, BlockSummary> DatabaseBlockchainCache::getBlockSummaries(uint32_t startIndex, size_t maxCount) const {
+  if (startIndex > getTopBlockIndex()) {
+    return {};
+  }
+
+  uint32_t count = static_cast<uint32_t>(std::min(static_cast<size_t>(getTopBlockIndex() - startIndex + 1), maxCount));
+  if (count == 0) {
+    return {};
+  }
+
+  BlockchainReadBatch request;
+  for (uint32_t index = startIndex; index != startIndex + count; ++index) {
+    request.requestBlockSummary(index);
+  }
+
+  auto result = readDatabase(request);
+  return std::map<uint32_t, BlockSummary>(result.getBlockSummaries().begin(), result.getBlockSummaries().end());
+}
+
 IBlockchainCache* DatabaseBlockchainCache::getParent() const {
   return nullptr;
 }
@@ -1594,13 +1690,28 @@ ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
     uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
     std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
                                           uint32_t globalIndex)> callback) const {
+  std::map<std::pair<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex>, KeyOutputInfo> sortedResult;
   BlockchainReadBatch batch;
+  bool hasMisses = false;
   for (auto it = globalIndexes.begin(); it != globalIndexes.end(); ++it) {
-    batch.requestKeyOutputInfo(amount, *it);
+    KeyOutputInfo info;
+    if (keyOutputsCache.find(std::make_pair(amount, *it), info)) {
+      sortedResult.emplace(std::make_pair(amount, *it), info);
+    } else {
+      batch.requestKeyOutputInfo(amount, *it);
+      hasMisses = true;
+    }
   }
 
-  auto result = readDatabase(batch).getKeyOutputInfo();
-  std::map<std::pair<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex>, KeyOutputInfo> sortedResult(result.begin(), result.end());
+  if (hasMisses) {
+    auto generation = keyOutputsCache.getGeneration();
+    auto result = readDatabase(batch).getKeyOutputInfo();
+    for (const auto& kv : result) {
+      keyOutputsCache.insert(kv.first, kv.second, generation);
+    }
+
+    sortedResult.insert(result.begin(), result.end());
+  }
   for (const auto& kv: sortedResult) {
     ExtendedTransactionInfo tx;
     tx.unlockTime = kv.second.unlockTime;
@@ -1621,6 +1732,67 @@ ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
   return ExtractOutputKeysResult::SUCCESS;
 }
 
+LookupCacheStatistics DatabaseBlockchainCache::getLookupCacheStatistics() const {
+  LookupCacheStatistics statistics;
+  statistics.keyImageHits = spentKeyImagesCache.getHits();
+  statistics.keyImageMisses = spentKeyImagesCache.getMisses();
+  statistics.keyImageCount = spentKeyImagesCache.size();
+  statistics.keyOutputHits = keyOutputsCache.getHits();
+  statistics.keyOutputMisses = keyOutputsCache.getMisses();
+  statistics.keyOutputCount = keyOutputsCache.size();
+  return statistics;
+}
+
+void DatabaseBlockchainCache::prefetchLookups(const LookupBatch& lookups) const {
+  BlockchainReadBatch batch;
+  std::vector<Crypto::KeyImage> keyImages;
+  bool hasMisses = false;
+  for (const auto& keyImage : lookups.keyImages) {
+    if (!spentKeyImagesCache.contains(keyImage)) {
+      batch.requestBlockIndexBySpentKeyImage(keyImage);
+      keyImages.push_back(keyImage);
+      hasMisses = true;
+    }
+  }
+
+  for (const auto& keyOutput : lookups.keyOutputs) {
+    if (!keyOutputsCache.contains(keyOutput)) {
+      batch.requestKeyOutputInfo(keyOutput.first, keyOutput.second);
+      hasMisses = true;
+    }
+  }
+
+  if (!hasMisses) {
+    return;
+  }
+
+  auto keyImagesGeneration = spentKeyImagesCache.getGeneration();
+  auto keyOutputsGeneration = keyOutputsCache.getGeneration();
+  auto res = database.read(batch);
+  if (res) {
+    logger(Logging::WARNING) << "prefetchLookups failed, request to database failed: " << res.message();
+    return;
+  }
+
+  auto readResult = batch.extractResult();
+  const auto& spentKeyImages = readResult.getBlockIndexesBySpentKeyImages();
+  for (const auto& keyImage : keyImages) {
+    auto it = spentKeyImages.find(keyImage);
+    spentKeyImagesCache.insert(keyImage, it != spentKeyImages.end() ? it->second : INVALID_BLOCK_INDEX, keyImagesGeneration);
+  }
+
+  // Missing outputs aren't cached, extractKeyOutputs reads them again and reports the error
+  for (const auto& kv : readResult.getKeyOutputInfo()) {
+    keyOutputsCache.insert(kv.first, kv.second, keyOutputsGeneration);
+  }
+}
+
+size_t DatabaseBlockchainCache::KeyOutputHash::operator()(const std::pair<Amount, GlobalOutputIndex>& key) const {
+  // Global indexes are dense and amounts are round numbers, mix both over the whole word
+  uint64_t value = (key.first ^ (static_cast<uint64_t>(key.second) << 32 | key.second)) * 0x9E3779B97F4A7C15ULL;
+  return static_cast<size_t>(value ^ (value >> 29));
+}
+
 std::vector<Crypto::Hash> DatabaseBlockchainCache::getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const {
   auto countBatch = BlockchainReadBatch().requestTransactionCountByPaymentId(paymentId);
   uint32_t transactionsCountByPaymentId = readDatabase(countBatch).getTransactionCountByPaymentIds().at(paymentId);
@@ -1744,8 +1916,11 @@ void DatabaseBlockchainCache::addGenesisBlock(CachedBlock&& genesisBlock) {
 
   pushTransaction(cachedBaseTransaction, 0, 0, batch);
 
+  RawBlock rawBlock{toBinaryArray(genesisBlock.getBlock()), {}};
+
   batch.insertCachedBlock(blockInfo, 0, {cachedBaseTransaction.getTransactionHash()});
-  batch.insertRawBlock(0, {toBinaryArray(genesisBlock.getBlock()), {}});
+  batch.insertBlockSummary(0, makeBlockSummary(0, genesisBlock, cachedBaseTransaction, {}, rawBlock, baseTransactionSize, 1, 0));
+  batch.insertRawBlock(0, rawBlock);
   batch.insertClosestTimestampBlockIndex(roundToMidnight(genesisBlock.getBlock().timestamp), 0);
 
   auto res = database.write(batch);
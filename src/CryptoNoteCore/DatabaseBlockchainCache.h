@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <mutex>
+
+#include "Common/ShardedLruCache.h"
 #include "Common/StringView.h"
 #include "Currency.h"
 #include "Difficulty.h"
@@ -112,6 +115,7 @@ public:
 
   Crypto::Hash getBlockHash(uint32_t blockIndex) const override;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t startIndex, size_t maxCount) const override;
+  virtual std::map<uint32_t, BlockSummary> getBlockSummaries(uint32_t startIndex, size_t maxCount) const override;
 
   /*
    * This method always returns zero
@@ -160,11 +164,19 @@ public:
 
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const override;
+  virtual LookupCacheStatistics getLookupCacheStatistics() const override;
+  virtual void prefetchLookups(const LookupBatch& lookups) const override;
 
 private:
+  struct KeyOutputHash {
+    size_t operator()(const std::pair<Amount, GlobalOutputIndex>& key) const;
+  };
+
   const Currency& currency;
   IDataBase& database;
   IBlockchainCacheFactory& blockchainCacheFactory;
+  // Guards lazy loading of the values below from readers running in parallel, the writer excludes them on its own
+  mutable std::recursive_mutex lazyValuesMutex;
   mutable boost::optional<uint32_t> topBlockIndex;
   mutable boost::optional<Crypto::Hash> startBlockHash;
   mutable boost::optional<Crypto::Hash> topBlockHash;
@@ -175,6 +187,9 @@ private:
   Logging::LoggerRef logger;
   std::deque<CachedBlockInfo> unitsCache;
   const size_t unitsCacheSize = 1000;
+  // Block index spending the key image, INVALID_BLOCK_INDEX caches that it isn't spent
+  mutable Common::ShardedLruCache<Crypto::KeyImage, uint32_t> spentKeyImagesCache;
+  mutable Common::ShardedLruCache<std::pair<Amount, GlobalOutputIndex>, KeyOutputInfo, KeyOutputHash> keyOutputsCache;
 
   struct ExtendedPushedBlockInfo;
   ExtendedPushedBlockInfo getExtendedPushedBlockInfo(uint32_t blockIndex) const;
@@ -195,6 +210,9 @@ private:
   void insertBlockTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash);
 
   void addGenesisBlock(CachedBlock&& genesisBlock);
+  BlockSummary makeBlockSummary(uint32_t blockIndex, const CachedBlock& cachedBlock, const CachedTransaction& cachedBaseTransaction,
+                                const std::vector<CachedTransaction>& cachedTransactions, const RawBlock& rawBlock,
+                                uint64_t transactionsCumulativeSize, Difficulty blockDifficulty, uint64_t previousGeneratedCoins) const;
 
   enum class OutputSearchResult : uint8_t { FOUND, NOT_FOUND, INVALID_ARGUMENT };
 
@@ -0,0 +1,262 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "FileMappedMainChainStorage.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteTools.h"
+#include "MainChainStorage.h"
+
+namespace CryptoNote {
+
+namespace {
+
+// Segments are created sparse, so only the used part takes disk space
+const uint64_t SEGMENT_SIZE = 256 * 1024 * 1024;
+
+// Record layout: block size, sizes of the transactions, block, transactions
+uint64_t getRecordHeaderSize(size_t transactionCount) {
+  return sizeof(uint32_t) * (1 + transactionCount);
+}
+
+uint32_t readSize(const uint8_t* data, size_t position) {
+  uint32_t size;
+  std::memcpy(&size, data + sizeof(uint32_t) * position, sizeof(size));
+  return size;
+}
+
+void writeSize(uint8_t* data, size_t position, size_t size) {
+  uint32_t value = static_cast<uint32_t>(size);
+  std::memcpy(data + sizeof(uint32_t) * position, &value, sizeof(value));
+}
+
+}
+
+FileMappedMainChainStorage::FileMappedMainChainStorage(const std::string& blocksFilename, const std::string& indexFilename) :
+  blocksFilename(blocksFilename), appendSegment(0), appendOffset(0), autoFlush(true) {
+  try {
+    index.open(indexFilename);
+
+    for (size_t segment = 0; boost::filesystem::exists(getSegmentFilename(segment)); ++segment) {
+      segments.emplace_back(new System::MemoryMappedFile());
+      segments.back()->open(getSegmentFilename(segment));
+    }
+  } catch (std::exception&) {
+    throw std::runtime_error("Failed to load main chain storage: " + blocksFilename);
+  }
+
+  if (!index.empty()) {
+    const BlockEntry& last = index.back();
+    if (last.segment >= segments.size() || static_cast<uint64_t>(last.offset) + last.size > segments[last.segment]->size()) {
+      throw std::runtime_error("Main chain storage index doesn't match blocks: " + blocksFilename);
+    }
+
+    appendSegment = last.segment;
+    appendOffset = last.offset + last.size;
+  }
+}
+
+FileMappedMainChainStorage::~FileMappedMainChainStorage() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto& segment : segments) {
+    std::error_code ignore;
+    segment->flush(segment->data(), segment->size(), ignore);
+  }
+
+  index.flush();
+}
+
+void FileMappedMainChainStorage::pushBlock(const RawBlock& rawBlock) {
+  uint64_t recordSize = getRecordHeaderSize(rawBlock.transactions.size()) + rawBlock.block.size();
+  for (const auto& transaction : rawBlock.transactions) {
+    recordSize += transaction.size();
+  }
+
+  if (recordSize > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Block is too big for main chain storage");
+  }
+
+  BlockEntry entry;
+  entry.size = static_cast<uint32_t>(recordSize);
+  entry.transactionCount = static_cast<uint32_t>(rawBlock.transactions.size());
+
+  std::shared_ptr<System::MemoryMappedFile> segment;
+  bool flushRecord;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    flushRecord = autoFlush;
+    entry.segment = appendSegment;
+    entry.offset = appendOffset;
+    while (entry.segment < segments.size() && entry.offset + recordSize > segments[entry.segment]->size()) {
+      ++entry.segment;
+      entry.offset = 0;
+    }
+
+    segment = getWritableSegment(entry.segment, recordSize);
+    appendSegment = entry.segment;
+    appendOffset = entry.offset + entry.size;
+  }
+
+  // The record goes past everything indexed or popped, so it is written without the lock
+  uint8_t* record = segment->data() + entry.offset;
+  uint8_t* data = record;
+  writeSize(data, 0, rawBlock.block.size());
+  for (size_t i = 0; i < rawBlock.transactions.size(); ++i) {
+    writeSize(data, i + 1, rawBlock.transactions[i].size());
+  }
+
+  data += getRecordHeaderSize(rawBlock.transactions.size());
+  data = std::copy(rawBlock.block.begin(), rawBlock.block.end(), data);
+  for (const auto& transaction : rawBlock.transactions) {
+    data = std::copy(transaction.begin(), transaction.end(), data);
+  }
+
+  if (flushRecord) {
+    segment->flush(record, recordSize);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  index.push_back(entry);
+}
+
+void FileMappedMainChainStorage::popBlock() {
+  std::lock_guard<std::mutex> lock(mutex);
+  index.pop_back();
+}
+
+RawBlock FileMappedMainChainStorage::getBlockByIndex(uint32_t blockIndex) const {
+  return getBlockViewByIndex(blockIndex).toRawBlock();
+}
+
+RawBlockView FileMappedMainChainStorage::getBlockViewByIndex(uint32_t blockIndex) const {
+  BlockEntry entry;
+  std::shared_ptr<System::MemoryMappedFile> segment;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blockIndex >= index.size()) {
+      throw std::out_of_range("Block index " + std::to_string(blockIndex) + " is out of range. Blocks count: " + std::to_string(index.size()));
+    }
+
+    entry = index[blockIndex];
+    segment = segments[entry.segment];
+  }
+
+  const uint8_t* header = segment->data() + entry.offset;
+  const uint8_t* data = header + getRecordHeaderSize(entry.transactionCount);
+
+  RawBlockView view;
+  view.block = { data, readSize(header, 0) };
+  data += view.block.size;
+
+  view.transactions.reserve(entry.transactionCount);
+  for (size_t i = 0; i < entry.transactionCount; ++i) {
+    view.transactions.push_back({ data, readSize(header, i + 1) });
+    data += view.transactions.back().size;
+  }
+
+  view.owner = std::move(segment);
+  return view;
+}
+
+uint32_t FileMappedMainChainStorage::getBlockCount() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return static_cast<uint32_t>(index.size());
+}
+
+void FileMappedMainChainStorage::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  index.clear();
+  index.flush();
+  appendSegment = 0;
+  appendOffset = 0;
+
+  // Existing views keep their segments mapped
+  for (size_t segment = 0; segment < segments.size(); ++segment) {
+    boost::system::error_code ignore;
+    boost::filesystem::remove(getSegmentFilename(segment), ignore);
+  }
+
+  segments.clear();
+}
+
+void FileMappedMainChainStorage::setAutoFlush(bool autoFlush) {
+  std::lock_guard<std::mutex> lock(mutex);
+  this->autoFlush = autoFlush;
+  index.setAutoFlush(autoFlush);
+  if (autoFlush) {
+    for (auto& segment : segments) {
+      segment->flush(segment->data(), segment->size());
+    }
+
+    index.flush();
+  }
+}
+
+std::string FileMappedMainChainStorage::getSegmentFilename(size_t segment) const {
+  return blocksFilename + "." + std::to_string(segment);
+}
+
+std::shared_ptr<System::MemoryMappedFile> FileMappedMainChainStorage::getWritableSegment(size_t segment, uint64_t recordSize) {
+  if (segment < segments.size()) {
+    return segments[segment];
+  }
+
+  assert(segment == segments.size());
+  std::shared_ptr<System::MemoryMappedFile> file(new System::MemoryMappedFile());
+  file->create(getSegmentFilename(segment), std::max(SEGMENT_SIZE, recordSize), true);
+  segments.push_back(file);
+  return file;
+}
+
+std::unique_ptr<IMainChainStorage> createFileMappedMainChainStorage(const std::string& dataDir, const Currency& currency) {
+  boost::filesystem::path blocksFilename = boost::filesystem::path(dataDir) / currency.blocksFileName();
+  boost::filesystem::path indexesFilename = boost::filesystem::path(dataDir) / currency.blockIndexesFileName();
+
+  std::unique_ptr<FileMappedMainChainStorage> storage(new FileMappedMainChainStorage(blocksFilename.string(), blocksFilename.string() + ".index"));
+  if (boost::filesystem::exists(blocksFilename) && boost::filesystem::exists(indexesFilename)) {
+    {
+      MainChainStorage swappedStorage(blocksFilename.string(), indexesFilename.string());
+      // Old files still there mean the import didn't finish, whatever it left is discarded
+      storage->clear();
+      storage->setAutoFlush(false);
+      for (uint32_t i = 0; i < swappedStorage.getBlockCount(); ++i) {
+        storage->pushBlock(swappedStorage.getBlockByIndex(i));
+      }
+
+      storage->setAutoFlush(true);
+    }
+
+    boost::filesystem::remove(blocksFilename);
+    boost::filesystem::remove(indexesFilename);
+  }
+
+  if (storage->getBlockCount() == 0) {
+    RawBlock genesis;
+    genesis.block = toBinaryArray(currency.genesisBlock());
+    storage->pushBlock(genesis);
+  }
+
+  return std::move(storage);
+}
+
+}
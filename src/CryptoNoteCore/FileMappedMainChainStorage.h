@@ -0,0 +1,78 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/FileMappedVector.h"
+#include "IMainChainStorage.h"
+#include "Currency.h"
+
+
+namespace CryptoNote {
+
+// Append-only block store on memory mapped segment files. Blocks are kept serialized as received, so views returned by
+// getBlockViewByIndex point straight into the mapping. Segments are never resized or moved and popped blocks aren't
+// overwritten while the storage is open, readers only take the lock to look up the offset index and may run
+// concurrently with each other and with the writer. A block is flushed to its segment before the index refers to it.
+class FileMappedMainChainStorage: public IMainChainStorage {
+public:
+  struct BlockEntry {
+    uint32_t segment;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t transactionCount;
+  };
+
+  FileMappedMainChainStorage(const std::string& blocksFilename, const std::string& indexFilename);
+  virtual ~FileMappedMainChainStorage();
+
+  virtual void pushBlock(const RawBlock& rawBlock) override;
+  virtual void popBlock() override;
+
+  virtual RawBlock getBlockByIndex(uint32_t index) const override;
+  virtual RawBlockView getBlockViewByIndex(uint32_t index) const override;
+  virtual uint32_t getBlockCount() const override;
+
+  virtual void clear() override;
+
+  // With auto flush off nothing is flushed until it is turned back on, for bulk imports that can be redone
+  void setAutoFlush(bool autoFlush);
+
+private:
+  std::string getSegmentFilename(size_t segment) const;
+  std::shared_ptr<System::MemoryMappedFile> getWritableSegment(size_t segment, uint64_t recordSize);
+
+  const std::string blocksFilename;
+  mutable std::mutex mutex;
+  Common::FileMappedVector<BlockEntry> index;
+  std::vector<std::shared_ptr<System::MemoryMappedFile>> segments;
+  // Where the next block goes, not moved back by popBlock
+  uint32_t appendSegment;
+  uint32_t appendOffset;
+  bool autoFlush;
+};
+
+// Imports blocks of the SwappedVector storage if its files exist and removes them afterwards, an interrupted import is
+// started over
+std::unique_ptr<IMainChainStorage> createFileMappedMainChainStorage(const std::string& dataDir, const Currency& currency);
+
+}
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <vector>
 
 #include <CryptoNote.h>
@@ -61,6 +63,35 @@ struct PushedBlockInfo {
   Difficulty blockDifficulty;
 };
 
+struct LookupCacheStatistics {
+  uint64_t keyImageHits = 0;
+  uint64_t keyImageMisses = 0;
+  uint64_t keyImageCount = 0;
+  uint64_t keyOutputHits = 0;
+  uint64_t keyOutputMisses = 0;
+  uint64_t keyOutputCount = 0;
+};
+
+// Key images and (amount, global index) pairs referenced by the inputs of a block or of a batch of pool transactions
+struct LookupBatch {
+  std::vector<Crypto::KeyImage> keyImages;
+  std::vector<std::pair<uint64_t, uint32_t>> keyOutputs;
+};
+
+// Header-level figures of a block stored alongside it, so explorer requests don't have to decode the block and its transactions
+struct BlockSummary {
+  uint64_t timestamp = 0;
+  uint64_t blockSize = 0;
+  uint64_t reward = 0;
+  uint64_t totalFeeAmount = 0;
+  uint32_t transactionCount = 0;
+  Difficulty difficulty = 0;
+  uint64_t sizeMedian = 0;
+  double penalty = 0;
+
+  void serialize(ISerializer& s);
+};
+
 class UseGenesis {
 public:
   explicit UseGenesis(bool u) : use(u) {}
@@ -145,6 +176,8 @@ public:
 
   virtual Crypto::Hash getBlockHash(uint32_t blockIndex) const = 0;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t startIndex, size_t maxCount) const = 0;
+  // Summaries stored for blocks in [startIndex, startIndex + maxCount), blocks without a stored summary are omitted
+  virtual std::map<uint32_t, BlockSummary> getBlockSummaries(uint32_t startIndex, size_t maxCount) const = 0;
 
   virtual IBlockchainCache* getParent() const = 0;
   virtual void setParent(IBlockchainCache* parent) = 0;
@@ -182,6 +215,13 @@ public:
 
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const = 0;
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const = 0;
+
+  // Counters of the in-memory caches in front of the database, segments kept in memory report their root's
+  virtual LookupCacheStatistics getLookupCacheStatistics() const = 0;
+
+  // Resolves all lookups of a batch with one database read, so checkIfSpent and extractKeyOutputKeys calls that follow
+  // are answered from memory. Only a hint, the results of those calls don't depend on it.
+  virtual void prefetchLookups(const LookupBatch& lookups) const = 0;
 };
 
 }
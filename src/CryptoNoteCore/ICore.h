@@ -27,8 +27,10 @@
 #include "CachedTransaction.h"
 #include "CoreStatistics.h"
 #include "Difficulty.h"
+#include "IBlockchainCache.h"
 #include "ICoreObserver.h"
 #include "ICoreDefinitions.h"
+#include "IMainChainStorage.h"
 #include "MessageQueue.h"
 
 namespace CryptoNote {
@@ -63,9 +65,12 @@ public:
   virtual std::vector<RawBlock> getBlocks(uint32_t startIndex, uint32_t count) const = 0;
   virtual void getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<RawBlock>& blocks,
                          std::vector<Crypto::Hash>& missedHashes) const = 0;
+  // Same as getBlocks, but main chain blocks point into the main chain storage instead of being copied
+  virtual void getBlockViews(const std::vector<Crypto::Hash>& blockHashes, std::vector<RawBlockView>& blocks,
+                             std::vector<Crypto::Hash>& missedHashes) const = 0;
   virtual bool queryBlocks(const std::vector<Crypto::Hash>& blockHashes, uint64_t timestamp, uint32_t& startIndex,
                            uint32_t& currentIndex, uint32_t& fullOffset, std::vector<BlockFullInfo>& entries) const = 0;
-  virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockHashes, uint64_t timestamp,
+  virtual bool queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockHashes, uint64_t timestamp, bool includeGlobalIndexes,
                                uint32_t& startIndex, uint32_t& currentIndex, uint32_t& fullOffset,
                                std::vector<BlockShortInfo>& entries) const = 0;
 
@@ -76,8 +81,12 @@ public:
 
   virtual Difficulty getBlockDifficulty(uint32_t blockIndex) const = 0;
   virtual Difficulty getDifficultyForNextBlock() const = 0;
+  // Blocks in the checkpoint zone are checked against the checkpoint hash instead of proof of work
+  virtual bool isInCheckpointZone(uint32_t blockIndex) const = 0;
 
   virtual std::error_code addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock) = 0;
+  // transactions must be deserialized from rawBlock.transactions, they are extracted again if the counts don't match
+  virtual std::error_code addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock, std::vector<CachedTransaction>&& transactions) = 0;
   virtual std::error_code addBlock(RawBlock&& rawBlock) = 0;
 
   virtual std::error_code submitBlock(BinaryArray&& rawBlockTemplate) = 0;
@@ -88,8 +97,14 @@ public:
                                 std::vector<Crypto::PublicKey>& publicKeys) const = 0;
 
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) = 0;
+  // Same as addTransactionToPool for each transaction, the transactions are parsed and their signatures checked in
+  // parallel. Returns whether each one was added.
+  virtual std::vector<bool> addTransactionsToPool(const std::vector<BinaryArray>& transactionBinaryArrays) = 0;
 
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const = 0;
+  virtual void getPoolTransactions(const std::vector<Crypto::Hash>& transactionHashes,
+                                   std::vector<BinaryArray>& transactions,
+                                   std::vector<Crypto::Hash>& missedHashes) const = 0;
   virtual bool getPoolChanges(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes,
                               std::vector<BinaryArray>& addedTransactions,
                               std::vector<Crypto::Hash>& deletedTransactions) const = 0;
@@ -101,11 +116,13 @@ public:
                                 Difficulty& difficulty, uint32_t& height) const = 0;
 
   virtual CoreStatistics getCoreStatistics() const = 0;
+  virtual LookupCacheStatistics getLookupCacheStatistics() const = 0;
 
   virtual void save() = 0;
   virtual void load() = 0;
 
   virtual BlockDetails getBlockDetails(const Crypto::Hash& blockHash) const = 0;
+  virtual std::vector<BlockSummary> getBlockSummaries(uint32_t startIndex, uint32_t maxCount) const = 0;
   virtual TransactionDetails getTransactionDetails(const Crypto::Hash& transactionHash) const = 0;
   virtual std::vector<Crypto::Hash> getAlternativeBlockHashesByIndex(uint32_t blockIndex) const = 0;
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const = 0;
@@ -31,12 +31,16 @@ struct BlockFullInfo : public RawBlock {
 struct TransactionPrefixInfo {
   Crypto::Hash txHash;
   TransactionPrefix txPrefix;
+  // Global indexes of the transaction outputs, only filled when requested
+  std::vector<uint32_t> globalIndexes;
 };
 
 struct BlockShortInfo {
   Crypto::Hash blockId;
   BinaryArray block;
   std::vector<TransactionPrefixInfo> txPrefixes;
+  // Global indexes of the base transaction outputs, only filled when requested
+  std::vector<uint32_t> baseTransactionGlobalIndexes;
 };
 
 void serialize(BlockFullInfo&, ISerializer&);
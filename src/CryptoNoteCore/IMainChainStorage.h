@@ -17,10 +17,56 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include <CryptoNote.h>
 
 namespace CryptoNote {
 
+struct BinaryArrayView {
+  const uint8_t* data;
+  size_t size;
+
+  BinaryArray toBinaryArray() const {
+    return BinaryArray(data, data + size);
+  }
+};
+
+// Serialized block and its transactions as they are kept by the storage. The view holds whatever backs the data, so it
+// stays valid after the block is popped, but the contents of a popped block may be overwritten by the next push.
+struct RawBlockView {
+  std::shared_ptr<const void> owner;
+  BinaryArrayView block;
+  std::vector<BinaryArrayView> transactions;
+
+  // View owning the block
+  static RawBlockView fromRawBlock(RawBlock&& rawBlock) {
+    auto owner = std::make_shared<RawBlock>(std::move(rawBlock));
+
+    RawBlockView view;
+    view.block = { owner->block.data(), owner->block.size() };
+    view.transactions.reserve(owner->transactions.size());
+    for (const auto& transaction : owner->transactions) {
+      view.transactions.push_back({ transaction.data(), transaction.size() });
+    }
+
+    view.owner = std::move(owner);
+    return view;
+  }
+
+  RawBlock toRawBlock() const {
+    RawBlock rawBlock;
+    rawBlock.block = block.toBinaryArray();
+    rawBlock.transactions.reserve(transactions.size());
+    for (const auto& transaction : transactions) {
+      rawBlock.transactions.push_back(transaction.toBinaryArray());
+    }
+
+    return rawBlock;
+  }
+};
+
 class IMainChainStorage {
 public:
   virtual ~IMainChainStorage() { }
@@ -29,6 +75,11 @@ public:
   virtual void popBlock() = 0;
 
   virtual RawBlock getBlockByIndex(uint32_t index) const = 0;
+
+  // Storages keeping blocks in memory return views of their own buffers, the default one owns a copy of the block.
+  virtual RawBlockView getBlockViewByIndex(uint32_t index) const {
+    return RawBlockView::fromRawBlock(getBlockByIndex(index));
+  }
   virtual uint32_t getBlockCount() const = 0;
 
   virtual void clear() = 0;
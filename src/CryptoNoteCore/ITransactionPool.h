@@ -38,9 +38,15 @@ public:
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const = 0;
   virtual std::vector<CachedTransaction> getPoolTransactions() const = 0;
+  // Same order as getPoolTransactions, the pointers stay valid until the pool changes
+  virtual std::vector<const CachedTransaction*> getPoolTransactionReferences() const = 0;
+  // Changes whenever a transaction is added or removed
+  virtual uint64_t getVersion() const = 0;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const = 0;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const = 0;
+  // Pool transactions spending any of the key images in state
+  virtual std::vector<Crypto::Hash> getConflictingTransactionHashes(const TransactionValidatorState& state) const = 0;
 };
 
 }
@@ -44,6 +44,7 @@ void MainChainStorage::popBlock() {
 }
 
 RawBlock MainChainStorage::getBlockByIndex(uint32_t index) const {
+  std::lock_guard<std::mutex> lock(readMutex);
   if (index >= storage.size()) {
     throw std::out_of_range("Block index " + std::to_string(index) + " is out of range. Blocks count: " + std::to_string(storage.size()));
   }
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <mutex>
+
 #include "IMainChainStorage.h"
 #include "Currency.h"
 #include "SwappedVector.h"
@@ -37,6 +39,8 @@ public:
   virtual void clear() override;
 
 private:
+  // Reads go through the cache of the swapped vector, so readers running in parallel take turns
+  mutable std::mutex readMutex;
   mutable SwappedVector<RawBlock> storage;
 };
 
@@ -18,12 +18,17 @@
 
 #include "RocksDBWrapper.h"
 
+#include <algorithm>
+
 #include "rocksdb/cache.h"
+#include "rocksdb/convenience.h"
+#include "rocksdb/filter_policy.h"
 #include "rocksdb/table.h"
 #include "rocksdb/db.h"
 #include "rocksdb/utilities/backupable_db.h"
 
 #include "DataBaseErrors.h"
+#include "DBUtils.h"
 
 using namespace CryptoNote;
 using namespace Logging;
@@ -31,6 +36,39 @@ using namespace Logging;
 namespace {
   const std::string DB_NAME = "DB";
   const std::string TESTNET_DB_NAME = "testnet_DB";
+
+  // Written to the default column family once all keys are moved to their own families
+  const std::string COLUMN_FAMILIES_MIGRATED_KEY = "column_families_migrated";
+  const size_t MIGRATION_BATCH_SIZE = 10000;
+
+  // Keys are serialized pairs named after their prefix, so all of them start with the same bytes followed by the prefix
+  const std::string& getKeyHeader() {
+    static const std::string header = [] {
+      std::string first = DB::serializeKey(DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, uint32_t(0));
+      std::string second = DB::serializeKey(DB::BLOCK_INDEX_TO_TX_HASHES_PREFIX, uint32_t(0));
+      return std::string(first.begin(), std::mismatch(first.begin(), first.end(), second.begin()).first);
+    }();
+
+    return header;
+  }
+
+  struct ColumnFamilyLayout {
+    std::string name;
+    std::vector<std::string> prefixes;
+    bool bloomFilter;
+    bool compressed;
+  };
+
+  // Point lookups get bloom filters and raw blocks, the bulk of the data, get compressed. Keys with other prefixes stay
+  // in the default column family.
+  const std::vector<ColumnFamilyLayout> COLUMN_FAMILIES = {
+    { "raw_blocks", { DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX }, false, true },
+    { "key_images", { DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX }, true, false },
+    { "transactions", { DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, DB::BLOCK_INDEX_TO_TX_HASHES_PREFIX,
+                        DB::BLOCK_INDEX_TO_TRANSACTION_INFO_PREFIX }, true, false },
+    { "key_outputs", { DB::KEY_OUTPUT_KEY_PREFIX, DB::KEY_OUTPUT_AMOUNT_PREFIX, DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX }, true, false },
+    { "payment_ids", { DB::PAYMENT_ID_TO_TX_HASH_PREFIX }, true, false }
+  };
 }
 
 RocksDBWrapper::RocksDBWrapper(Logging::ILogger& logger) : logger(logger, "RocksDBWrapper"), state(NOT_INITIALIZED){
@@ -53,13 +91,19 @@ void RocksDBWrapper::init(const DataBaseConfig& config) {
   rocksdb::DB* dbPtr;
 
   rocksdb::Options dbOptions = getDBOptions(config);
-  rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
+
+  // A database that already has column families keeps using them
+  std::vector<std::string> existingFamilies;
+  bool hasColumnFamilies = rocksdb::DB::ListColumnFamilies(dbOptions, dataDir, &existingFamilies).ok() && existingFamilies.size() > 1;
+  bool useColumnFamilies = config.getUseColumnFamilies() || hasColumnFamilies;
+
+  rocksdb::Status status = open(dbOptions, dataDir, useColumnFamilies, &dbPtr);
   if (status.ok()) {
     logger(INFO) << "DB opened in " << dataDir;
   } else if (!status.ok() && status.IsInvalidArgument()) {
     logger(INFO) << "DB not found in " << dataDir << ". Creating new DB...";
     dbOptions.create_if_missing = true;
-    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
+    rocksdb::Status status = open(dbOptions, dataDir, useColumnFamilies, &dbPtr);
     if (!status.ok()) {
       logger(ERROR) << "DB Error. DB can't be created in " << dataDir << ". Error: " << status.ToString();
       throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
@@ -73,17 +117,126 @@ void RocksDBWrapper::init(const DataBaseConfig& config) {
   }
 
   db.reset(dbPtr);
+
+  if (useColumnFamilies) {
+    familyByPrefix.assign(256, db->DefaultColumnFamily());
+    for (size_t i = 0; i < COLUMN_FAMILIES.size(); ++i) {
+      for (const auto& prefix : COLUMN_FAMILIES[i].prefixes) {
+        // columnFamilies[0] is the default one
+        familyByPrefix[static_cast<uint8_t>(prefix[0])] = columnFamilies[i + 1];
+      }
+    }
+
+    std::string migrated;
+    if (db->Get(rocksdb::ReadOptions(), COLUMN_FAMILIES_MIGRATED_KEY, &migrated).IsNotFound()) {
+      migrateToColumnFamilies();
+    }
+  }
+
   state.store(INITIALIZED);
 }
 
+rocksdb::Status RocksDBWrapper::open(const rocksdb::Options& dbOptions, const std::string& dataDir, bool useColumnFamilies, rocksdb::DB** dbPtr) {
+  if (!useColumnFamilies) {
+    return rocksdb::DB::Open(dbOptions, dataDir, dbPtr);
+  }
+
+  std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+  descriptors.emplace_back(rocksdb::kDefaultColumnFamilyName, rocksdb::ColumnFamilyOptions(dbOptions));
+  for (const auto& layout : COLUMN_FAMILIES) {
+    descriptors.emplace_back(layout.name, getColumnFamilyOptions(dbOptions, layout.bloomFilter, layout.compressed));
+  }
+
+  rocksdb::DBOptions familiesDbOptions(dbOptions);
+  familiesDbOptions.create_missing_column_families = true;
+
+  columnFamilies.clear();
+  return rocksdb::DB::Open(familiesDbOptions, dataDir, descriptors, &columnFamilies, dbPtr);
+}
+
+// Moves keys out of the default column family in batches. Each batch is written atomically, so an interrupted migration
+// is continued on the next start.
+void RocksDBWrapper::migrateToColumnFamilies() {
+  logger(INFO) << "Moving DB indexes to column families, this may take a while...";
+
+  rocksdb::ColumnFamilyHandle* defaultFamily = db->DefaultColumnFamily();
+  std::unique_ptr<rocksdb::Iterator> iterator(db->NewIterator(rocksdb::ReadOptions(), defaultFamily));
+  rocksdb::WriteBatch batch;
+  rocksdb::Status status;
+  size_t batchKeys = 0;
+  uint64_t movedKeys = 0;
+  for (iterator->SeekToFirst(); iterator->Valid() && status.ok(); iterator->Next()) {
+    rocksdb::ColumnFamilyHandle* family = getColumnFamily(iterator->key().ToString());
+    if (family == defaultFamily) {
+      continue;
+    }
+
+    batch.Put(family, iterator->key(), iterator->value());
+    batch.Delete(defaultFamily, iterator->key());
+    if (++batchKeys == MIGRATION_BATCH_SIZE) {
+      status = db->Write(rocksdb::WriteOptions(), &batch);
+      movedKeys += batchKeys;
+      batchKeys = 0;
+      batch.Clear();
+      logger(INFO) << "Moved " << movedKeys << " keys";
+    }
+  }
+
+  if (status.ok()) {
+    status = iterator->status();
+  }
+
+  iterator.reset();
+  if (status.ok() && batchKeys != 0) {
+    status = db->Write(rocksdb::WriteOptions(), &batch);
+    movedKeys += batchKeys;
+  }
+
+  if (status.ok()) {
+    rocksdb::WriteOptions writeOptions;
+    writeOptions.sync = true;
+    status = db->Put(writeOptions, COLUMN_FAMILIES_MIGRATED_KEY, "1");
+  }
+
+  if (!status.ok()) {
+    logger(ERROR) << "DB Error. Can't move indexes to column families. Error: " << status.ToString();
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+  }
+
+  db->CompactRange(rocksdb::CompactRangeOptions(), defaultFamily, nullptr, nullptr);
+  logger(INFO) << "DB indexes moved to column families, " << movedKeys << " keys moved";
+}
+
+rocksdb::ColumnFamilyHandle* RocksDBWrapper::getColumnFamily(const std::string& key) const {
+  const std::string& header = getKeyHeader();
+  if (!familyByPrefix.empty() && key.size() > header.size() && key.compare(0, header.size(), header) == 0) {
+    return familyByPrefix[static_cast<uint8_t>(key[header.size()])];
+  }
+
+  return db->DefaultColumnFamily();
+}
+
 void RocksDBWrapper::shutdown() {
   if (state.load() != INITIALIZED) {
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
   }
 
   logger(INFO) << "Closing DB.";
-  db->Flush(rocksdb::FlushOptions());
+  if (columnFamilies.empty()) {
+    db->Flush(rocksdb::FlushOptions());
+  }
+
+  for (auto family : columnFamilies) {
+    db->Flush(rocksdb::FlushOptions(), family);
+  }
+
   db->SyncWAL();
+  for (auto family : columnFamilies) {
+    db->DestroyColumnFamilyHandle(family);
+  }
+
+  columnFamilies.clear();
+  familyByPrefix.clear();
   db.reset();
   state.store(NOT_INITIALIZED);
 }
@@ -131,12 +284,12 @@ std::error_code RocksDBWrapper::write(IWriteBatch& batch, bool sync) {
   rocksdb::WriteBatch rocksdbBatch;
   std::vector<std::pair<std::string, std::string>> rawData(batch.extractRawDataToInsert());
   for (const std::pair<std::string, std::string>& kvPair : rawData) {
-    rocksdbBatch.Put(rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
+    rocksdbBatch.Put(getColumnFamily(kvPair.first), rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
   }
 
   std::vector<std::string> rawKeys(batch.extractRawKeysToRemove());
   for (const std::string& key : rawKeys) {
-    rocksdbBatch.Delete(rocksdb::Slice(key));
+    rocksdbBatch.Delete(getColumnFamily(key), rocksdb::Slice(key));
   }
 
   rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
@@ -158,14 +311,17 @@ std::error_code RocksDBWrapper::read(IReadBatch& batch) {
 
   std::vector<std::string> rawKeys(batch.getRawKeys());
   std::vector<rocksdb::Slice> keySlices;
+  std::vector<rocksdb::ColumnFamilyHandle*> keyFamilies;
   keySlices.reserve(rawKeys.size());
+  keyFamilies.reserve(rawKeys.size());
   for (const std::string& key : rawKeys) {
     keySlices.emplace_back(rocksdb::Slice(key));
+    keyFamilies.push_back(getColumnFamily(key));
   }
 
   std::vector<std::string> values;
   values.reserve(rawKeys.size());
-  std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keySlices, &values);
+  std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keyFamilies, keySlices, &values);
 
   std::error_code error;
   std::vector<bool> resultStates;
@@ -216,13 +372,54 @@ rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig& config) {
   }
 
   rocksdb::BlockBasedTableOptions tableOptions;
-  tableOptions.block_cache = rocksdb::NewLRUCache(config.getReadCacheSize());
+  readCache = rocksdb::NewLRUCache(config.getReadCacheSize());
+  tableOptions.block_cache = readCache;
   std::shared_ptr<rocksdb::TableFactory> tfp(NewBlockBasedTableFactory(tableOptions));
   fOptions.table_factory = tfp;
 
   return rocksdb::Options(dbOptions, fOptions);
 }
 
+rocksdb::ColumnFamilyOptions RocksDBWrapper::getColumnFamilyOptions(const rocksdb::Options& dbOptions, bool bloomFilter, bool compressed) {
+  rocksdb::ColumnFamilyOptions fOptions(dbOptions);
+
+  rocksdb::BlockBasedTableOptions tableOptions;
+  tableOptions.block_cache = readCache;
+  if (bloomFilter) {
+    tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+  }
+
+  fOptions.table_factory.reset(NewBlockBasedTableFactory(tableOptions));
+
+  if (compressed) {
+    // Use what the RocksDB build supports: LZ4 on all levels and ZSTD on the last one when available
+    std::vector<rocksdb::CompressionType> supported = rocksdb::GetSupportedCompressions();
+    auto isSupported = [&supported](rocksdb::CompressionType type) {
+      return std::find(supported.begin(), supported.end(), type) != supported.end();
+    };
+
+    rocksdb::CompressionType compression = rocksdb::kNoCompression;
+    if (isSupported(rocksdb::kLZ4Compression)) {
+      compression = rocksdb::kLZ4Compression;
+    } else if (isSupported(rocksdb::kSnappyCompression)) {
+      compression = rocksdb::kSnappyCompression;
+    } else if (isSupported(rocksdb::kZSTD)) {
+      compression = rocksdb::kZSTD;
+    }
+
+    if (compression == rocksdb::kNoCompression) {
+      logger(WARNING) << "RocksDB is built without LZ4, Snappy and ZSTD, raw blocks are stored uncompressed";
+    }
+
+    std::fill(fOptions.compression_per_level.begin(), fOptions.compression_per_level.end(), compression);
+    if (isSupported(rocksdb::kZSTD)) {
+      fOptions.bottommost_compression = rocksdb::kZSTD;
+    }
+  }
+
+  return fOptions;
+}
+
 std::string RocksDBWrapper::getDataDir(const DataBaseConfig& config) {
   if (config.getTestnet()) {
     return config.getDataDir() + '/' + TESTNET_DB_NAME;
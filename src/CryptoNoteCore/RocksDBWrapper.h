@@ -21,7 +21,9 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "rocksdb/cache.h"
 #include "rocksdb/db.h"
 
 #include "IDataBase.h"
@@ -53,7 +55,12 @@ public:
 private:
   std::error_code write(IWriteBatch& batch, bool sync);
 
+  rocksdb::Status open(const rocksdb::Options& dbOptions, const std::string& dataDir, bool useColumnFamilies, rocksdb::DB** dbPtr);
+  void migrateToColumnFamilies();
+  rocksdb::ColumnFamilyHandle* getColumnFamily(const std::string& key) const;
+
   rocksdb::Options getDBOptions(const DataBaseConfig& config);
+  rocksdb::ColumnFamilyOptions getColumnFamilyOptions(const rocksdb::Options& dbOptions, bool bloomFilter, bool compressed);
   std::string getDataDir(const DataBaseConfig& config);
 
   enum State {
@@ -63,6 +70,10 @@ private:
 
   Logging::LoggerRef logger;
   std::unique_ptr<rocksdb::DB> db;
+  std::shared_ptr<rocksdb::Cache> readCache;
+  // Handles returned by DB::Open and the family of every key prefix, both empty with a single column family
+  std::vector<rocksdb::ColumnFamilyHandle*> columnFamilies;
+  std::vector<rocksdb::ColumnFamilyHandle*> familyByPrefix;
   std::atomic<State> state;
 };
 }
@@ -62,12 +62,18 @@ TransactionPool::TransactionPool(Logging::ILogger& logger) :
   transactionHashIndex(transactions.get<TransactionHashTag>()),
   transactionCostIndex(transactions.get<TransactionCostTag>()),
   paymentIdIndex(transactions.get<PaymentIdTag>()),
+  version(0),
   logger(logger, "TransactionPool") {
 }
 
 bool TransactionPool::pushTransaction(CachedTransaction&& transaction, TransactionValidatorState&& transactionState) {
   auto pendingTx = PendingTransactionInfo{static_cast<uint64_t>(time(nullptr)), std::move(transaction)};
 
+  // Pool transactions are read from RPC threads too, fill their lazily computed values while the pool is locked
+  pendingTx.cachedTransaction.getTransactionBinaryArray();
+  pendingTx.cachedTransaction.getTransactionPrefixHash();
+  pendingTx.cachedTransaction.getTransactionFee();
+
   Crypto::Hash paymentId;
   if(getPaymentIdFromTxExtra(pendingTx.cachedTransaction.getTransaction().extra, paymentId)) {
     pendingTx.paymentId = paymentId;
@@ -83,7 +89,12 @@ bool TransactionPool::pushTransaction(CachedTransaction&& transaction, Transacti
     return false;
   }
 
+  for (const auto& keyImage : transactionState.spentKeyImages) {
+    keyImageIndex.emplace(keyImage, pendingTx.getTransactionHash());
+  }
+
   mergeStates(poolState, transactionState);
+  ++version;
 
   logger(Logging::DEBUGGING) << "pushed transaction " << pendingTx.getTransactionHash() << " to pool";
   return transactionHashIndex.emplace(std::move(pendingTx)).second;
@@ -104,7 +115,14 @@ bool TransactionPool::removeTransaction(const Crypto::Hash& hash) {
   }
 
   excludeFromState(poolState, it->cachedTransaction);
+  for (const auto& input : it->cachedTransaction.getTransaction().inputs) {
+    if (input.type() == typeid(KeyInput)) {
+      keyImageIndex.erase(boost::get<KeyInput>(input).keyImage);
+    }
+  }
+
   transactionHashIndex.erase(it);
+  ++version;
 
   logger(Logging::DEBUGGING) << "transaction " << hash << " removed from pool";
   return true;
@@ -156,6 +174,21 @@ std::vector<CachedTransaction> TransactionPool::getPoolTransactions() const {
   return result;
 }
 
+std::vector<const CachedTransaction*> TransactionPool::getPoolTransactionReferences() const {
+  std::vector<const CachedTransaction*> result;
+  result.reserve(transactionCostIndex.size());
+
+  for (const auto& transactionItem: transactionCostIndex) {
+    result.push_back(&transactionItem.cachedTransaction);
+  }
+
+  return result;
+}
+
+uint64_t TransactionPool::getVersion() const {
+  return version;
+}
+
 uint64_t TransactionPool::getTransactionReceiveTime(const Crypto::Hash& hash) const {
   auto it = transactionHashIndex.find(hash);
   assert(it != transactionHashIndex.end());
@@ -176,4 +209,16 @@ std::vector<Crypto::Hash> TransactionPool::getTransactionHashesByPaymentId(const
   return transactionHashes;
 }
 
+std::vector<Crypto::Hash> TransactionPool::getConflictingTransactionHashes(const TransactionValidatorState& state) const {
+  std::unordered_set<Crypto::Hash> transactionHashes;
+  for (const auto& keyImage : state.spentKeyImages) {
+    auto it = keyImageIndex.find(keyImage);
+    if (it != keyImageIndex.end()) {
+      transactionHashes.insert(it->second);
+    }
+  }
+
+  return std::vector<Crypto::Hash>(transactionHashes.begin(), transactionHashes.end());
+}
+
 }
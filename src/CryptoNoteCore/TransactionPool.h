@@ -51,11 +51,17 @@ public:
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const override;
   virtual std::vector<CachedTransaction> getPoolTransactions() const override;
+  virtual std::vector<const CachedTransaction*> getPoolTransactionReferences() const override;
+  virtual uint64_t getVersion() const override;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
+  virtual std::vector<Crypto::Hash> getConflictingTransactionHashes(const TransactionValidatorState& state) const override;
 private:
   TransactionValidatorState poolState;
+  // Pool transactions never share key images, so each one maps to a single transaction
+  std::unordered_map<Crypto::KeyImage, Crypto::Hash> keyImageIndex;
+  uint64_t version;
 
   struct PendingTransactionInfo {
     uint64_t receiveTime;
@@ -78,6 +78,14 @@ std::vector<CachedTransaction> TransactionPoolCleanWrapper::getPoolTransactions(
   return transactionPool->getPoolTransactions();
 }
 
+std::vector<const CachedTransaction*> TransactionPoolCleanWrapper::getPoolTransactionReferences() const {
+  return transactionPool->getPoolTransactionReferences();
+}
+
+uint64_t TransactionPoolCleanWrapper::getVersion() const {
+  return transactionPool->getVersion();
+}
+
 uint64_t TransactionPoolCleanWrapper::getTransactionReceiveTime(const Crypto::Hash& hash) const {
   return transactionPool->getTransactionReceiveTime(hash);
 }
@@ -86,6 +94,10 @@ std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesByPay
   return transactionPool->getTransactionHashesByPaymentId(paymentId);
 }
 
+std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getConflictingTransactionHashes(const TransactionValidatorState& state) const {
+  return transactionPool->getConflictingTransactionHashes(state);
+}
+
 std::vector<Crypto::Hash> TransactionPoolCleanWrapper::clean() {
   try {
     uint64_t currentTime = timeProvider->now();
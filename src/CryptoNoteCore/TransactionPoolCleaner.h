@@ -62,9 +62,12 @@ public:
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const override;
   virtual std::vector<CachedTransaction> getPoolTransactions() const override;
+  virtual std::vector<const CachedTransaction*> getPoolTransactionReferences() const override;
+  virtual uint64_t getVersion() const override;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
+  virtual std::vector<Crypto::Hash> getConflictingTransactionHashes(const TransactionValidatorState& state) const override;
 
   virtual std::vector<Crypto::Hash> clean() override;
 
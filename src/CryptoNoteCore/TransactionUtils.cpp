@@ -128,6 +128,31 @@ bool isOutToKey(const Crypto::PublicKey& spendPublicKey, const Crypto::PublicKey
   return pk == outKey;
 }
 
+void findOutputsToSpendKeys(const ITransactionReader& tx, const Crypto::KeyDerivation& derivation,
+                            const std::unordered_set<Crypto::PublicKey>& spendKeys,
+                            std::unordered_map<Crypto::PublicKey, std::vector<uint32_t>>& outputs) {
+  size_t keyIndex = 0;
+  size_t outputCount = tx.getOutputCount();
+
+  for (size_t idx = 0; idx < outputCount; ++idx) {
+    if (tx.getOutputType(idx) != TransactionTypes::OutputType::Key) {
+      continue;
+    }
+
+    uint64_t amount;
+    KeyOutput out;
+    tx.getOutput(idx, out, amount);
+
+    Crypto::PublicKey spendKey;
+    underive_public_key(derivation, keyIndex, out.key, spendKey);
+    if (spendKeys.find(spendKey) != spendKeys.end()) {
+      outputs[spendKey].push_back(static_cast<uint32_t>(idx));
+    }
+
+    ++keyIndex;
+  }
+}
+
 bool findOutputsToAccount(const CryptoNote::TransactionPrefix& transaction, const AccountPublicAddress& addr,
                           const SecretKey& viewSecretKey, std::vector<uint32_t>& out, uint64_t& amount) {
   AccountKeys keys;
@@ -15,6 +15,9 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include "CryptoNoteCore/CryptoNoteBasic.h"
 #include "ITransaction.h"
 
@@ -40,4 +43,10 @@ const TransactionOutput& getOutputChecked(const CryptoNote::TransactionPrefix& t
 bool findOutputsToAccount(const CryptoNote::TransactionPrefix& transaction, const AccountPublicAddress& addr,
         const Crypto::SecretKey& viewSecretKey, std::vector<uint32_t>& out, uint64_t& amount);
 
+// Collects the key outputs of tx that belong to one of spendKeys, as output indexes grouped by spend public key.
+// The derivation is computed once per transaction and view key, so any number of spend keys share it
+void findOutputsToSpendKeys(const ITransactionReader& tx, const Crypto::KeyDerivation& derivation,
+                            const std::unordered_set<Crypto::PublicKey>& spendKeys,
+                            std::unordered_map<Crypto::PublicKey, std::vector<uint32_t>>& outputs);
+
 } //namespace CryptoNote
@@ -0,0 +1,142 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockTransactionsPrefetcher.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+#include "Common/ThreadPool.h"
+#include "CryptoNoteCore/Currency.h"
+
+namespace CryptoNote {
+
+namespace {
+
+enum class SlotState {
+  PENDING,
+  RUNNING,
+  DONE
+};
+
+bool extractTransactions(const Currency& currency, const RawBlock& rawBlock, std::vector<CachedTransaction>& transactions) {
+  transactions.reserve(rawBlock.transactions.size());
+
+  try {
+    for (const auto& rawTransaction : rawBlock.transactions) {
+      if (rawTransaction.size() > currency.maxTxSize()) {
+        return false;
+      }
+
+      transactions.emplace_back(rawTransaction);
+      transactions.back().getTransactionHash();
+      transactions.back().getTransactionPrefixHash();
+    }
+  } catch (std::exception&) {
+    return false;
+  }
+
+  return true;
+}
+
+}
+
+struct BlockTransactionsPrefetcher::State {
+  struct Slot {
+    SlotState state = SlotState::PENDING;
+    bool valid = false;
+    std::vector<CachedTransaction> transactions;
+  };
+
+  State(const Currency& currency, const std::vector<RawBlock>& rawBlocks) :
+    currency(currency), rawBlocks(rawBlocks), slots(rawBlocks.size()), cancelled(false), running(0) {
+  }
+
+  // Does nothing if the slot is already claimed by another thread or the prefetcher is gone
+  void prepare(size_t blockIndex) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (cancelled || slots[blockIndex].state != SlotState::PENDING) {
+        return;
+      }
+
+      slots[blockIndex].state = SlotState::RUNNING;
+      ++running;
+    }
+
+    std::vector<CachedTransaction> transactions;
+    bool valid = extractTransactions(currency, rawBlocks[blockIndex], transactions);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      slots[blockIndex].transactions = std::move(transactions);
+      slots[blockIndex].valid = valid;
+      slots[blockIndex].state = SlotState::DONE;
+      --running;
+    }
+
+    changed.notify_all();
+  }
+
+  const Currency& currency;
+  const std::vector<RawBlock>& rawBlocks;
+  std::vector<Slot> slots;
+  bool cancelled;
+  size_t running;
+  std::mutex mutex;
+  std::condition_variable changed;
+};
+
+BlockTransactionsPrefetcher::BlockTransactionsPrefetcher(Common::ThreadPool* threadPool, const Currency& currency,
+                                                         const std::vector<RawBlock>& rawBlocks, size_t lookahead) :
+  m_threadPool(threadPool), m_lookahead(lookahead), m_scheduled(0), m_state(std::make_shared<State>(currency, rawBlocks)) {
+}
+
+BlockTransactionsPrefetcher::~BlockTransactionsPrefetcher() {
+  std::unique_lock<std::mutex> lock(m_state->mutex);
+  m_state->cancelled = true;
+  m_state->changed.wait(lock, [this] { return m_state->running == 0; });
+}
+
+bool BlockTransactionsPrefetcher::get(size_t blockIndex, std::vector<CachedTransaction>& transactions) {
+  schedule(std::min(blockIndex + m_lookahead + 1, m_state->slots.size()));
+
+  // Run it here if no worker has picked it up yet
+  m_state->prepare(blockIndex);
+
+  std::unique_lock<std::mutex> lock(m_state->mutex);
+  auto& slot = m_state->slots[blockIndex];
+  m_state->changed.wait(lock, [&slot] { return slot.state == SlotState::DONE; });
+
+  transactions = std::move(slot.transactions);
+  return slot.valid;
+}
+
+void BlockTransactionsPrefetcher::schedule(size_t endIndex) {
+  if (m_threadPool == nullptr || m_threadPool->getThreadCount() < 2) {
+    return;
+  }
+
+  auto state = m_state;
+  for (; m_scheduled < endIndex; ++m_scheduled) {
+    size_t blockIndex = m_scheduled;
+    m_threadPool->post([state, blockIndex] { state->prepare(blockIndex); });
+  }
+}
+
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CryptoNoteCore/CachedTransaction.h"
+
+namespace Common {
+  class ThreadPool;
+}
+
+namespace CryptoNote {
+
+class Currency;
+
+// Deserializes and hashes transactions of the blocks following the one being added to the core, so that the serial
+// Core::addBlock loop only applies blocks. rawBlocks must stay alive and unchanged until the prefetcher is destroyed,
+// except for blocks already taken with get().
+class BlockTransactionsPrefetcher {
+public:
+  BlockTransactionsPrefetcher(Common::ThreadPool* threadPool, const Currency& currency, const std::vector<RawBlock>& rawBlocks, size_t lookahead);
+  ~BlockTransactionsPrefetcher();
+
+  BlockTransactionsPrefetcher(const BlockTransactionsPrefetcher&) = delete;
+  BlockTransactionsPrefetcher& operator=(const BlockTransactionsPrefetcher&) = delete;
+
+  // Returns false if transactions of the block can't be deserialized, the core reports the error itself then.
+  bool get(size_t blockIndex, std::vector<CachedTransaction>& transactions);
+
+private:
+  struct State;
+
+  void schedule(size_t blockIndex);
+
+  Common::ThreadPool* m_threadPool;
+  size_t m_lookahead;
+  size_t m_scheduled;
+  std::shared_ptr<State> m_state;
+};
+
+}
@@ -149,4 +149,88 @@ namespace CryptoNote
     const static int ID = BC_COMMANDS_POOL_BASE + 8;
     typedef NOTIFY_REQUEST_TX_POOL_request request;
   };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // Announces a block without its transactions to peers of P2PProtocolVersion::V2 and newer, the block blob carries
+  // the transaction hashes and the receiver takes the transactions from its pool
+  struct NOTIFY_NEW_COMPACT_BLOCK_request {
+    std::string block;
+    uint32_t current_blockchain_height;
+    uint32_t hop;
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(block)
+      KV_MEMBER(current_blockchain_height)
+      KV_MEMBER(hop)
+    }
+  };
+
+  struct NOTIFY_NEW_COMPACT_BLOCK {
+    const static int ID = BC_COMMANDS_POOL_BASE + 9;
+    typedef NOTIFY_NEW_COMPACT_BLOCK_request request;
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_TXS_request {
+    Crypto::Hash block_hash;
+    std::vector<Crypto::Hash> txs;
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(block_hash)
+      serializeAsBinary(txs, "txs", s);
+    }
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_TXS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 10;
+    typedef NOTIFY_REQUEST_BLOCK_TXS_request request;
+  };
+
+  struct NOTIFY_RESPONSE_BLOCK_TXS_request {
+    Crypto::Hash block_hash;
+    std::vector<std::string> txs;
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(block_hash)
+      KV_MEMBER(txs)
+    }
+  };
+
+  struct NOTIFY_RESPONSE_BLOCK_TXS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 11;
+    typedef NOTIFY_RESPONSE_BLOCK_TXS_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // Hashes of transactions new to the sender's pool, sent in batches to peers of P2PProtocolVersion::V3 and newer
+  // instead of the transactions themselves
+  struct NOTIFY_TX_INVENTORY_request {
+    std::vector<Crypto::Hash> txs;
+
+    void serialize(ISerializer& s) {
+      serializeAsBinary(txs, "txs", s);
+    }
+  };
+
+  struct NOTIFY_TX_INVENTORY {
+    const static int ID = BC_COMMANDS_POOL_BASE + 12;
+    typedef NOTIFY_TX_INVENTORY_request request;
+  };
+
+  struct NOTIFY_REQUEST_TXS_request {
+    std::vector<Crypto::Hash> txs;
+
+    void serialize(ISerializer& s) {
+      serializeAsBinary(txs, "txs", s);
+    }
+  };
+
+  // Answered with NOTIFY_NEW_TRANSACTIONS carrying the requested transactions still in the pool
+  struct NOTIFY_REQUEST_TXS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 13;
+    typedef NOTIFY_REQUEST_TXS_request request;
+  };
 }
@@ -19,18 +19,28 @@
 
 #include "CryptoNoteProtocolHandler.h"
 
+#include <algorithm>
+#include <cstring>
 #include <future>
+#include <limits>
 #include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <Common/StringTools.h>
+#include <Common/ThreadPool.h>
+#include <Common/VectorOutputStream.h>
 #include <System/Dispatcher.h>
+#include <System/InterruptedException.h>
+#include <System/Timer.h>
 
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/VerificationContext.h"
+#include "CryptoNoteProtocol/BlockTransactionsPrefetcher.h"
+#include "crypto/random.h"
 #include "P2p/LevinProtocol.h"
+#include "Serialization/KVBinaryStreamWriter.h"
 
 using namespace Logging;
 using namespace Common;
@@ -39,6 +49,18 @@ namespace CryptoNote {
 
 namespace {
 
+// A generation takes half as many hashes as its table has slots, which keeps probe sequences short
+const size_t KNOWN_TRANSACTIONS_SLOTS = P2P_TX_INVENTORY_KNOWN_LIMIT;
+const unsigned KNOWN_TRANSACTIONS_SLOT_BITS = 14;
+static_assert(size_t(1) << KNOWN_TRANSACTIONS_SLOT_BITS == KNOWN_TRANSACTIONS_SLOTS, "P2P_TX_INVENTORY_KNOWN_LIMIT must be 2^KNOWN_TRANSACTIONS_SLOT_BITS");
+
+// Zero marks an empty slot
+uint64_t transactionFingerprint(const Crypto::Hash& hash) {
+  uint64_t fingerprint;
+  memcpy(&fingerprint, hash.data, sizeof(fingerprint));
+  return fingerprint != 0 ? fingerprint : 1;
+}
+
 template<class t_parametr>
 bool post_notify(IP2pEndpoint& p2p, typename t_parametr::request& arg, const CryptoNoteConnectionContext& context) {
   return p2p.invoke_notify_to_peer(t_parametr::ID, LevinProtocol::encode(arg), context);
@@ -49,15 +71,56 @@ void relay_post_notify(IP2pEndpoint& p2p, typename t_parametr::request& arg, con
   p2p.relay_notify_to_all(t_parametr::ID, LevinProtocol::encode(arg), excludeConnection);
 }
 
-std::vector<RawBlockLegacy> convertRawBlocksToRawBlocksLegacy(const std::vector<RawBlock>& rawBlocks) {
-  std::vector<RawBlockLegacy> legacy;
-  legacy.reserve(rawBlocks.size());
+// Enough of the context to log on behalf of the peer and report the outcome back to it
+CryptoNoteConnectionContext copyConnectionIdentity(const CryptoNoteConnectionContext& context) {
+  CryptoNoteConnectionContext identity;
+  identity.version = context.version;
+  identity.m_connection_id = context.m_connection_id;
+  identity.m_remote_ip = context.m_remote_ip;
+  identity.m_remote_port = context.m_remote_port;
+  identity.m_is_income = context.m_is_income;
+  identity.m_started = context.m_started;
+  identity.m_state = context.m_state;
+  return identity;
+}
+
+// Encodes NOTIFY_RESPONSE_GET_OBJECTS the way the serializer does, copying blobs from storage into the buffer once
+BinaryArray encodeGetObjectsResponse(const std::vector<RawBlockView>& blocks, const std::vector<Crypto::Hash>& missedHashes,
+                                     uint32_t currentBlockchainHeight) {
+  size_t size = missedHashes.size() * sizeof(Crypto::Hash) + 128;
+  for (const auto& block : blocks) {
+    size += block.block.size + 16;
+    for (const auto& transaction : block.transactions) {
+      size += transaction.size + 4;
+    }
+  }
+
+  BinaryArray buffer;
+  buffer.reserve(size);
+  Common::VectorOutputStream stream(buffer);
+  KVBinaryStreamWriter writer(stream);
+
+  writer.beginObject((blocks.empty() ? 0 : 1) + (missedHashes.empty() ? 0 : 1) + 1);
+  if (!blocks.empty()) {
+    writer.beginObjectArray("blocks", blocks.size());
+    for (const auto& block : blocks) {
+      writer.beginObject(block.transactions.empty() ? 1 : 2);
+      writer.writeString("block", block.block.data, block.block.size);
+      if (!block.transactions.empty()) {
+        writer.beginStringArray("txs", block.transactions.size());
+        for (const auto& transaction : block.transactions) {
+          writer.writeString(transaction.data, transaction.size);
+        }
+      }
+    }
+  }
 
-  for (const auto& rawBlock: rawBlocks) {
-    legacy.emplace_back(RawBlockLegacy{rawBlock.block, rawBlock.transactions});
+  if (!missedHashes.empty()) {
+    writer.writeString("missed_ids", missedHashes.data(), missedHashes.size() * sizeof(Crypto::Hash));
   }
 
-  return legacy;
+  writer.writeUint32("current_blockchain_height", currentBlockchainHeight);
+  return buffer;
 }
 
 std::vector<RawBlock> convertRawBlocksLegacyToRawBlocks(const std::vector<RawBlockLegacy>& legacy) {
@@ -131,6 +194,7 @@ static inline void serialize(NOTIFY_RESPONSE_GET_OBJECTS_request& request, ISeri
 
 CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, System::Dispatcher& dispatcher, ICore& rcore, IP2pEndpoint* p_net_layout, Logging::ILogger& log) :
   m_dispatcher(dispatcher),
+  m_threadPool(nullptr),
   m_currency(currency),
   m_core(rcore),
   m_p2p(p_net_layout),
@@ -138,6 +202,10 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, S
   m_stop(false),
   m_observedHeight(0),
   m_blockchainHeight(0),
+  m_bufferedBlocksSize(0),
+  m_announcing(false),
+  m_expiringRequests(false),
+  m_relayContextGroup(dispatcher),
   m_peersCount(0),
   logger(log, "protocol") {
 
@@ -160,6 +228,10 @@ void CryptoNoteProtocolHandler::set_p2p_endpoint(IP2pEndpoint* p2p) {
     m_p2p = &m_p2p_stub;
 }
 
+void CryptoNoteProtocolHandler::setThreadPool(Common::ThreadPool* threadPool) {
+  m_threadPool = threadPool;
+}
+
 void CryptoNoteProtocolHandler::onConnectionOpened(CryptoNoteConnectionContext& context) {
 }
 
@@ -183,10 +255,25 @@ void CryptoNoteProtocolHandler::onConnectionClosed(CryptoNoteConnectionContext&
     m_peersCount--;
     m_observerManager.notify(&ICryptoNoteProtocolObserver::peerCountUpdated, m_peersCount.load());
   }
+
+  m_peerInventories.erase(context.m_connection_id);
+  retryTransactionRequests(&context.m_connection_id);
+  retryBlockTransactionRequests(&context.m_connection_id);
+
+  // Blocks this peer was downloading go back to the other synchronizing peers
+  if (!context.m_requested_objects.empty() || !m_bufferedBlocks.empty()) {
+    for (const auto& hash : context.m_requested_objects) {
+      m_pendingBlocks.erase(hash);
+    }
+
+    discardBufferedBlocks(context.m_connection_id);
+    resumeSynchronization(context.m_connection_id);
+  }
 }
 
 void CryptoNoteProtocolHandler::stop() {
   m_stop = true;
+  m_relayContextGroup.interrupt();
 }
 
 bool CryptoNoteProtocolHandler::start_sync(CryptoNoteConnectionContext& context) {
@@ -309,6 +396,11 @@ int CryptoNoteProtocolHandler::handleCommand(bool is_notify, int command, const
     HANDLE_NOTIFY(NOTIFY_REQUEST_CHAIN, handle_request_chain)
     HANDLE_NOTIFY(NOTIFY_RESPONSE_CHAIN_ENTRY, handle_response_chain_entry)
     HANDLE_NOTIFY(NOTIFY_REQUEST_TX_POOL, handleRequestTxPool)
+    HANDLE_NOTIFY(NOTIFY_NEW_COMPACT_BLOCK, handleNotifyNewCompactBlock)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_BLOCK_TXS, handleRequestBlockTxs)
+    HANDLE_NOTIFY(NOTIFY_RESPONSE_BLOCK_TXS, handleResponseBlockTxs)
+    HANDLE_NOTIFY(NOTIFY_TX_INVENTORY, handleTxInventory)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_TXS, handleRequestTxs)
 
   default:
     handled = false;
@@ -327,81 +419,643 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
     return 1;
   }
 
-  auto result = m_core.addBlock(RawBlock{ arg.b.block, arg.b.transactions });
+  processNewBlock(arg, context);
+  return 1;
+}
+
+void CryptoNoteProtocolHandler::processNewBlock(NOTIFY_NEW_BLOCK::request& arg, CryptoNoteConnectionContext& context,
+                                                 const CachedBlock* cachedBlock) {
+  auto result = cachedBlock != nullptr ? m_core.addBlock(*cachedBlock, RawBlock{ arg.b.block, arg.b.transactions }) :
+                                         m_core.addBlock(RawBlock{ arg.b.block, arg.b.transactions });
   if (result == error::AddBlockErrorCondition::BLOCK_ADDED) {
     if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED) {
       ++arg.hop;
-      //TODO: Add here announce protocol usage
-      relay_post_notify<NOTIFY_NEW_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-      // relay_block(arg, context);
+      relayNewBlock(arg, &context.m_connection_id);
       requestMissingPoolTransactions(context);
     } else if (result == error::AddBlockErrorCode::ADDED_TO_MAIN) {
       ++arg.hop;
-      //TODO: Add here announce protocol usage
-      relay_post_notify<NOTIFY_NEW_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-      // relay_block(arg, context);
+      relayNewBlock(arg, &context.m_connection_id);
     } else if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE) {
       logger(Logging::TRACE) << context << "Block added as alternative";
     } else {
       logger(Logging::TRACE) << context << "Block already exists";
     }
   } else if (result == error::AddBlockErrorCondition::BLOCK_REJECTED) {
-    context.m_state = CryptoNoteConnectionContext::state_synchronizing;
-    NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
-    r.block_ids = m_core.buildSparseChain();
-    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
-    post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+    requestChain(context);
   } else {
     logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection: " << result.message();
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
   }
+}
+
+void CryptoNoteProtocolHandler::relayNewBlock(const NOTIFY_NEW_BLOCK::request& arg, const net_connection_id* excludeConnection) {
+  NOTIFY_NEW_COMPACT_BLOCK::request compact;
+  compact.block.assign(arg.b.block.begin(), arg.b.block.end());
+  compact.current_blockchain_height = arg.current_blockchain_height;
+  compact.hop = arg.hop;
+
+  m_p2p->relay_notify_to_versions(NOTIFY_NEW_BLOCK::ID, LevinProtocol::encode(arg), excludeConnection,
+                                  P2PProtocolVersion::V0, P2PProtocolVersion::V1);
+  m_p2p->relay_notify_to_versions(NOTIFY_NEW_COMPACT_BLOCK::ID, LevinProtocol::encode(compact), excludeConnection,
+                                  P2PProtocolVersion::V2, std::numeric_limits<uint8_t>::max());
+}
+
+void CryptoNoteProtocolHandler::requestChain(CryptoNoteConnectionContext& context) {
+  context.m_state = CryptoNoteConnectionContext::state_synchronizing;
+  NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
+  r.block_ids = m_core.buildSparseChain();
+  logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+  post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+}
+
+int CryptoNoteProtocolHandler::handleNotifyNewCompactBlock(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_NEW_COMPACT_BLOCK (hop " << arg.hop << ")";
+  updateObservedHeight(arg.current_blockchain_height, context);
+  context.m_remote_blockchain_height = arg.current_blockchain_height;
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  BinaryArray block(arg.block.begin(), arg.block.end());
+  std::unique_ptr<BlockTemplate> blockTemplatePointer(new BlockTemplate());
+  BlockTemplate& blockTemplate = *blockTemplatePointer;
+  if (!fromBinaryArray(blockTemplate, block)) {
+    logger(Logging::DEBUGGING) << context << "Failed to parse compact block, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  // Kept with the pending block, so the proof of work checked here is not computed again by the core
+  std::unique_ptr<CachedBlock> cachedBlock(new CachedBlock(blockTemplate));
+  Crypto::Hash blockHash = cachedBlock->getBlockHash();
+  if (m_core.hasBlock(blockHash)) {
+    return 1;
+  }
 
+  auto pendingIt = m_pendingCompactBlocks.find(blockHash);
+  if (pendingIt != m_pendingCompactBlocks.end()) {
+    PendingCompactBlock& pending = pendingIt->second;
+    if (pending.connectionId != context.m_connection_id && pending.announcers.size() < P2P_COMPACT_BLOCK_ANNOUNCERS_LIMIT &&
+        std::find(pending.announcers.begin(), pending.announcers.end(), context.m_connection_id) == pending.announcers.end()) {
+      pending.announcers.push_back(context.m_connection_id);
+    }
+
+    return 1;
+  }
+
+  // Blocks we can't connect would be rejected anyway, synchronize instead of fetching their transactions
+  if (!m_core.hasBlock(blockTemplate.previousBlockHash)) {
+    requestChain(context);
+    return 1;
+  }
+
+  std::vector<BinaryArray> poolTransactions;
+  std::vector<Crypto::Hash> missedHashes;
+  m_core.getPoolTransactions(blockTemplate.transactionHashes, poolTransactions, missedHashes);
+
+  NOTIFY_NEW_BLOCK::request fullBlock;
+  fullBlock.b.block = std::move(block);
+  fullBlock.current_blockchain_height = arg.current_blockchain_height;
+  fullBlock.hop = arg.hop;
+
+  // Missed hashes keep the block order, so the transactions found fill the gaps between them
+  fullBlock.b.transactions.reserve(blockTemplate.transactionHashes.size());
+  size_t poolIndex = 0;
+  size_t missedIndex = 0;
+  for (const auto& transactionHash : blockTemplate.transactionHashes) {
+    if (missedIndex < missedHashes.size() && missedHashes[missedIndex] == transactionHash) {
+      fullBlock.b.transactions.emplace_back();
+      ++missedIndex;
+    } else {
+      fullBlock.b.transactions.push_back(std::move(poolTransactions[poolIndex++]));
+    }
+  }
+
+  if (missedHashes.empty()) {
+    processNewBlock(fullBlock, context, cachedBlock.get());
+    return 1;
+  }
+
+  size_t peerPendingCount = 0;
+  for (const auto& entry : m_pendingCompactBlocks) {
+    if (entry.second.connectionId == context.m_connection_id) {
+      ++peerPendingCount;
+    }
+  }
+
+  // Only blocks extending our chain are held while their transactions arrive, the others come with the chain
+  if (blockTemplate.previousBlockHash != m_core.getTopBlockHash() || missedHashes.size() > CURRENCY_PROTOCOL_MAX_OBJECT_REQUEST_COUNT ||
+      m_pendingCompactBlocks.size() >= P2P_COMPACT_BLOCKS_PENDING_LIMIT || peerPendingCount >= P2P_COMPACT_BLOCKS_PENDING_PER_PEER_LIMIT) {
+    requestChain(context);
+    return 1;
+  }
+
+  if (!m_currency.checkProofOfWork(*cachedBlock, m_core.getDifficultyForNextBlock())) {
+    logger(Logging::DEBUGGING) << context << "Compact block " << blockHash << " has insufficient proof of work, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_BLOCK_TXS: " << missedHashes.size() << " of "
+    << blockTemplate.transactionHashes.size() << " transactions";
+
+  PendingCompactBlock pending;
+  pending.connectionId = context.m_connection_id;
+  pending.requestTime = std::chrono::steady_clock::now();
+  pending.block = std::move(fullBlock.b.block);
+  pending.blockTemplate = std::move(blockTemplatePointer);
+  pending.cachedBlock = std::move(cachedBlock);
+  pending.transactions = std::move(fullBlock.b.transactions);
+  pending.currentBlockchainHeight = arg.current_blockchain_height;
+  pending.hop = arg.hop;
+  m_pendingCompactBlocks.emplace(blockHash, std::move(pending));
+
+  NOTIFY_REQUEST_BLOCK_TXS::request request;
+  request.block_hash = blockHash;
+  request.txs = std::move(missedHashes);
+  post_notify<NOTIFY_REQUEST_BLOCK_TXS>(*m_p2p, request, context);
+  scheduleRequestExpiry();
   return 1;
 }
 
+int CryptoNoteProtocolHandler::handleRequestBlockTxs(int command, NOTIFY_REQUEST_BLOCK_TXS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_BLOCK_TXS: " << arg.txs.size() << " transactions";
+
+  if (arg.txs.size() > CURRENCY_PROTOCOL_MAX_OBJECT_REQUEST_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Requested " << arg.txs.size() << " block transactions, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  // Only transactions of the announced block are served, anything else would be a free lookup in our storage. They
+  // are taken from the stored block as they are, its transaction hashes are those of the raw transactions.
+  std::vector<RawBlockView> blocks;
+  std::vector<Crypto::Hash> missedHashes;
+  m_core.getBlockViews({arg.block_hash}, blocks, missedHashes);
+
+  NOTIFY_RESPONSE_BLOCK_TXS::request response;
+  response.block_hash = arg.block_hash;
+  if (!blocks.empty()) {
+    std::unordered_set<Crypto::Hash> requested(arg.txs.begin(), arg.txs.end());
+    for (const auto& transaction : blocks.front().transactions) {
+      if (requested.count(Crypto::cn_fast_hash(transaction.data, transaction.size)) != 0) {
+        response.txs.emplace_back(reinterpret_cast<const char*>(transaction.data), transaction.size);
+      }
+    }
+  }
+
+  post_notify<NOTIFY_RESPONSE_BLOCK_TXS>(*m_p2p, response, context);
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handleResponseBlockTxs(int command, NOTIFY_RESPONSE_BLOCK_TXS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_BLOCK_TXS: " << arg.txs.size() << " transactions";
+
+  // Every announcer has the transactions, a late response from one asked before completes the block as well
+  auto it = m_pendingCompactBlocks.find(arg.block_hash);
+  if (it == m_pendingCompactBlocks.end()) {
+    return 1;
+  }
+
+  if (it->second.connectionId != context.m_connection_id &&
+      std::find(it->second.announcers.begin(), it->second.announcers.end(), context.m_connection_id) == it->second.announcers.end()) {
+    return 1;
+  }
+
+  PendingCompactBlock pending = std::move(it->second);
+  m_pendingCompactBlocks.erase(it);
+
+  std::unordered_map<Crypto::Hash, size_t> missingIndexes;
+  for (size_t i = 0; i < pending.transactions.size(); ++i) {
+    if (pending.transactions[i].empty()) {
+      missingIndexes.emplace(pending.blockTemplate->transactionHashes[i], i);
+    }
+  }
+
+  for (const auto& transaction : arg.txs) {
+    BinaryArray transactionBinaryArray(transaction.begin(), transaction.end());
+    auto missing = missingIndexes.find(getBinaryArrayHash(transactionBinaryArray));
+    if (missing != missingIndexes.end()) {
+      pending.transactions[missing->second] = std::move(transactionBinaryArray);
+      missingIndexes.erase(missing);
+    }
+  }
+
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  if (!missingIndexes.empty()) {
+    logger(Logging::DEBUGGING) << context << "Peer did not send " << missingIndexes.size()
+      << " transactions of compact block " << arg.block_hash << ", synchronizing";
+    requestChain(context);
+    return 1;
+  }
+
+  NOTIFY_NEW_BLOCK::request fullBlock;
+  fullBlock.b.block = std::move(pending.block);
+  fullBlock.b.transactions = std::move(pending.transactions);
+  fullBlock.current_blockchain_height = pending.currentBlockchainHeight;
+  fullBlock.hop = pending.hop;
+  processNewBlock(fullBlock, context, pending.cachedBlock.get());
+  return 1;
+}
+
+void CryptoNoteProtocolHandler::scheduleRequestExpiry() {
+  if (!m_expiringRequests && !m_stop) {
+    m_expiringRequests = true;
+    m_relayContextGroup.spawn([this] { expireRequests(); });
+  }
+}
+
+void CryptoNoteProtocolHandler::expireRequests() {
+  BOOST_SCOPE_EXIT_ALL(this) { m_expiringRequests = false; };
+
+  while (!m_pendingCompactBlocks.empty() || !m_requestedTransactions.empty() || !m_pendingBlocks.empty()) {
+    try {
+      System::Timer(m_dispatcher).sleep(std::chrono::seconds(1));
+    } catch (System::InterruptedException&) {
+      return;
+    }
+
+    retryBlockTransactionRequests(nullptr);
+    retryTransactionRequests(nullptr);
+    expireBlockRequests();
+  }
+}
+
+void CryptoNoteProtocolHandler::retryBlockTransactionRequests(const boost::uuids::uuid* closedConnection) {
+  auto now = std::chrono::steady_clock::now();
+  auto timeout = std::chrono::seconds(P2P_BLOCK_TXS_REQUEST_TIMEOUT);
+
+  std::unordered_map<boost::uuids::uuid, std::vector<Crypto::Hash>, boost::hash<boost::uuids::uuid>> retries;
+  std::unordered_set<boost::uuids::uuid, boost::hash<boost::uuids::uuid>> stalledConnections;
+  for (auto it = m_pendingCompactBlocks.begin(); it != m_pendingCompactBlocks.end();) {
+    PendingCompactBlock& pending = it->second;
+    if (closedConnection != nullptr) {
+      pending.announcers.erase(std::remove(pending.announcers.begin(), pending.announcers.end(), *closedConnection), pending.announcers.end());
+    }
+
+    bool closed = closedConnection != nullptr && pending.connectionId == *closedConnection;
+    if (!closed && now - pending.requestTime < timeout) {
+      ++it;
+      continue;
+    }
+
+    if (pending.announcers.empty()) {
+      if (!closed) {
+        stalledConnections.insert(pending.connectionId);
+      }
+
+      it = m_pendingCompactBlocks.erase(it);
+      continue;
+    }
+
+    pending.connectionId = pending.announcers.front();
+    pending.announcers.erase(pending.announcers.begin());
+    pending.requestTime = now;
+    retries[pending.connectionId].push_back(it->first);
+    ++it;
+  }
+
+  if (retries.empty() && stalledConnections.empty()) {
+    return;
+  }
+
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    auto retry = retries.find(context.m_connection_id);
+    if (retry != retries.end()) {
+      for (const auto& blockHash : retry->second) {
+        const PendingCompactBlock& pending = m_pendingCompactBlocks.at(blockHash);
+        NOTIFY_REQUEST_BLOCK_TXS::request request;
+        request.block_hash = blockHash;
+        for (size_t i = 0; i < pending.transactions.size(); ++i) {
+          if (pending.transactions[i].empty()) {
+            request.txs.push_back(pending.blockTemplate->transactionHashes[i]);
+          }
+        }
+
+        logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_BLOCK_TXS: " << request.txs.size() << " transactions, retry";
+        post_notify<NOTIFY_REQUEST_BLOCK_TXS>(*m_p2p, request, context);
+      }
+    }
+
+    // Blocks nobody else announced are fetched with the chain from the stalled peer
+    if (stalledConnections.count(context.m_connection_id) != 0 && context.m_state == CryptoNoteConnectionContext::state_normal) {
+      logger(Logging::DEBUGGING) << context << "Block transactions request timed out, synchronizing";
+      requestChain(context);
+    }
+  });
+}
+
 int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIFY_NEW_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context) {
   logger(Logging::TRACE) << context << "NOTIFY_NEW_TRANSACTIONS";
 
   if (context.m_state != CryptoNoteConnectionContext::state_normal)
     return 1;
 
-  for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end();) {
-    if (!m_core.addTransactionToPool(*tx_blob_it)) {
-      logger(Logging::DEBUGGING) << context << "Tx verification failed";
-      tx_blob_it = arg.txs.erase(tx_blob_it);
+  PeerInventory* inventory = nullptr;
+  if (context.version >= P2PProtocolVersion::V3) {
+    inventory = &m_peerInventories[context.m_connection_id];
+  }
+
+  for (const auto& transaction : arg.txs) {
+    Crypto::Hash hash = getBinaryArrayHash(transaction);
+    auto requested = m_requestedTransactions.find(hash);
+    if (requested != m_requestedTransactions.end()) {
+      releaseTransactionRequest(requested->second.connectionId);
+      m_requestedTransactions.erase(requested);
+    }
+
+    if (inventory != nullptr) {
+      inventory->knownTransactions.insert(hash);
+    }
+  }
+
+  auto added = m_core.addTransactionsToPool(arg.txs);
+  std::vector<BinaryArray> addedTransactions;
+  for (size_t i = 0; i < arg.txs.size(); ++i) {
+    if (added[i]) {
+      addedTransactions.push_back(std::move(arg.txs[i]));
     } else {
-      ++tx_blob_it;
+      logger(Logging::DEBUGGING) << context << "Tx verification failed";
     }
   }
 
+  arg.txs.swap(addedTransactions);
+
   if (arg.txs.size()) {
-    //TODO: add announce usage here
-    relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id);
+    relayNewTransactions(arg.txs, &context.m_connection_id);
   }
 
   return true;
 }
 
+int CryptoNoteProtocolHandler::handleTxInventory(int command, NOTIFY_TX_INVENTORY::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_TX_INVENTORY: txs.size() = " << arg.txs.size();
+
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  if (arg.txs.size() > P2P_TX_INVENTORY_MAX_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Announced " << arg.txs.size() << " transactions, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  auto& inventory = m_peerInventories[context.m_connection_id];
+  std::vector<Crypto::Hash> requested;
+  for (const auto& hash : arg.txs) {
+    inventory.knownTransactions.insert(hash);
+    if (m_core.hasTransaction(hash)) {
+      continue;
+    }
+
+    // Already requested from another peer, this one is asked if that request stalls
+    auto it = m_requestedTransactions.find(hash);
+    if (it != m_requestedTransactions.end()) {
+      RequestedTransaction& requested = it->second;
+      if (requested.connectionId != context.m_connection_id && requested.announcers.size() < P2P_TX_ANNOUNCERS_LIMIT &&
+          std::find(requested.announcers.begin(), requested.announcers.end(), context.m_connection_id) == requested.announcers.end()) {
+        requested.announcers.push_back(context.m_connection_id);
+      }
+
+      continue;
+    }
+
+    // Beyond the limits the transaction is left to the pool synchronization after the next block
+    if (inventory.requestedCount >= P2P_TX_REQUESTS_PER_PEER_LIMIT || m_requestedTransactions.size() >= P2P_TX_REQUESTS_LIMIT) {
+      continue;
+    }
+
+    m_requestedTransactions.emplace(hash, RequestedTransaction{context.m_connection_id, now, {}});
+    ++inventory.requestedCount;
+    requested.push_back(hash);
+  }
+
+  if (!requested.empty()) {
+    requestTransactions(context, requested);
+    scheduleRequestExpiry();
+  }
+
+  return 1;
+}
+
+// Split so that no request exceeds what the peer serves
+void CryptoNoteProtocolHandler::requestTransactions(CryptoNoteConnectionContext& context, const std::vector<Crypto::Hash>& hashes) {
+  for (size_t offset = 0; offset < hashes.size(); offset += CURRENCY_PROTOCOL_MAX_OBJECT_REQUEST_COUNT) {
+    NOTIFY_REQUEST_TXS::request request;
+    request.txs.assign(hashes.begin() + offset, hashes.begin() + std::min(offset + CURRENCY_PROTOCOL_MAX_OBJECT_REQUEST_COUNT, hashes.size()));
+    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_TXS: txs.size() = " << request.txs.size();
+    post_notify<NOTIFY_REQUEST_TXS>(*m_p2p, request, context);
+  }
+}
+
+int CryptoNoteProtocolHandler::handleRequestTxs(int command, NOTIFY_REQUEST_TXS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_TXS: txs.size() = " << arg.txs.size();
+
+  if (arg.txs.size() > CURRENCY_PROTOCOL_MAX_OBJECT_REQUEST_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Requested " << arg.txs.size() << " transactions, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  NOTIFY_NEW_TRANSACTIONS::request response;
+  std::vector<Crypto::Hash> missedHashes;
+  m_core.getPoolTransactions(arg.txs, response.txs, missedHashes);
+  if (!response.txs.empty()) {
+    post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, response, context);
+  }
+
+  return 1;
+}
+
+void CryptoNoteProtocolHandler::relayNewTransactions(const std::vector<BinaryArray>& transactions, const net_connection_id* excludeConnection) {
+  m_p2p->relay_notify_to_versions(NOTIFY_NEW_TRANSACTIONS::ID, LevinProtocol::encode(NOTIFY_NEW_TRANSACTIONS::request{transactions}),
+                                  excludeConnection, P2PProtocolVersion::V0, P2PProtocolVersion::V2);
+
+  std::vector<Crypto::Hash> hashes;
+  hashes.reserve(transactions.size());
+  for (const auto& transaction : transactions) {
+    hashes.push_back(getBinaryArrayHash(transaction));
+  }
+
+  bool queued = false;
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (peerId == 0 || context.version < P2PProtocolVersion::V3 ||
+        (excludeConnection != nullptr && context.m_connection_id == *excludeConnection)) {
+      return;
+    }
+
+    auto& inventory = m_peerInventories[context.m_connection_id];
+    for (const auto& hash : hashes) {
+      if (!inventory.knownTransactions.contains(hash)) {
+        inventory.knownTransactions.insert(hash);
+        inventory.pendingAnnouncements.push_back(hash);
+        queued = true;
+      }
+    }
+  });
+
+  if (queued && !m_announcing && !m_stop) {
+    m_announcing = true;
+    m_relayContextGroup.spawn([this] { announceTransactions(); });
+  }
+}
+
+void CryptoNoteProtocolHandler::announceTransactions() {
+  BOOST_SCOPE_EXIT_ALL(this) { m_announcing = false; };
+
+  try {
+    System::Timer(m_dispatcher).sleep(std::chrono::milliseconds(P2P_TX_INVENTORY_INTERVAL));
+  } catch (System::InterruptedException&) {
+    return;
+  }
+
+  m_p2p->for_each_connection([this](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    auto it = m_peerInventories.find(context.m_connection_id);
+    if (it == m_peerInventories.end() || it->second.pendingAnnouncements.empty()) {
+      return;
+    }
+
+    // Split so that no announcement exceeds what the peer accepts
+    std::vector<Crypto::Hash> announcements;
+    announcements.swap(it->second.pendingAnnouncements);
+    for (size_t offset = 0; offset < announcements.size(); offset += P2P_TX_INVENTORY_MAX_COUNT) {
+      NOTIFY_TX_INVENTORY::request notification;
+      notification.txs.assign(announcements.begin() + offset,
+                              announcements.begin() + std::min(offset + P2P_TX_INVENTORY_MAX_COUNT, announcements.size()));
+      logger(Logging::TRACE) << context << "-->>NOTIFY_TX_INVENTORY: txs.size() = " << notification.txs.size();
+      post_notify<NOTIFY_TX_INVENTORY>(*m_p2p, notification, context);
+    }
+  });
+}
+
+void CryptoNoteProtocolHandler::retryTransactionRequests(const boost::uuids::uuid* closedConnection) {
+  auto now = std::chrono::steady_clock::now();
+  auto timeout = std::chrono::seconds(P2P_TX_REQUEST_TIMEOUT);
+
+  std::unordered_map<boost::uuids::uuid, std::vector<Crypto::Hash>, boost::hash<boost::uuids::uuid>> retries;
+  for (auto it = m_requestedTransactions.begin(); it != m_requestedTransactions.end();) {
+    RequestedTransaction& requested = it->second;
+    if (closedConnection != nullptr) {
+      requested.announcers.erase(std::remove(requested.announcers.begin(), requested.announcers.end(), *closedConnection),
+                                 requested.announcers.end());
+    }
+
+    bool closed = closedConnection != nullptr && requested.connectionId == *closedConnection;
+    if (!closed && now - requested.time < timeout) {
+      ++it;
+      continue;
+    }
+
+    if (!closed) {
+      releaseTransactionRequest(requested.connectionId);
+    }
+
+    // Announcers already asked for as much as they are allowed are skipped
+    auto next = std::find_if(requested.announcers.begin(), requested.announcers.end(), [this](const boost::uuids::uuid& announcer) {
+      auto inventory = m_peerInventories.find(announcer);
+      return inventory != m_peerInventories.end() && inventory->second.requestedCount < P2P_TX_REQUESTS_PER_PEER_LIMIT;
+    });
+
+    if (next == requested.announcers.end()) {
+      it = m_requestedTransactions.erase(it);
+      continue;
+    }
+
+    requested.connectionId = *next;
+    requested.announcers.erase(requested.announcers.begin(), next + 1);
+    requested.time = now;
+    ++m_peerInventories[requested.connectionId].requestedCount;
+    retries[requested.connectionId].push_back(it->first);
+    ++it;
+  }
+
+  if (retries.empty()) {
+    return;
+  }
+
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    auto retry = retries.find(context.m_connection_id);
+    if (retry != retries.end()) {
+      logger(Logging::TRACE) << context << "Retrying " << retry->second.size() << " transaction requests";
+      requestTransactions(context, retry->second);
+    }
+  });
+}
+
+void CryptoNoteProtocolHandler::releaseTransactionRequest(const boost::uuids::uuid& connectionId) {
+  auto inventory = m_peerInventories.find(connectionId);
+  if (inventory != m_peerInventories.end() && inventory->second.requestedCount > 0) {
+    --inventory->second.requestedCount;
+  }
+}
+
+CryptoNoteProtocolHandler::KnownTransactions::KnownTransactions() :
+  m_multiplier(Crypto::rand<uint64_t>() | 1), m_currentCount(0) {
+}
+
+bool CryptoNoteProtocolHandler::KnownTransactions::contains(const Crypto::Hash& hash) const {
+  uint64_t fingerprint = transactionFingerprint(hash);
+  return (!m_current.empty() && m_current[findSlot(m_current, fingerprint)] == fingerprint) ||
+    (!m_previous.empty() && m_previous[findSlot(m_previous, fingerprint)] == fingerprint);
+}
+
+// Tables are allocated on first use, peers that never relay transactions don't pay for them
+void CryptoNoteProtocolHandler::KnownTransactions::insert(const Crypto::Hash& hash) {
+  if (m_current.empty()) {
+    m_current.resize(KNOWN_TRANSACTIONS_SLOTS);
+  }
+
+  uint64_t fingerprint = transactionFingerprint(hash);
+  size_t slot = findSlot(m_current, fingerprint);
+  if (m_current[slot] == fingerprint) {
+    return;
+  }
+
+  if (m_currentCount >= KNOWN_TRANSACTIONS_SLOTS / 2) {
+    m_previous.swap(m_current);
+    m_current.assign(KNOWN_TRANSACTIONS_SLOTS, 0);
+    m_currentCount = 0;
+    slot = findSlot(m_current, fingerprint);
+  }
+
+  m_current[slot] = fingerprint;
+  ++m_currentCount;
+}
+
+// Returns the slot holding the fingerprint or the empty one ending its probe sequence
+size_t CryptoNoteProtocolHandler::KnownTransactions::findSlot(const std::vector<uint64_t>& table, uint64_t fingerprint) const {
+  size_t slot = static_cast<size_t>((fingerprint * m_multiplier) >> (64 - KNOWN_TRANSACTIONS_SLOT_BITS));
+  while (table[slot] != 0 && table[slot] != fingerprint) {
+    slot = (slot + 1) & (KNOWN_TRANSACTIONS_SLOTS - 1);
+  }
+
+  return slot;
+}
+
 int CryptoNoteProtocolHandler::handle_request_get_objects(int command, NOTIFY_REQUEST_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context) {
   logger(Logging::TRACE) << context << "NOTIFY_REQUEST_GET_OBJECTS";
-  NOTIFY_RESPONSE_GET_OBJECTS::request rsp;
-  //if (!m_core.handle_get_objects(arg, rsp)) {
-  //  logger(Logging::ERROR) << context << "failed to handle request NOTIFY_REQUEST_GET_OBJECTS, dropping connection";
-  //  context.m_state = CryptoNoteConnectionContext::state_shutdown;
-  //}
+  if (arg.blocks.size() > CURRENCY_PROTOCOL_MAX_OBJECT_REQUEST_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Requested " << arg.blocks.size() << " blocks, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
 
-  rsp.current_blockchain_height = m_core.getTopBlockIndex() + 1;
-  std::vector<RawBlock> rawBlocks;
-  m_core.getBlocks(arg.blocks, rawBlocks, rsp.missed_ids);
+  uint32_t currentBlockchainHeight = m_core.getTopBlockIndex() + 1;
+  std::vector<RawBlockView> blocks;
+  std::vector<Crypto::Hash> missedHashes;
+  m_core.getBlockViews(arg.blocks, blocks, missedHashes);
   if (!arg.txs.empty()) {
     logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << context << "NOTIFY_RESPONSE_GET_OBJECTS: request.txs.empty() != true";
   }
 
-  rsp.blocks = convertRawBlocksToRawBlocksLegacy(rawBlocks);
-
-  logger(Logging::TRACE) << context << "-->>NOTIFY_RESPONSE_GET_OBJECTS: blocks.size()=" << rsp.blocks.size() << ", txs.size()=" << rsp.txs.size()
-    << ", rsp.m_current_blockchain_height=" << rsp.current_blockchain_height << ", missed_ids.size()=" << rsp.missed_ids.size();
-  post_notify<NOTIFY_RESPONSE_GET_OBJECTS>(*m_p2p, rsp, context);
+  logger(Logging::TRACE) << context << "-->>NOTIFY_RESPONSE_GET_OBJECTS: blocks.size()=" << blocks.size() << ", txs.size()=0"
+    << ", rsp.m_current_blockchain_height=" << currentBlockchainHeight << ", missed_ids.size()=" << missedHashes.size();
+  m_p2p->invoke_notify_to_peer(NOTIFY_RESPONSE_GET_OBJECTS::ID, encodeGetObjectsResponse(blocks, missedHashes, currentBlockchainHeight), context);
   return 1;
 }
 
@@ -424,17 +1078,42 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
 
   std::vector<RawBlock> rawBlocks = convertRawBlocksLegacyToRawBlocks(arg.blocks);
 
+  // The request is answered, whatever comes below. Blocks that are kept get marked again.
+  for (const auto& hash : context.m_requested_objects) {
+    m_pendingBlocks.erase(hash);
+  }
+
+  // Parse and hash the whole batch up front, the checks below still go through it in order
+  std::vector<uint8_t> parsed(rawBlocks.size(), 0);
+  for (size_t index = 0; index < rawBlocks.size(); ++index) {
+    cachedBlocks.emplace_back(blockTemplates[index]);
+  }
+
+  auto parseBlock = [&] (size_t index) {
+    parsed[index] = fromBinaryArray(blockTemplates[index], rawBlocks[index].block);
+    if (parsed[index]) {
+      cachedBlocks[index].getBlockHash();
+    }
+  };
+
+  if (m_threadPool != nullptr) {
+    m_threadPool->parallelFor(rawBlocks.size(), parseBlock);
+  } else {
+    for (size_t index = 0; index < rawBlocks.size(); ++index) {
+      parseBlock(index);
+    }
+  }
+
   for (size_t index = 0; index < rawBlocks.size(); ++index) {
-    if (!fromBinaryArray(blockTemplates[index], rawBlocks[index].block)) {
+    if (!parsed[index]) {
       logger(Logging::ERROR) << context << "sent wrong block: failed to parse and validate block: \r\n"
         << toHex(rawBlocks[index].block) << "\r\n dropping connection";
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
 
-    cachedBlocks.emplace_back(blockTemplates[index]);
     if (index == 1) {
-      if (m_core.hasBlock(cachedBlocks.back().getBlockHash())) { //TODO
+      if (m_core.hasBlock(cachedBlocks[index].getBlockHash())) { //TODO
         context.m_state = CryptoNoteConnectionContext::state_idle;
         context.m_needed_objects.clear();
         context.m_requested_objects.clear();
@@ -443,18 +1122,18 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
       }
     }
 
-    auto req_it = context.m_requested_objects.find(cachedBlocks.back().getBlockHash());
+    auto req_it = context.m_requested_objects.find(cachedBlocks[index].getBlockHash());
     if (req_it == context.m_requested_objects.end()) {
-      logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(cachedBlocks.back().getBlockHash())
+      logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(cachedBlocks[index].getBlockHash())
         << " wasn't requested, dropping connection";
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
 
-    if (cachedBlocks.back().getBlock().transactionHashes.size() != rawBlocks[index].transactions.size()) {
+    if (cachedBlocks[index].getBlock().transactionHashes.size() != rawBlocks[index].transactions.size()) {
       logger(Logging::ERROR) << context
-        << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(cachedBlocks.back().getBlockHash())
-        << ", transactionHashes.size()=" << cachedBlocks.back().getBlock().transactionHashes.size()
+        << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(cachedBlocks[index].getBlockHash())
+        << ", transactionHashes.size()=" << cachedBlocks[index].getBlock().transactionHashes.size()
         << " mismatch with block_complete_entry.m_txs.size()=" << rawBlocks[index].transactions.size()
         << ", dropping connection";
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
@@ -472,29 +1151,227 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
     return 1;
   }
 
-  {
+  size_t responseSize = 0;
+  for (const auto& rawBlock : rawBlocks) {
+    responseSize += rawBlock.block.size();
+    for (const auto& transaction : rawBlock.transactions) {
+      responseSize += transaction.size();
+    }
+  }
+
+  updateBlocksBatchSize(context, rawBlocks.size(), responseSize);
+  precomputeProofOfWork(cachedBlocks);
+
+  for (const auto& cachedBlock : cachedBlocks) {
+    m_pendingBlocks.insert(cachedBlock.getBlockHash());
+  }
+
+  // A batch that came from another peer faster than the one before it waits until the chain reaches it
+  if (!rawBlocks.empty() && !m_core.hasBlock(cachedBlocks.front().getBlock().previousBlockHash) &&
+      isBlockExpected(context, cachedBlocks.front().getBlock().previousBlockHash)) {
+    const Crypto::Hash previousBlockHash = cachedBlocks.front().getBlock().previousBlockHash;
+    auto buffered = m_bufferedBlocks.find(previousBlockHash);
+    if (buffered == m_bufferedBlocks.end()) {
+      logger(Logging::TRACE) << context << "Buffering " << rawBlocks.size() << " blocks received ahead of the chain top";
+      m_bufferedBlocksSize += responseSize;
+      m_bufferedBlocks.emplace(previousBlockHash, BufferedBlocks{
+        copyConnectionIdentity(context), std::move(blockTemplates), std::move(cachedBlocks), std::move(rawBlocks), responseSize});
+    } else {
+      // Blocks following the same one are buffered already, only the first copy is kept
+      std::unordered_set<Crypto::Hash> bufferedHashes;
+      for (const auto& cachedBlock : buffered->second.cachedBlocks) {
+        bufferedHashes.insert(cachedBlock.getBlockHash());
+      }
+
+      for (const auto& cachedBlock : cachedBlocks) {
+        if (bufferedHashes.count(cachedBlock.getBlockHash()) == 0) {
+          m_pendingBlocks.erase(cachedBlock.getBlockHash());
+        }
+      }
+    }
+  } else {
     int result = processObjects(context, std::move(rawBlocks), cachedBlocks);
+    for (const auto& cachedBlock : cachedBlocks) {
+      m_pendingBlocks.erase(cachedBlock.getBlockHash());
+    }
+
     if (result != 0) {
+      resumeSynchronization(context.m_connection_id);
       return result;
     }
   }
 
+  processBufferedBlocks(context);
+
   logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new index = " << m_core.getTopBlockIndex();
   if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
     request_missing_objects(context, true);
   }
 
+  resumeSynchronization(context.m_connection_id);
   return 1;
 }
 
+void CryptoNoteProtocolHandler::updateBlocksBatchSize(CryptoNoteConnectionContext& context, size_t blockCount, size_t responseSize) {
+  if (blockCount == 0) {
+    return;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - context.m_blocks_request_time).count();
+
+  // Grow while full batches come back well within the response time, shrink when they take longer than that
+  size_t batchSize = context.m_blocks_batch_size;
+  if (static_cast<uint64_t>(elapsed) > BLOCKS_SYNCHRONIZING_RESPONSE_TIME) {
+    batchSize /= 2;
+  } else if (blockCount >= batchSize && static_cast<uint64_t>(elapsed) < BLOCKS_SYNCHRONIZING_RESPONSE_TIME / 2) {
+    batchSize *= 2;
+  }
+
+  size_t averageBlockSize = std::max<size_t>(responseSize / blockCount, 1);
+  batchSize = std::min(batchSize, BLOCKS_SYNCHRONIZING_MAX_RESPONSE_SIZE / averageBlockSize);
+  batchSize = std::max(std::min(batchSize, BLOCKS_SYNCHRONIZING_MAX_COUNT), BLOCKS_SYNCHRONIZING_MIN_COUNT);
+
+  if (batchSize != context.m_blocks_batch_size) {
+    logger(Logging::TRACE) << context << "Blocks batch size changed from " << context.m_blocks_batch_size << " to " << batchSize
+      << ", response time " << elapsed << " ms, average block size " << averageBlockSize;
+    context.m_blocks_batch_size = batchSize;
+  }
+}
+
+bool CryptoNoteProtocolHandler::isBlockExpected(const CryptoNoteConnectionContext& context, const Crypto::Hash& blockHash) const {
+  return m_pendingBlocks.count(blockHash) != 0 ||
+    std::find(context.m_needed_objects.begin(), context.m_needed_objects.end(), blockHash) != context.m_needed_objects.end();
+}
+
+void CryptoNoteProtocolHandler::processBufferedBlocks(CryptoNoteConnectionContext& context) {
+  for (;;) {
+    auto it = m_bufferedBlocks.find(m_core.getTopBlockHash());
+    if (it == m_bufferedBlocks.end() || m_stop) {
+      break;
+    }
+
+    BufferedBlocks blocks = std::move(it->second);
+    m_bufferedBlocks.erase(it);
+    m_bufferedBlocksSize -= blocks.size;
+
+    // origin is a copy, the peer may disconnect while the blocks are added
+    processObjects(blocks.origin, std::move(blocks.rawBlocks), blocks.cachedBlocks);
+    for (const auto& cachedBlock : blocks.cachedBlocks) {
+      m_pendingBlocks.erase(cachedBlock.getBlockHash());
+    }
+
+    // The connection handled now closes when its handler returns, any other one is dropped by the node server
+    if (blocks.origin.m_state == CryptoNoteConnectionContext::state_shutdown) {
+      discardBufferedBlocks(blocks.origin.m_connection_id);
+      if (blocks.origin.m_connection_id == context.m_connection_id) {
+        context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      } else {
+        m_p2p->for_each_connection([this, &blocks](CryptoNoteConnectionContext& origin, PeerIdType peerId) {
+          if (origin.m_connection_id == blocks.origin.m_connection_id) {
+            m_p2p->drop_connection(origin);
+          }
+        });
+      }
+    }
+  }
+}
+
+void CryptoNoteProtocolHandler::discardBufferedBlocks(const boost::uuids::uuid& connectionId) {
+  for (auto it = m_bufferedBlocks.begin(); it != m_bufferedBlocks.end();) {
+    if (it->second.origin.m_connection_id == connectionId) {
+      for (const auto& cachedBlock : it->second.cachedBlocks) {
+        m_pendingBlocks.erase(cachedBlock.getBlockHash());
+      }
+
+      m_bufferedBlocksSize -= it->second.size;
+      it = m_bufferedBlocks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+// Peers that had nothing to request because other peers were downloading their blocks
+void CryptoNoteProtocolHandler::resumeSynchronization(const boost::uuids::uuid& excludedConnectionId) {
+  if (m_stop) {
+    return;
+  }
+
+  m_p2p->for_each_connection([this, &excludedConnectionId](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (context.m_connection_id != excludedConnectionId &&
+        context.m_state == CryptoNoteConnectionContext::state_synchronizing &&
+        context.m_requested_objects.empty() && !context.m_needed_objects.empty()) {
+      request_missing_objects(context, true);
+    }
+  });
+}
+
+void CryptoNoteProtocolHandler::expireBlockRequests() {
+  auto now = std::chrono::steady_clock::now();
+  auto timeout = std::chrono::milliseconds(BLOCKS_SYNCHRONIZING_REQUEST_TIMEOUT);
+
+  std::vector<boost::uuids::uuid> expiredConnections;
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (context.m_state != CryptoNoteConnectionContext::state_synchronizing || context.m_requested_objects.empty() ||
+        now - context.m_blocks_request_time < timeout) {
+      return;
+    }
+
+    logger(Logging::DEBUGGING) << context << "Blocks request timed out, dropping connection";
+    for (const auto& hash : context.m_requested_objects) {
+      m_pendingBlocks.erase(hash);
+    }
+
+    context.m_requested_objects.clear();
+    m_p2p->drop_connection(context);
+    expiredConnections.push_back(context.m_connection_id);
+  });
+
+  for (const auto& connectionId : expiredConnections) {
+    resumeSynchronization(connectionId);
+  }
+}
+
+// Slow hashes of the whole batch are computed here in parallel, Core::addBlock then only compares them with the
+// difficulty. The hashing scratchpad is thread local, so every worker uses its own.
+void CryptoNoteProtocolHandler::precomputeProofOfWork(const std::vector<CachedBlock>& cachedBlocks) {
+  if (m_threadPool == nullptr || m_threadPool->getThreadCount() < 2) {
+    return;
+  }
+
+  std::vector<size_t> blocksToHash;
+  for (size_t index = 0; index < cachedBlocks.size(); ++index) {
+    if (!m_core.isInCheckpointZone(cachedBlocks[index].getBlockIndex())) {
+      blocksToHash.push_back(index);
+    }
+  }
+
+  m_threadPool->parallelFor(blocksToHash.size(), [&] (size_t index) {
+    try {
+      cachedBlocks[blocksToHash[index]].getBlockLongHash();
+    } catch (std::exception&) {
+      // Unknown block version, left to the core to reject
+    }
+  });
+}
+
 int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& context, std::vector<RawBlock>&& rawBlocks, const std::vector<CachedBlock>& cachedBlocks) {
   assert(rawBlocks.size() == cachedBlocks.size());
+  size_t lookahead = m_threadPool != nullptr ? 2 * m_threadPool->getThreadCount() : 0;
+  BlockTransactionsPrefetcher prefetcher(m_threadPool, m_currency, rawBlocks, lookahead);
   for (size_t index = 0; index < rawBlocks.size(); ++index) {
     if (m_stop) {
       break;
     }
 
-    auto addResult = m_core.addBlock(cachedBlocks[index], std::move(rawBlocks[index]));
+    std::vector<CachedTransaction> transactions;
+    std::error_code addResult;
+    if (prefetcher.get(index, transactions)) {
+      addResult = m_core.addBlock(cachedBlocks[index], std::move(rawBlocks[index]), std::move(transactions));
+    } else {
+      addResult = m_core.addBlock(cachedBlocks[index], std::move(rawBlocks[index]));
+    }
+
     if (addResult == error::AddBlockErrorCondition::BLOCK_VALIDATION_FAILED ||
         addResult == error::AddBlockErrorCondition::TRANSACTION_VALIDATION_FAILED ||
         addResult == error::AddBlockErrorCondition::DESERIALIZATION_FAILED) {
@@ -546,19 +1423,45 @@ bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionCont
   if (context.m_needed_objects.size()) {
     //we know objects that we need, request this objects
     NOTIFY_REQUEST_GET_OBJECTS::request req;
-    size_t count = 0;
+    bool bufferFull = m_bufferedBlocksSize >= BLOCKS_SYNCHRONIZING_MAX_BUFFERED_SIZE;
+    bool skipped = false;
     auto it = context.m_needed_objects.begin();
 
-    while (it != context.m_needed_objects.end() && count < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT) {
-      if (!(check_having_blocks && m_core.hasBlock(*it))) {
+    // Request the first contiguous span no other peer is downloading. Skipped blocks stay in the list in case that
+    // peer fails. With the buffer full only the span right after the known blocks is requested.
+    while (it != context.m_needed_objects.end() && req.blocks.size() < context.m_blocks_batch_size) {
+      if (check_having_blocks && m_core.hasBlock(*it)) {
+        it = context.m_needed_objects.erase(it);
+      } else if (m_pendingBlocks.count(*it) != 0) {
+        if (!req.blocks.empty()) {
+          break;
+        }
+
+        skipped = true;
+        ++it;
+      } else if (skipped && bufferFull) {
+        break;
+      } else {
         req.blocks.push_back(*it);
-        ++count;
         context.m_requested_objects.insert(*it);
+        m_pendingBlocks.insert(*it);
+        it = context.m_needed_objects.erase(it);
+      }
+    }
+
+    if (req.blocks.empty()) {
+      if (context.m_needed_objects.empty()) {
+        return request_missing_objects(context, check_having_blocks);
       }
-      it = context.m_needed_objects.erase(it);
+
+      logger(Logging::TRACE) << context << "Waiting for blocks downloaded from other peers";
+      return true;
     }
+
     logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size();
+    context.m_blocks_request_time = std::chrono::steady_clock::now();
     post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
+    scheduleRequestExpiry();
   } else if (context.m_last_response_height < context.m_remote_blockchain_height - 1) {//we have to fetch more objects ids, request blockchain entry
 
     NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
@@ -677,13 +1580,15 @@ int CryptoNoteProtocolHandler::handleRequestTxPool(int command, NOTIFY_REQUEST_T
 
 
 void CryptoNoteProtocolHandler::relayBlock(NOTIFY_NEW_BLOCK::request& arg) {
-  auto buf = LevinProtocol::encode(arg);
-  m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_BLOCK::ID, buf);
+  m_dispatcher.remoteSpawn([this, arg] {
+    relayNewBlock(arg, nullptr);
+  });
 }
 
 void CryptoNoteProtocolHandler::relayTransactions(const std::vector<BinaryArray>& transactions) {
-  auto buf = LevinProtocol::encode(NOTIFY_NEW_TRANSACTIONS::request{transactions});
-  m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf);
+  m_dispatcher.remoteSpawn([this, transactions] {
+    relayNewTransactions(transactions, nullptr);
+  });
 }
 
 void CryptoNoteProtocolHandler::requestMissingPoolTransactions(const CryptoNoteConnectionContext& context) {
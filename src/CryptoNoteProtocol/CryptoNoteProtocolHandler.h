@@ -19,8 +19,15 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/functional/hash.hpp>
 
 #include <Common/ObserverManager.h>
+#include <System/ContextGroup.h>
 
 #include "CryptoNoteCore/ICore.h"
 
@@ -35,6 +42,10 @@
 
 #include <Logging/LoggerRef.h>
 
+namespace Common {
+  class ThreadPool;
+}
+
 namespace System {
   class Dispatcher;
 }
@@ -54,6 +65,8 @@ namespace CryptoNote
     virtual bool removeObserver(ICryptoNoteProtocolObserver* observer) override;
 
     void set_p2p_endpoint(IP2pEndpoint* p2p);
+    // Blocks received during synchronization are parsed and hashed on this pool if set, pool must outlive the handler
+    void setThreadPool(Common::ThreadPool* threadPool);
     // ICore& get_core() { return m_core; }
     virtual bool isSynchronized() const override { return m_synchronized; }
     void log_connections();
@@ -81,6 +94,11 @@ namespace CryptoNote
     int handle_request_chain(int command, NOTIFY_REQUEST_CHAIN::request& arg, CryptoNoteConnectionContext& context);
     int handle_response_chain_entry(int command, NOTIFY_RESPONSE_CHAIN_ENTRY::request& arg, CryptoNoteConnectionContext& context);
     int handleRequestTxPool(int command, NOTIFY_REQUEST_TX_POOL::request& arg, CryptoNoteConnectionContext& context);
+    int handleNotifyNewCompactBlock(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, CryptoNoteConnectionContext& context);
+    int handleRequestBlockTxs(int command, NOTIFY_REQUEST_BLOCK_TXS::request& arg, CryptoNoteConnectionContext& context);
+    int handleResponseBlockTxs(int command, NOTIFY_RESPONSE_BLOCK_TXS::request& arg, CryptoNoteConnectionContext& context);
+    int handleTxInventory(int command, NOTIFY_TX_INVENTORY::request& arg, CryptoNoteConnectionContext& context);
+    int handleRequestTxs(int command, NOTIFY_REQUEST_TXS::request& arg, CryptoNoteConnectionContext& context);
 
     //----------------- i_cryptonote_protocol ----------------------------------
     virtual void relayBlock(NOTIFY_NEW_BLOCK::request& arg) override;
@@ -88,16 +106,100 @@ namespace CryptoNote
 
     //----------------------------------------------------------------------------------
     uint32_t get_current_blockchain_height();
+    // cachedBlock, if given, carries the hashes already computed for the block
+    void processNewBlock(NOTIFY_NEW_BLOCK::request& arg, CryptoNoteConnectionContext& context, const CachedBlock* cachedBlock = nullptr);
+    // Compact announcements go to peers supporting them, full blocks to the others
+    void relayNewBlock(const NOTIFY_NEW_BLOCK::request& arg, const net_connection_id* excludeConnection);
+    void requestChain(CryptoNoteConnectionContext& context);
+    // Pushed to peers not supporting inventory relay, queued for the next inventory batch of the others
+    void relayNewTransactions(const std::vector<BinaryArray>& transactions, const net_connection_id* excludeConnection);
+    void announceTransactions();
     bool request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks);
     bool on_connection_synchronized();
     void updateObservedHeight(uint32_t peerHeight, const CryptoNoteConnectionContext& context);
     void recalculateMaxObservedHeight(const CryptoNoteConnectionContext& context);
+    void precomputeProofOfWork(const std::vector<CachedBlock>& cachedBlocks);
     int processObjects(CryptoNoteConnectionContext& context, std::vector<RawBlock>&& rawBlocks, const std::vector<CachedBlock>& cachedBlocks);
+    void updateBlocksBatchSize(CryptoNoteConnectionContext& context, size_t blockCount, size_t responseSize);
+    bool isBlockExpected(const CryptoNoteConnectionContext& context, const Crypto::Hash& blockHash) const;
+    // context is the connection whose handler calls it
+    void processBufferedBlocks(CryptoNoteConnectionContext& context);
+    void discardBufferedBlocks(const boost::uuids::uuid& connectionId);
+    void resumeSynchronization(const boost::uuids::uuid& excludedConnectionId);
+    // Returns blocks requested from peers that did not answer in time to the other synchronizing peers
+    void expireBlockRequests();
+    void scheduleRequestExpiry();
+    void expireRequests();
+    // Moves timed out requests, and those of closedConnection if given, to the next announcer
+    void retryBlockTransactionRequests(const boost::uuids::uuid* closedConnection);
+    void retryTransactionRequests(const boost::uuids::uuid* closedConnection);
+    void releaseTransactionRequest(const boost::uuids::uuid& connectionId);
+    void requestTransactions(CryptoNoteConnectionContext& context, const std::vector<Crypto::Hash>& hashes);
     Logging::LoggerRef logger;
 
   private:
+    // Blocks downloaded ahead of the chain top from one of the synchronizing peers
+    struct BufferedBlocks {
+      CryptoNoteConnectionContext origin;
+      std::vector<BlockTemplate> blockTemplates;
+      std::vector<CachedBlock> cachedBlocks;
+      std::vector<RawBlock> rawBlocks;
+      size_t size;
+    };
+
+    // Compact block waiting for the transactions missing from the pool, requested from one of its announcers at a
+    // time. Kept only for blocks with a valid proof of work on top of our chain.
+    struct PendingCompactBlock {
+      boost::uuids::uuid connectionId;
+      std::chrono::steady_clock::time_point requestTime;
+      // Asked in turn when the request times out or its connection closes
+      std::vector<boost::uuids::uuid> announcers;
+      BinaryArray block;
+      // cachedBlock refers to blockTemplate, both are on the heap so that moving the entry keeps them valid
+      std::unique_ptr<BlockTemplate> blockTemplate;
+      std::unique_ptr<CachedBlock> cachedBlock;
+      // In block order, empty for the missing ones
+      std::vector<BinaryArray> transactions;
+      uint32_t currentBlockchainHeight;
+      uint32_t hop;
+    };
+
+    // Transaction hashes a peer has or was told about, the older generation is dropped when the newer one fills up.
+    // A generation is a fixed table of P2P_TX_INVENTORY_KNOWN_LIMIT 64 bit fingerprints, so a peer costs 256 KiB at most
+    // whatever it announces.
+    class KnownTransactions {
+    public:
+      KnownTransactions();
+      bool contains(const Crypto::Hash& hash) const;
+      void insert(const Crypto::Hash& hash);
+
+    private:
+      // Secret per peer, so that announced hashes can't be picked to collide in the tables
+      uint64_t m_multiplier;
+      size_t m_currentCount;
+      std::vector<uint64_t> m_current;
+      std::vector<uint64_t> m_previous;
+
+      size_t findSlot(const std::vector<uint64_t>& table, uint64_t fingerprint) const;
+    };
+
+    struct PeerInventory {
+      KnownTransactions knownTransactions;
+      std::vector<Crypto::Hash> pendingAnnouncements;
+      // Transactions requested from the peer and not received yet
+      size_t requestedCount = 0;
+    };
+
+    // Transaction requested from its first announcer, other announcers are asked in turn when the request times out or
+    // its connection closes
+    struct RequestedTransaction {
+      boost::uuids::uuid connectionId;
+      std::chrono::steady_clock::time_point time;
+      std::vector<boost::uuids::uuid> announcers;
+    };
 
     System::Dispatcher& m_dispatcher;
+    Common::ThreadPool* m_threadPool;
     ICore& m_core;
     const Currency& m_currency;
 
@@ -112,6 +214,19 @@ namespace CryptoNote
     mutable std::mutex m_blockchainHeightMutex;
     uint32_t m_blockchainHeight;
 
+    // Keyed by the previous block hash of the first block in the batch
+    std::unordered_map<Crypto::Hash, BufferedBlocks> m_bufferedBlocks;
+    size_t m_bufferedBlocksSize;
+    // Blocks requested from or delivered by some peer and not added to the core yet, other peers don't request them
+    std::unordered_set<Crypto::Hash> m_pendingBlocks;
+    std::unordered_map<Crypto::Hash, PendingCompactBlock> m_pendingCompactBlocks;
+
+    std::unordered_map<boost::uuids::uuid, PeerInventory, boost::hash<boost::uuids::uuid>> m_peerInventories;
+    std::unordered_map<Crypto::Hash, RequestedTransaction> m_requestedTransactions;
+    bool m_announcing;
+    bool m_expiringRequests;
+    System::ContextGroup m_relayContextGroup;
+
     std::atomic<size_t> m_peersCount;
     Tools::ObserverManager<ICryptoNoteProtocolObserver> m_observerManager;
   };
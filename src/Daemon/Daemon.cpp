@@ -35,6 +35,7 @@
 #include "Common/StdOutputStream.h"
 #include "Common/StdInputStream.h"
 #include "Common/PathTools.h"
+#include "Common/ThreadPool.h"
 #include "Common/Util.h"
 #include "crypto/hash.h"
 #include "CryptoNoteCheckpoints.h"
@@ -44,6 +45,7 @@
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/DatabaseBlockchainCache.h"
 #include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
+#include "CryptoNoteCore/FileMappedMainChainStorage.h"
 #include "CryptoNoteCore/MainChainStorage.h"
 #include "CryptoNoteCore/MinerConfig.h"
 #include "CryptoNoteCore/RocksDBWrapper.h"
@@ -198,6 +200,7 @@ int main(int argc, char* argv[])
     command_line::add_arg(desc_cmd_sett, arg_genesis_block_reward_address);
     command_line::add_arg(desc_cmd_sett, arg_load_checkpoints);
 
+    CoreConfig::initOptions(desc_cmd_sett);
     RpcServerConfig::initOptions(desc_cmd_sett);
     NetNodeConfig::initOptions(desc_cmd_sett);
     DataBaseConfig::initOptions(desc_cmd_sett);
@@ -355,6 +358,7 @@ int main(int argc, char* argv[])
 
 
     System::Dispatcher dispatcher;
+    Common::ThreadPool threadPool(coreConfig.validationThreads);
     logger(INFO) << "Initializing core...";
     CryptoNote::Core ccore(
       currency,
@@ -362,14 +366,22 @@ int main(int argc, char* argv[])
       std::move(checkpoints),
       dispatcher,
       std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, logger.getLogger())),
-      createSwappedMainChainStorage(data_dir_path.string(), currency));
+      coreConfig.mappedBlocksStorage ? createFileMappedMainChainStorage(data_dir_path.string(), currency) :
+                                       createSwappedMainChainStorage(data_dir_path.string(), currency));
 
+    ccore.setThreadPool(&threadPool);
     ccore.load();
     logger(INFO) << "Core initialized OK";
 
     CryptoNote::CryptoNoteProtocolHandler cprotocol(currency, dispatcher, ccore, nullptr, logManager);
+    cprotocol.setThreadPool(&threadPool);
     CryptoNote::NodeServer p2psrv(dispatcher, cprotocol, logManager);
+    Common::ThreadPool rpcThreadPool(rpcConfig.getThreads() + 1);
     CryptoNote::RpcServer rpcServer(dispatcher, logManager, ccore, p2psrv, cprotocol);
+    rpcServer.setThreadPool(&rpcThreadPool);
+    if (rpcConfig.isEnabledScanning()) {
+      rpcServer.enableScanning();
+    }
 
     cprotocol.set_p2p_endpoint(&p2psrv);
     DaemonCommandsHandler dch(ccore, p2psrv, logManager, &rpcServer);
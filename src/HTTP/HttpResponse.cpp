@@ -78,7 +78,11 @@ void HttpResponse::addHeader(const std::string& name, const std::string& value)
 }
 
 void HttpResponse::setBody(const std::string& b) {
-  body = b;
+  setBody(std::string(b));
+}
+
+void HttpResponse::setBody(std::string&& b) {
+  body = std::move(b);
   if (!body.empty()) {
     headers["Content-Length"] = std::to_string(body.size());
   } else {
@@ -693,7 +693,7 @@ std::error_code InProcessNode::doQueryBlocksLite(std::vector<Crypto::Hash>&& kno
   uint32_t currentHeight, fullOffset;
   std::vector<CryptoNote::BlockShortInfo> entries;
 
-  if (!core.queryBlocksLite(knownBlockIds, timestamp, startHeight, currentHeight, fullOffset, entries)) {
+  if (!core.queryBlocksLite(knownBlockIds, timestamp, true, startHeight, currentHeight, fullOffset, entries)) {
     return make_error_code(CryptoNote::error::INTERNAL_NODE_ERROR);
   }
 
@@ -709,10 +709,13 @@ std::error_code InProcessNode::doQueryBlocksLite(std::vector<Crypto::Hash>&& kno
       }
     }
 
+    bse.baseTransactionGlobalIndexes = entry.baseTransactionGlobalIndexes;
+
     for (const auto& tsi : entry.txPrefixes) {
       TransactionShortInfo tpi;
       tpi.txId = tsi.txHash;
       tpi.txPrefix = tsi.txPrefix;
+      tpi.globalIndexes = tsi.globalIndexes;
 
       bse.txsShortInfo.push_back(std::move(tpi));
     }
@@ -657,6 +657,7 @@ std::error_code NodeRpcProxy::doQueryBlocksLite(const std::vector<Crypto::Hash>&
 
   req.blockIds = knownBlockIds;
   req.timestamp = timestamp;
+  req.includeGlobalIndexes = true;
 
   m_logger(TRACE) << "Send queryblockslite.bin request, timestamp " << req.timestamp;
   std::error_code ec = binaryCommand("queryblockslite.bin", req, rsp);
@@ -681,10 +682,13 @@ std::error_code NodeRpcProxy::doQueryBlocksLite(const std::vector<Crypto::Hash>&
       bse.hasBlock = true;
     }
 
-    for (const auto& txp: item.txPrefixes) {
+    bse.baseTransactionGlobalIndexes = std::move(item.baseTransactionGlobalIndexes);
+
+    for (auto& txp: item.txPrefixes) {
       TransactionShortInfo tsi;
       tsi.txId = txp.txHash;
       tsi.txPrefix = txp.txPrefix;
+      tsi.globalIndexes = std::move(txp.globalIndexes);
       bse.txsShortInfo.push_back(std::move(tsi));
     }
 
@@ -17,12 +17,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <list>
 #include <ostream>
 #include <unordered_set>
 
 #include <boost/uuid/uuid.hpp>
 #include "Common/StringTools.h"
+#include "CryptoNoteConfig.h"
 #include "crypto/hash.h"
 
 namespace CryptoNote {
@@ -50,6 +52,8 @@ struct CryptoNoteConnectionContext {
   std::unordered_set<Crypto::Hash> m_requested_objects;
   uint32_t m_remote_blockchain_height = 0;
   uint32_t m_last_response_height = 0;
+  size_t m_blocks_batch_size = BLOCKS_SYNCHRONIZING_DEFAULT_COUNT;
+  std::chrono::steady_clock::time_point m_blocks_request_time;
 };
 
 inline std::string get_protocol_state_string(CryptoNoteConnectionContext::state s) {
@@ -27,6 +27,8 @@ const uint32_t LEVIN_PACKET_REQUEST = 0x00000001;
 const uint32_t LEVIN_PACKET_RESPONSE = 0x00000002;
 const uint32_t LEVIN_DEFAULT_MAX_PACKET_SIZE = 100000000;      //100MB by default
 const uint32_t LEVIN_PROTOCOL_VER_1 = 1;
+// Larger bodies are written right after the header instead of being copied next to it
+const size_t LEVIN_MAX_COALESCED_BODY_SIZE = 16 * 1024;
 
 #pragma pack(push)
 #pragma pack(1)
@@ -60,15 +62,7 @@ void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool n
   head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
   head.m_flags = LEVIN_PACKET_REQUEST;
 
-  // write header and body in one operation
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
-
-  Common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  writePacket(&head, sizeof(head), out);
 }
 
 bool LevinProtocol::readCommand(Command& cmd) {
@@ -113,12 +107,23 @@ void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t
   head.m_flags = LEVIN_PACKET_RESPONSE;
   head.m_return_code = returnCode;
 
+  writePacket(&head, sizeof(head), out);
+}
+
+void LevinProtocol::writePacket(const void* head, size_t headSize, const BinaryArray& body) {
+  if (body.size() > LEVIN_MAX_COALESCED_BODY_SIZE) {
+    writeStrict(static_cast<const uint8_t*>(head), headSize);
+    writeStrict(body.data(), body.size());
+    return;
+  }
+
+  // write header and body in one operation
   BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
+  writeBuffer.reserve(headSize + body.size());
 
   Common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
+  stream.writeSome(head, headSize);
+  stream.writeSome(body.data(), body.size());
 
   writeStrict(writeBuffer.data(), writeBuffer.size());
 }
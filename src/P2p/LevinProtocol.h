@@ -20,7 +20,7 @@
 #include "CryptoNote.h"
 #include <Common/MemoryInputStream.h>
 #include <Common/VectorOutputStream.h>
-#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryInputBufferSerializer.h"
 #include "Serialization/KVBinaryOutputStreamSerializer.h"
 
 namespace System {
@@ -83,8 +83,7 @@ public:
   template <typename T>
   static bool decode(const BinaryArray& buf, T& value) {
     try {
-      Common::MemoryInputStream stream(buf.data(), buf.size());
-      KVBinaryInputStreamSerializer serializer(stream);
+      KVBinaryInputBufferSerializer serializer(buf.data(), buf.size());
       serialize(value, serializer);
     } catch (std::exception&) {
       return false;
@@ -107,6 +106,7 @@ private:
 
   bool readStrict(uint8_t* ptr, size_t size);
   void writeStrict(const uint8_t* ptr, size_t size);
+  void writePacket(const void* head, size_t headSize, const BinaryArray& body);
   System::TcpConnection& m_conn;
 };
 
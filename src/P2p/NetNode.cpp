@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <limits>
 
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
@@ -105,6 +106,7 @@ std::string print_peerlist_to_string(const std::list<PeerlistEntry>& pl) {
   //-----------------------------------------------------------------------------------
 
   bool P2pConnectionContext::pushMessage(P2pMessage&& msg) {
+    // Shared payloads are accounted in full, the limit bounds what a slow peer keeps alive rather than what it owns
     writeQueueSize += msg.size();
 
     if (writeQueueSize > P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE) {
@@ -296,6 +298,17 @@ std::string print_peerlist_to_string(const std::list<PeerlistEntry>& pl) {
     }
   }
 
+  //-----------------------------------------------------------------------------------
+  void NodeServer::drop_connection(CryptoNoteConnectionContext& context) {
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+
+    // The handler only looks at the state after the next message, interrupting it stops a silent peer as well
+    auto it = m_connections.find(context.m_connection_id);
+    if (it != m_connections.end() && it->second.context != nullptr) {
+      safeInterrupt(it->second);
+    }
+  }
+
   //-----------------------------------------------------------------------------------
   void NodeServer::externalRelayNotifyToAll(int command, const BinaryArray& data_buff) {
     m_dispatcher.remoteSpawn([this, command, data_buff] {
@@ -590,7 +603,7 @@ std::string print_peerlist_to_string(const std::list<PeerlistEntry>& pl) {
   bool NodeServer::timedSync() {
     COMMAND_TIMED_SYNC::request arg = boost::value_initialized<COMMAND_TIMED_SYNC::request>();
     m_payload_handler.get_payload_sync_data(arg.payload_data);
-    auto cmdBuf = LevinProtocol::encode<COMMAND_TIMED_SYNC::request>(arg);
+    auto cmdBuf = std::make_shared<const BinaryArray>(LevinProtocol::encode<COMMAND_TIMED_SYNC::request>(arg));
 
     forEachConnection([&](P2pConnectionContext& conn) {
       if (conn.peerId &&
@@ -1025,13 +1038,18 @@ std::string print_peerlist_to_string(const std::list<PeerlistEntry>& pl) {
   //-----------------------------------------------------------------------------------
 
   void NodeServer::relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) {
+    relay_notify_to_versions(command, data_buff, excludeConnection, 0, std::numeric_limits<uint8_t>::max());
+  }
+
+  void NodeServer::relay_notify_to_versions(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection, uint8_t minVersion, uint8_t maxVersion) {
     net_connection_id excludeId = excludeConnection ? *excludeConnection : boost::value_initialized<net_connection_id>();
+    auto payload = std::make_shared<const BinaryArray>(data_buff);
 
     forEachConnection([&](P2pConnectionContext& conn) {
-      if (conn.peerId && conn.m_connection_id != excludeId &&
+      if (conn.peerId && conn.m_connection_id != excludeId && conn.version >= minVersion && conn.version <= maxVersion &&
           (conn.m_state == CryptoNoteConnectionContext::state_normal ||
            conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
-        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
+        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, payload));
       }
     });
   }
@@ -1043,7 +1061,7 @@ std::string print_peerlist_to_string(const std::list<PeerlistEntry>& pl) {
       return false;
     }
 
-    it->second.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
+    it->second.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, BinaryArray(buffer)));
 
     return true;
   }
@@ -1372,6 +1390,11 @@ std::string print_peerlist_to_string(const std::list<PeerlistEntry>& pl) {
         LevinProtocol::Command cmd;
 
         for (;;) {
+          // Dropped before its handler started
+          if (ctx.m_state == CryptoNoteConnectionContext::state_shutdown) {
+            break;
+          }
+
           if (ctx.m_state == CryptoNoteConnectionContext::state_sync_required) {
             ctx.m_state = CryptoNoteConnectionContext::state_synchronizing;
             m_payload_handler.start_sync(ctx);
@@ -1445,13 +1468,13 @@ std::string print_peerlist_to_string(const std::list<PeerlistEntry>& pl) {
           logger(DEBUGGING) << ctx << "msg " << msg.type << ':' << msg.command;
           switch (msg.type) {
           case P2pMessage::COMMAND:
-            proto.sendMessage(msg.command, msg.buffer, true);
+            proto.sendMessage(msg.command, *msg.buffer, true);
             break;
           case P2pMessage::NOTIFY:
-            proto.sendMessage(msg.command, msg.buffer, false);
+            proto.sendMessage(msg.command, *msg.buffer, false);
             break;
           case P2pMessage::REPLY:
-            proto.sendReply(msg.command, msg.buffer, msg.returnCode);
+            proto.sendReply(msg.command, *msg.buffer, msg.returnCode);
             break;
           default:
             assert(false);
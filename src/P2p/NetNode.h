@@ -19,6 +19,7 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
@@ -60,7 +61,12 @@ namespace CryptoNote
       NOTIFY
     };
 
-    P2pMessage(Type type, uint32_t command, const BinaryArray& buffer, int32_t returnCode = 0) :
+    P2pMessage(Type type, uint32_t command, BinaryArray&& buffer, int32_t returnCode = 0) :
+      type(type), command(command), buffer(std::make_shared<const BinaryArray>(std::move(buffer))), returnCode(returnCode) {
+    }
+
+    // The payload is shared, a message relayed to many connections is serialized and stored once
+    P2pMessage(Type type, uint32_t command, const std::shared_ptr<const BinaryArray>& buffer, int32_t returnCode = 0) :
       type(type), command(command), buffer(buffer), returnCode(returnCode) {
     }
 
@@ -69,12 +75,12 @@ namespace CryptoNote
     }
 
     size_t size() {
-      return buffer.size();
+      return buffer->size();
     }
 
     Type type;
     uint32_t command;
-    const BinaryArray buffer;
+    std::shared_ptr<const BinaryArray> buffer;
     int32_t returnCode;
   };
 
@@ -179,8 +185,10 @@ namespace CryptoNote
 
     //----------------- i_p2p_endpoint -------------------------------------------------------------
     virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) override;
+    virtual void relay_notify_to_versions(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection, uint8_t minVersion, uint8_t maxVersion) override;
     virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const CryptoNoteConnectionContext& context) override;
     virtual void for_each_connection(std::function<void(CryptoNote::CryptoNoteConnectionContext&, PeerIdType)> f) override;
+    virtual void drop_connection(CryptoNote::CryptoNoteConnectionContext& context) override;
     virtual void externalRelayNotifyToAll(int command, const BinaryArray& data_buff) override;
 
     //-----------------------------------------------------------------------------------------------
@@ -26,17 +26,23 @@ namespace CryptoNote {
 
   struct IP2pEndpoint {
     virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) = 0;
+    // Same as relay_notify_to_all, limited to peers speaking a protocol version in [minVersion, maxVersion]
+    virtual void relay_notify_to_versions(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection, uint8_t minVersion, uint8_t maxVersion) = 0;
     virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const CryptoNote::CryptoNoteConnectionContext& context) = 0;
     virtual uint64_t get_connections_count()=0;
     virtual void for_each_connection(std::function<void(CryptoNote::CryptoNoteConnectionContext&, PeerIdType)> f) = 0;
+    // Closes the connection even if the peer sends nothing more, unlike setting state_shutdown outside its handler
+    virtual void drop_connection(CryptoNote::CryptoNoteConnectionContext& context) = 0;
     // can be called from external threads
     virtual void externalRelayNotifyToAll(int command, const BinaryArray& data_buff) = 0;
   };
 
   struct p2p_endpoint_stub: public IP2pEndpoint {
     virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) override {}
+    virtual void relay_notify_to_versions(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection, uint8_t minVersion, uint8_t maxVersion) override {}
     virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const CryptoNote::CryptoNoteConnectionContext& context) override { return true; }
     virtual void for_each_connection(std::function<void(CryptoNote::CryptoNoteConnectionContext&, PeerIdType)> f) override {}
+    virtual void drop_connection(CryptoNote::CryptoNoteConnectionContext& context) override {}
     virtual uint64_t get_connections_count() override { return 0; }
     virtual void externalRelayNotifyToAll(int command, const BinaryArray& data_buff) override {}
   };
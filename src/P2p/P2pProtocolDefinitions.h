@@ -55,7 +55,11 @@ namespace CryptoNote
   enum P2PProtocolVersion : uint8_t {
     V0 = 0,
     V1 = 1,
-    CURRENT = V1
+    // Compact block relay
+    V2 = 2,
+    // Transaction inventory relay
+    V3 = 3,
+    CURRENT = V3
   };
 
   struct basic_node_data
@@ -24,6 +24,7 @@
 
 
 #include "Common/SignalHandler.h"
+#include "Common/ThreadPool.h"
 #include "Common/Util.h"
 #include "InProcessNode/InProcessNode.h"
 #include "Logging/LoggerRef.h"
@@ -34,6 +35,7 @@
 #include "CryptoNoteCore/DatabaseBlockchainCache.h"
 #include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
 #include "CryptoNoteCore/DataBaseConfig.h"
+#include "CryptoNoteCore/FileMappedMainChainStorage.h"
 #include "CryptoNoteCore/MainChainStorage.h"
 #include "CryptoNoteCore/RocksDBWrapper.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
@@ -241,17 +243,22 @@ void PaymentGateService::runInProcess(Logging::LoggerRef& log) {
 
   log(Logging::INFO) << "initializing core";
 
+  Common::ThreadPool threadPool(config.coreConfig.validationThreads);
+
   CryptoNote::Core core(
     currency,
     logger,
     CryptoNote::Checkpoints(logger),
     *dispatcher,
     std::unique_ptr<CryptoNote::IBlockchainCacheFactory>(new CryptoNote::DatabaseBlockchainCacheFactory(database, log.getLogger())),
-    CryptoNote::createSwappedMainChainStorage(dbConfig.getDataDir(), currency));
+    config.coreConfig.mappedBlocksStorage ? CryptoNote::createFileMappedMainChainStorage(dbConfig.getDataDir(), currency) :
+                                            CryptoNote::createSwappedMainChainStorage(dbConfig.getDataDir(), currency));
 
+  core.setThreadPool(&threadPool);
   core.load();
 
   CryptoNote::CryptoNoteProtocolHandler protocol(currency, *dispatcher, core, nullptr, logger);
+  protocol.setThreadPool(&threadPool);
   CryptoNote::NodeServer p2pNode(*dispatcher, protocol, logger);
 
   protocol.set_p2p_endpoint(&p2pNode);
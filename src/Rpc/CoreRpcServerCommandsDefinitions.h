@@ -318,6 +318,31 @@ struct COMMAND_RPC_GET_INFO {
   };
 };
 
+//-----------------------------------------------
+struct COMMAND_RPC_GET_CACHE_STATISTICS {
+  typedef EMPTY_STRUCT request;
+
+  struct response {
+    std::string status;
+    uint64_t key_image_hits;
+    uint64_t key_image_misses;
+    uint64_t key_image_count;
+    uint64_t key_output_hits;
+    uint64_t key_output_misses;
+    uint64_t key_output_count;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(status)
+      KV_MEMBER(key_image_hits)
+      KV_MEMBER(key_image_misses)
+      KV_MEMBER(key_image_count)
+      KV_MEMBER(key_output_hits)
+      KV_MEMBER(key_output_misses)
+      KV_MEMBER(key_output_count)
+    }
+  };
+};
+
 //-----------------------------------------------
 struct COMMAND_RPC_STOP_MINING {
   typedef EMPTY_STRUCT request;
@@ -756,10 +781,12 @@ struct COMMAND_RPC_QUERY_BLOCKS_LITE {
   struct request {
     std::vector<Crypto::Hash> blockIds;
     uint64_t timestamp;
+    bool includeGlobalIndexes;
 
     void serialize(ISerializer &s) {
       serializeAsBinary(blockIds, "block_ids", s);
       KV_MEMBER(timestamp)
+      KV_MEMBER(includeGlobalIndexes)
     }
   };
 
@@ -1114,4 +1141,96 @@ struct COMMAND_RPC_GET_COLLATERAL_HASH {
     }
   };
 };
+
+struct COMMAND_RPC_SCAN_SUBSCRIBE {
+  struct request {
+    std::string viewSecretKey;
+    std::vector<std::string> spendPublicKeys;
+    uint32_t startIndex = 0;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(viewSecretKey)
+      KV_MEMBER(spendPublicKeys)
+      KV_MEMBER(startIndex)
+    }
+  };
+
+  struct response {
+    std::string subscriptionId;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(subscriptionId)
+      KV_MEMBER(status)
+    }
+  };
+};
+
+struct COMMAND_RPC_SCAN_UNSUBSCRIBE {
+  struct request {
+    std::string subscriptionId;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(subscriptionId)
+    }
+  };
+
+  typedef STATUS_STRUCT response;
+};
+
+struct scanned_output_entry {
+  uint32_t blockIndex;
+  std::string blockHash;
+  std::string transactionHash;
+  std::string transactionPublicKey;
+  uint32_t outputIndex;
+  uint32_t globalOutputIndex;
+  uint64_t amount;
+  std::string outputKey;
+  std::string spendPublicKey;
+
+  void serialize(ISerializer &s) {
+    KV_MEMBER(blockIndex)
+    KV_MEMBER(blockHash)
+    KV_MEMBER(transactionHash)
+    KV_MEMBER(transactionPublicKey)
+    KV_MEMBER(outputIndex)
+    KV_MEMBER(globalOutputIndex)
+    KV_MEMBER(amount)
+    KV_MEMBER(outputKey)
+    KV_MEMBER(spendPublicKey)
+  }
+};
+
+struct COMMAND_RPC_SCAN_GET_OUTPUTS {
+  struct request {
+    std::string subscriptionId;
+    uint32_t maxCount = 1000;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(subscriptionId)
+      KV_MEMBER(maxCount)
+    }
+  };
+
+  struct response {
+    std::vector<scanned_output_entry> outputs;
+    // Outputs of all blocks below this index have been returned
+    uint32_t scannedIndex;
+    uint32_t topIndex;
+    // Set after a chain switch, outputs returned before from blocks at detachIndex and above must be dropped
+    bool detached;
+    uint32_t detachIndex;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(outputs)
+      KV_MEMBER(scannedIndex)
+      KV_MEMBER(topIndex)
+      KV_MEMBER(detached)
+      KV_MEMBER(detachIndex)
+      KV_MEMBER(status)
+    }
+  };
+};
 }
@@ -19,6 +19,8 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpServer.h"
+#include <algorithm>
+#include <sstream>
 #include <thread>
 #include <string.h>
 #include <streambuf>
@@ -27,6 +29,7 @@
 #include <boost/scope_exit.hpp>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl/stream.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <Common/base64.hpp>
 #include <Common/StringTools.h>
@@ -34,7 +37,6 @@
 #include <System/InterruptedException.h>
 #include <System/PortMapping.h>
 #include <System/TcpStream.h>
-#include <System/SocketStream.h>
 
 using boost::asio::ip::tcp;
 using namespace Logging;
@@ -48,8 +50,8 @@ HttpServer::HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log)
   m_external_port = 0;
   m_external_port_ssl = 0;
   m_server_ssl_do = false;
-  m_server_ssl_is_run = false;
   m_server_ssl_clients = 0;
+  m_server_ssl_requests = 0;
   m_server_ssl_port = 0;
   m_address = "";
   m_chain_file = "";
@@ -84,8 +86,7 @@ void HttpServer::start(const std::string& address, uint16_t port, uint16_t port_
       m_external_port_ssl = external_port_ssl;
       System::addPortMapping(logger, m_server_ssl_port, m_external_port_ssl);
     }
-    m_ssl_server_thread = boost::thread(&HttpServer::sslServer, this);
-    m_ssl_server_thread.detach();
+    sslStart();
   }
 }
 
@@ -99,197 +100,291 @@ void HttpServer::stop() {
     }
   }
   m_server_ssl_do = false;
-  while (m_server_ssl_is_run) {
-    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+  sslStop();
+}
+
+namespace {
+
+// A connection idle for this long, including an unfinished TLS handshake or request, is closed
+const boost::posix_time::seconds SSL_IDLE_TIMEOUT(20);
+const size_t SSL_MAX_CONNECTIONS = 512;
+const size_t SSL_MAX_REQUEST_SIZE = 16 * 1024 * 1024;
+const char SSL_HEADER_END[] = "\r\n\r\n";
+
+bool findContentLength(const std::string& header, size_t& length) {
+  std::string lowered(header);
+  std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+
+  length = 0;
+  size_t position = lowered.find("\r\ncontent-length:");
+  if (position == std::string::npos) {
+    return true;
+  }
+
+  position += strlen("\r\ncontent-length:");
+  while (position < lowered.size() && lowered[position] == ' ') {
+    ++position;
+  }
+
+  if (position == lowered.size() || !isdigit(lowered[position])) {
+    return false;
+  }
+
+  while (position < lowered.size() && isdigit(lowered[position])) {
+    length = length * 10 + (lowered[position] - '0');
+    if (length > SSL_MAX_REQUEST_SIZE) {
+      return false;
+    }
+
+    ++position;
   }
+
+  return true;
 }
 
-void HttpServer::sslServerUnitControl(boost::asio::ssl::stream<tcp::socket&> &stream,
-                                      boost::system::error_code &ec,
-                                      bool &unit_do,
-                                      bool &unit_control_do,
-                                      size_t &stream_timeout_n) {
-  const size_t unit_timeout = 200;
-  while (unit_control_do) {
-    if (stream_timeout_n >= unit_timeout || !this->m_server_ssl_do) {
-      unit_do = false;
-      break;
-    } else {
-      stream_timeout_n++;
+}
+
+class HttpServer::SslConnection : public std::enable_shared_from_this<HttpServer::SslConnection> {
+public:
+  SslConnection(HttpServer& server) :
+    m_server(server),
+    m_stream(*server.m_ssl_service, *server.m_ssl_context),
+    m_timer(*server.m_ssl_service),
+    m_buffer(SSL_MAX_REQUEST_SIZE),
+    m_started(false),
+    m_keepAlive(true) {
+  }
+
+  ~SslConnection() {
+    if (m_started) {
+      --m_server.m_server_ssl_clients;
+    }
+  }
+
+  boost::asio::ip::tcp::socket& socket() {
+    return m_stream.next_layer();
+  }
+
+  void start() {
+    m_started = true;
+    ++m_server.m_server_ssl_clients;
+
+    // Responses go out as a single write, there is nothing to coalesce
+    boost::system::error_code ignored;
+    socket().set_option(tcp::no_delay(true), ignored);
+
+    restartTimer();
+    auto self = shared_from_this();
+    m_stream.async_handshake(boost::asio::ssl::stream_base::server, [self](const boost::system::error_code& ec) {
+      if (ec) {
+        self->close();
+        return;
+      }
+
+      self->readHeader();
+    });
+  }
+
+private:
+  HttpServer& m_server;
+  boost::asio::ssl::stream<tcp::socket> m_stream;
+  boost::asio::deadline_timer m_timer;
+  boost::asio::streambuf m_buffer;
+  std::string m_response;
+  bool m_started;
+  bool m_keepAlive;
+
+  void restartTimer() {
+    auto self = shared_from_this();
+    m_timer.expires_from_now(SSL_IDLE_TIMEOUT);
+    m_timer.async_wait([self](const boost::system::error_code& ec) {
+      if (ec != boost::asio::error::operation_aborted) {
+        self->close();
+      }
+    });
+  }
+
+  void close() {
+    boost::system::error_code ignored;
+    m_timer.cancel(ignored);
+    socket().close(ignored);
+  }
+
+  void readHeader() {
+    restartTimer();
+    auto self = shared_from_this();
+    boost::asio::async_read_until(m_stream, m_buffer, SSL_HEADER_END,
+                                  [self](const boost::system::error_code& ec, size_t headerSize) {
+      if (ec) {
+        self->close();
+        return;
+      }
+
+      self->readBody(headerSize);
+    });
+  }
+
+  void readBody(size_t headerSize) {
+    auto data = boost::asio::buffers_begin(m_buffer.data());
+    size_t bodySize;
+    if (!findContentLength(std::string(data, data + headerSize), bodySize) ||
+        headerSize + bodySize > SSL_MAX_REQUEST_SIZE) {
+      m_server.logger(DEBUGGING) << "Unable to process request (SSL server), request is too large";
+      close();
+      return;
     }
-    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+
+    size_t requestSize = headerSize + bodySize;
+    if (m_buffer.size() >= requestSize) {
+      dispatchRequest();
+      return;
+    }
+
+    auto self = shared_from_this();
+    boost::asio::async_read(m_stream, m_buffer, boost::asio::transfer_exactly(requestSize - m_buffer.size()),
+                            [self](const boost::system::error_code& ec, size_t) {
+      if (ec) {
+        self->close();
+        return;
+      }
+
+      self->dispatchRequest();
+    });
   }
-  if (unit_control_do && !unit_do) {
+
+  void dispatchRequest() {
+    // A slow handler must not be mistaken for an idle client
+    boost::system::error_code ignored;
+    m_timer.cancel(ignored);
+
+    HttpRequest request;
     try {
-      stream.shutdown(ec);
+      std::istream stream(&m_buffer);
+      HttpParser parser;
+      parser.receiveRequest(stream, request);
     } catch (std::exception& e) {
-      logger(ERROR, BRIGHT_RED) << "SSL server unit control error: " << e.what() << std::endl;
+      m_server.logger(DEBUGGING) << "Unable to process request (SSL server): " << e.what();
+      close();
+      return;
+    }
+
+    auto connection = request.getHeaders().find("connection");
+    if (connection != request.getHeaders().end()) {
+      std::string value(connection->second);
+      std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+      m_keepAlive = value != "close";
     }
-  }
-}
 
-void HttpServer::sslServerUnit(boost::asio::ip::tcp::socket &socket, boost::asio::ssl::context &ctx){
-  const size_t request_max_len = 1024 * 32;
-  bool keep_alive_conn = true;
-  bool unit_do = true;
-  bool unit_control_do = true;
-  size_t stream_timeout_n = 0;
-  boost::system::error_code ec;
-  boost::asio::ssl::stream<tcp::socket&> stream(socket, ctx);
+    ++m_server.m_server_ssl_requests;
+    auto self = shared_from_this();
+    m_server.m_dispatcher.remoteSpawn([self, request]() mutable {
+      HttpResponse response;
+      response.addHeader("Access-Control-Allow-Origin", "*");
+      try {
+        self->m_server.processRequest(request, response);
+      } catch (std::exception& e) {
+        self->m_server.logger(ERROR, BRIGHT_RED) << "SSL server error: " << e.what();
+        response.setStatus(HttpResponse::STATUS_500);
+        response.setBody("Internal server error");
+      }
 
-  boost::thread control_t(std::bind(&HttpServer::sslServerUnitControl, this, std::ref(stream),
-                                                                             std::ref(ec),
-                                                                             std::ref(unit_do),
-                                                                             std::ref(unit_control_do),
-                                                                             std::ref(stream_timeout_n)));
+      std::ostringstream stream;
+      stream << response;
+      self->m_response = stream.str();
 
-  this->m_server_ssl_clients++;
+      // The connection has to be released before the request is accounted, the I/O service may be destroyed then
+      HttpServer& server = self->m_server;
+      server.m_ssl_service->post([self] { self->writeResponse(); });
+      self.reset();
+      --server.m_server_ssl_requests;
+    });
+  }
 
-  try {
-    stream.handshake(boost::asio::ssl::stream_base::server, ec);
-    if (!ec) {
-      char req_buff[request_max_len];
-      while (keep_alive_conn) {
-        const char *header_end_sep = "\r\n\r\n";
-        const char *content_lenght_name = "Content-Length";
-        const char *content_lenght_end_sep = "\r\n";
-        size_t req_size_full = 0;
-        size_t header_end = 0;
-        size_t stream_len = 0;
-        bool header_found = false;
-        memset(req_buff, 0x00, sizeof(char) * request_max_len);
-        while (unit_do) {
-          size_t req_size = 0;
-          if (unit_do) req_size = stream.read_some(boost::asio::buffer((char *) req_buff + req_size_full,
-                                                   request_max_len - req_size_full - 1),
-                                                   ec);
-          req_size_full += req_size;
-          if (req_size == 0) {
-            keep_alive_conn = false;
-            break;
-          } else {
-            if (!header_found) {
-              std::string data = std::string(req_buff);
-              header_end = data.find(header_end_sep);
-              if (header_end != std::string::npos) {
-                header_found = true;
-                data.resize(header_end + 2);
-                data.push_back(0x00);
-                size_t content_lenght_start = data.find(content_lenght_name);
-                size_t content_lenght_end = data.find(content_lenght_end_sep, content_lenght_start);
-                if (content_lenght_start != std::string::npos && content_lenght_end != std::string::npos) {
-                  sscanf(data.substr(content_lenght_start + strlen(content_lenght_name) + 2,
-                                     content_lenght_end - content_lenght_start - strlen(content_lenght_name) - 2).c_str(),
-                         "%zu",
-                         &stream_len);
-                  stream_len += header_end + 4;
-                }
-              }
-            }
-          }
-          if (header_found) {
-            if (stream_len > 0) {
-              if (req_size_full >= stream_len) break;
-            } else {
-              if (req_size_full == header_end + 4) break;
-            }
-          }
-        }
-        if (req_size_full > 0 && req_size_full < request_max_len && unit_do) {
-          System::SocketStreambuf streambuf((char *) req_buff, req_size_full);
-
-          HttpParser parser;
-          HttpRequest req;
-          HttpResponse resp;
-          resp.addHeader("Access-Control-Allow-Origin", "*");
-
-          std::iostream io_stream(&streambuf);
-          parser.receiveRequest(io_stream, req);
-
-          processRequest(req, resp);
-
-          io_stream << resp;
-          io_stream.flush();
-
-          std::vector<uint8_t> resp_data;
-          streambuf.getRespdata(resp_data);
-          size_t resp_size_data = resp_data.size();
-          size_t resp_size_full = 0;
-          while (resp_size_full < resp_size_data && unit_do) {
-            size_t resp_size = 0;
-            if (unit_do) resp_size = stream.write_some(boost::asio::buffer(resp_data.data() + resp_size_full,
-                                                       resp_size_data - resp_size_full),
-                                                       ec);
-            if (resp_size > 0) {
-              resp_size_full += resp_size;
-            } else {
-              keep_alive_conn = false;
-              break;
-            }
-          }
-          stream_timeout_n = 0;
-        } else {
-          logger(DEBUGGING) << "Unable to process request (SSL server)" << std::endl;
-        }
+  void writeResponse() {
+    restartTimer();
+    auto self = shared_from_this();
+    boost::asio::async_write(m_stream, boost::asio::buffer(m_response), [self](const boost::system::error_code& ec, size_t) {
+      if (ec || !self->m_keepAlive) {
+        self->close();
+        return;
       }
-    }
+
+      self->m_response.clear();
+      self->readHeader();
+    });
+  }
+};
+
+void HttpServer::sslStart() {
+  try {
+    m_ssl_service.reset(new boost::asio::io_service());
+
+    m_ssl_context.reset(new boost::asio::ssl::context(boost::asio::ssl::context::sslv23));
+    m_ssl_context->set_options(boost::asio::ssl::context::default_workarounds | boost::asio::ssl::context::no_sslv2);
+    m_ssl_context->use_certificate_chain_file(m_chain_file);
+    m_ssl_context->use_private_key_file(m_key_file, boost::asio::ssl::context::pem);
+    m_ssl_context->use_tmp_dh_file(m_dh_file);
+
+    m_ssl_acceptor.reset(new tcp::acceptor(*m_ssl_service, tcp::endpoint(boost::asio::ip::address::from_string(m_address),
+                                                                         m_server_ssl_port)));
   } catch (std::exception& e) {
-    logger(ERROR, BRIGHT_RED) << "SSL server unit error: " << e.what() << std::endl;
+    logger(ERROR, BRIGHT_RED) << "SSL server error: " << e.what() << std::endl;
+    m_ssl_acceptor.reset();
+    m_ssl_context.reset();
+    m_ssl_service.reset();
+    return;
   }
-  unit_control_do = false;
-  control_t.join();
-  this->m_server_ssl_clients--;
+
+  sslAccept();
+  m_ssl_thread = std::thread(&HttpServer::sslRun, this);
 }
 
-void HttpServer::sslServerControl(tcp::acceptor &accept) {
-  while (m_server_ssl_do) boost::this_thread::sleep_for(boost::chrono::milliseconds(1000));
-  while (m_server_ssl_clients > 0) {
-    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+void HttpServer::sslStop() {
+  if (!m_ssl_service) {
+    return;
   }
-  if (accept.is_open()) {
-    boost::system::error_code ec;
-    accept.close(ec);
-    if (ec) {
-      logger(DEBUGGING) << "SSL server control error" << std::endl;
-    }
+
+  m_ssl_service->stop();
+  m_ssl_thread.join();
+
+  // Requests being processed post their responses to the stopped service, which is safe until it is destroyed
+  while (m_server_ssl_requests > 0) {
+    m_dispatcher.yield();
   }
-  this->m_ssl_server_thread.interrupt();
-  this->m_server_ssl_is_run = false;
+
+  m_ssl_acceptor.reset();
+  m_ssl_service.reset();
+  m_ssl_context.reset();
 }
 
-void HttpServer::sslServer() {
-  while (m_server_ssl_do) {
-    m_server_ssl_is_run = false;
-    try {
-      boost::asio::io_service io_service;
-      tcp::acceptor accept(io_service, tcp::endpoint(boost::asio::ip::address::from_string(m_address),
-                                                     m_server_ssl_port));
-
-      boost::thread control_t(std::bind(&HttpServer::sslServerControl, this, std::ref(accept)));
-      control_t.detach();
-
-      boost::asio::ssl::context ctx(boost::asio::ssl::context::sslv23);
-      ctx.set_options(boost::asio::ssl::context::default_workarounds | boost::asio::ssl::context::no_sslv2);
-      ctx.use_certificate_chain_file(m_chain_file);
-      ctx.use_private_key_file(m_key_file, boost::asio::ssl::context::pem);
-      ctx.use_tmp_dh_file(m_dh_file);
-
-      while (m_server_ssl_do) {
-        tcp::socket sock(io_service);
-        m_server_ssl_is_run = true;
-        accept.accept(sock);
-        if (m_server_ssl_do) {
-          boost::thread t(std::bind(&HttpServer::sslServerUnit, this, std::move(sock), std::ref(ctx)));
-          t.detach();
-        }
+void HttpServer::sslAccept() {
+  auto connection = std::make_shared<SslConnection>(*this);
+  m_ssl_acceptor->async_accept(connection->socket(), [this, connection](const boost::system::error_code& ec) {
+    if (ec == boost::asio::error::operation_aborted) {
+      return;
+    }
+
+    if (!ec) {
+      if (m_server_ssl_clients >= SSL_MAX_CONNECTIONS) {
+        logger(DEBUGGING) << "Too many SSL connections, refusing a new one";
+      } else {
+        connection->start();
       }
+    }
+
+    sslAccept();
+  });
+}
+
+void HttpServer::sslRun() {
+  for (;;) {
+    try {
+      m_ssl_service->run();
+      break;
     } catch (std::exception& e) {
-      if (m_server_ssl_do) {
-        logger(ERROR, BRIGHT_RED) << "SSL server error: " << e.what() << std::endl;
-      }
+      logger(ERROR, BRIGHT_RED) << "SSL server error: " << e.what() << std::endl;
     }
   }
-  this->m_server_ssl_is_run = false;
 }
 
 void HttpServer::acceptLoop() {
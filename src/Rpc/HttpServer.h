@@ -19,14 +19,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <unordered_set>
 #include <string.h>
 
 #include <HTTP/HttpRequest.h>
 #include <HTTP/HttpResponse.h>
 #include <boost/asio.hpp>
-#include <boost/asio/ssl/stream.hpp>
-#include <boost/thread/thread.hpp>
+#include <boost/asio/ssl/context.hpp>
 
 #include <System/ContextGroup.h>
 #include <System/Dispatcher.h>
@@ -55,34 +57,37 @@ protected:
   System::Dispatcher& m_dispatcher;
 
 private:
+  class SslConnection;
+
   System::Ipv4Address m_server_ip;
   bool m_server_ssl_do;
-  bool m_server_ssl_is_run;
   uint16_t m_port;
   uint16_t m_external_port;
   uint16_t m_external_port_ssl;
   uint16_t m_server_ssl_port;
-  unsigned int m_server_ssl_clients;
+  std::atomic<size_t> m_server_ssl_clients;
+  std::atomic<size_t> m_server_ssl_requests;
   std::string m_address;
   std::string m_chain_file;
   std::string m_dh_file;
   std::string m_key_file;
   std::unordered_set<System::TcpConnection*> m_connections;
-  boost::thread m_ssl_server_thread;
   System::ContextGroup workingContextGroup;
   System::TcpListener m_listener;
   Logging::LoggerRef logger;
+
+  // TLS connections are served asynchronously on a single I/O thread, requests are handed to the dispatcher
+  std::unique_ptr<boost::asio::io_service> m_ssl_service;
+  std::unique_ptr<boost::asio::ssl::context> m_ssl_context;
+  std::unique_ptr<boost::asio::ip::tcp::acceptor> m_ssl_acceptor;
+  std::thread m_ssl_thread;
+
   void acceptLoop();
   void connectionHandler(System::TcpConnection&& conn);
-  void sslServerUnitControl(boost::asio::ssl::stream<boost::asio::ip::tcp::socket&> &stream,
-                            boost::system::error_code &ec,
-                            bool &unit_do,
-                            bool &unit_control_do,
-                            size_t &stream_timeout_n);
-  void sslServerUnit(boost::asio::ip::tcp::socket &socket, boost::asio::ssl::context &ctx);
-  void sslServerControl(boost::asio::ip::tcp::acceptor &accept);
-  void sslServer();
-
+  void sslStart();
+  void sslStop();
+  void sslAccept();
+  void sslRun();
 };
 
 }
@@ -24,7 +24,9 @@
 #include "math.h"
 
 // CryptoNote
+#include "Common/StringOutputStream.h"
 #include "Common/StringTools.h"
+#include "Common/ThreadPool.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/Core.h"
@@ -34,10 +36,15 @@
 #include "CryptoNoteConfig.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h"
 #include "P2p/NetNode.h"
+#include "Serialization/KVBinaryStreamWriter.h"
 #include "CoreRpcServerErrorCodes.h"
 #include "JsonRpc.h"
+#include "ViewKeyScanner.h"
 #include "version.h"
 
+#include <System/Event.h>
+#include <System/InterruptedException.h>
+
 #undef ERROR
 
 template <typename T>
@@ -57,13 +64,6 @@ using namespace Common;
 
 namespace CryptoNote {
 
-static inline void serialize(COMMAND_RPC_GET_BLOCKS_FAST::response& response, ISerializer &s) {
-  KV_MEMBER(response.blocks)
-  KV_MEMBER(response.start_height)
-  KV_MEMBER(response.current_height)
-  KV_MEMBER(response.status)
-}
-
 void serialize(BlockFullInfo& blockFullInfo, ISerializer& s) {
   KV_MEMBER(blockFullInfo.block_id);
   KV_MEMBER(blockFullInfo.block);
@@ -73,12 +73,19 @@ void serialize(BlockFullInfo& blockFullInfo, ISerializer& s) {
 void serialize(TransactionPrefixInfo& transactionPrefixInfo, ISerializer& s) {
   KV_MEMBER(transactionPrefixInfo.txHash);
   KV_MEMBER(transactionPrefixInfo.txPrefix);
+  // Left out unless requested, so responses to clients that didn't ask keep their size
+  if (s.type() == ISerializer::INPUT || !transactionPrefixInfo.globalIndexes.empty()) {
+    KV_MEMBER(transactionPrefixInfo.globalIndexes);
+  }
 }
 
 void serialize(BlockShortInfo& blockShortInfo, ISerializer& s) {
   KV_MEMBER(blockShortInfo.blockId);
   KV_MEMBER(blockShortInfo.block);
   KV_MEMBER(blockShortInfo.txPrefixes);
+  if (s.type() == ISerializer::INPUT || !blockShortInfo.baseTransactionGlobalIndexes.empty()) {
+    KV_MEMBER(blockShortInfo.baseTransactionGlobalIndexes);
+  }
 }
 
 namespace {
@@ -100,6 +107,55 @@ RpcServer::HandlerFunction binMethod(bool (RpcServer::*handler)(typename Command
   };
 }
 
+// Encodes COMMAND_RPC_GET_BLOCKS_FAST::response the way NodeRpcProxy reads it, copying blobs from storage into the
+// body once
+std::string encodeGetBlocksResponse(const std::vector<RawBlockView>& blocks, uint64_t startHeight, uint64_t currentHeight,
+                                    const std::string& status) {
+  size_t size = status.size() + 128;
+  for (const auto& block : blocks) {
+    size += block.block.size + 64;
+    for (const auto& transaction : block.transactions) {
+      size += transaction.size + 32;
+    }
+  }
+
+  std::string body;
+  body.reserve(size);
+  StringOutputStream stream(body);
+  KVBinaryStreamWriter writer(stream);
+
+  writer.beginObject((blocks.empty() ? 0 : 1) + 3);
+  if (!blocks.empty()) {
+    writer.beginObjectArray("response.blocks", blocks.size());
+    for (const auto& block : blocks) {
+      // Empty blobs are skipped by ISerializer::binary
+      size_t fieldCount = (block.block.size != 0 ? 3 : 2) + block.transactions.size();
+      for (const auto& transaction : block.transactions) {
+        fieldCount += transaction.size != 0 ? 1 : 0;
+      }
+
+      writer.beginObject(fieldCount);
+      writer.writeUint64("block_size", block.block.size);
+      if (block.block.size != 0) {
+        writer.writeString("block", block.block.data, block.block.size);
+      }
+
+      writer.writeUint64("tx_count", block.transactions.size());
+      for (const auto& transaction : block.transactions) {
+        writer.writeUint64("tx_size", transaction.size);
+        if (transaction.size != 0) {
+          writer.writeString("transaction", transaction.data, transaction.size);
+        }
+      }
+    }
+  }
+
+  writer.writeUint64("response.start_height", startHeight);
+  writer.writeUint64("response.current_height", currentHeight);
+  writer.writeString("response.status", status.data(), status.size());
+  return body;
+}
+
 template <typename Command>
 RpcServer::HandlerFunction jsonMethod(bool (RpcServer::*handler)(typename Command::request const&, typename Command::response&)) {
   return [handler](RpcServer* obj, const HttpRequest& request, HttpResponse& response) {
@@ -126,45 +182,117 @@ RpcServer::HandlerFunction jsonMethod(bool (RpcServer::*handler)(typename Comman
 
 std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction>> RpcServer::s_handlers = {
   // binary handlers
-  { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks), false } },
-  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), false } },
-  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), false } },
-  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), false } },
-  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false } },
-  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false } },
-  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false } },
-  { "/get_block_details_by_height.bin", { binMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::onGetBlockDetailsByHeight), false } },
-  { "/get_blocks_details_by_hashes.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::onGetBlocksDetailsByHashes), false } },
-  { "/get_blocks_hashes_by_timestamps.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_HASHES_BY_TIMESTAMPS>(&RpcServer::onGetBlocksHashesByTimestamps), false } },
-  { "/get_transaction_details_by_hashes.bin", { binMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES>(&RpcServer::onGetTransactionDetailsByHashes), false } },
-  { "/get_transaction_hashes_by_payment_id.bin", { binMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID>(&RpcServer::onGetTransactionHashesByPaymentId), false } },
+  { "/getblocks.bin", { std::bind(&RpcServer::on_get_blocks, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), false, true } },
+  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), false, true } },
+  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), false, true } },
+  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), false, true } },
+  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false, true } },
+  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false, true } },
+  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false, true } },
+  { "/get_block_details_by_height.bin", { binMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::onGetBlockDetailsByHeight), false, true } },
+  { "/get_blocks_details_by_hashes.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::onGetBlocksDetailsByHashes), false, true } },
+  { "/get_blocks_hashes_by_timestamps.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_HASHES_BY_TIMESTAMPS>(&RpcServer::onGetBlocksHashesByTimestamps), false, true } },
+  { "/get_transaction_details_by_hashes.bin", { binMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES>(&RpcServer::onGetTransactionDetailsByHashes), false, true } },
+  { "/get_transaction_hashes_by_payment_id.bin", { binMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID>(&RpcServer::onGetTransactionHashesByPaymentId), false, true } },
 
   // json handlers
-  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true } },
-  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), true } },
-  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), false } },
-  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::on_send_raw_tx), false } },
-  { "/feeaddress", { jsonMethod<COMMAND_RPC_GET_FEE_ADDRESS>(&RpcServer::on_get_fee_address), true } },
-  { "/collateralhash", { jsonMethod<COMMAND_RPC_GET_COLLATERAL_HASH>(&RpcServer::on_get_collateral_hash), true } },
-  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true } },
-  { "/getpeers", { jsonMethod<COMMAND_RPC_GET_PEERS>(&RpcServer::on_get_peers), true } },
-  { "/getpeersgray", { jsonMethod<COMMAND_RPC_GET_PEERSGRAY>(&RpcServer::on_get_peersgray), true } },
-  { "/get_generated_coins", { jsonMethod<COMMAND_RPC_GET_ISSUED_COINS>(&RpcServer::on_get_issued), true } },
-  { "/get_total_coins", { jsonMethod<COMMAND_RPC_GET_TOTAL_COINS>(&RpcServer::on_get_total), true } },
-  { "/get_amounts_for_account", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_OUT_AMOUNTS_FOR_ACCOUNT>(&RpcServer::on_get_transaction_out_amounts_for_account), true } },
-  { "/get_block_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_BLOCK_HASHES_BY_PAYMENT_ID_JSON>(&RpcServer::on_get_block_hashes_by_payment_id), false } },
-  { "/get_block_hashes_by_transaction_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCK_HASHES_BY_TRANSACTION_HASHES>(&RpcServer::on_get_block_hashes_by_transaction_hashes), false } },
-  { "/get_block_indexes_by_transaction_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCK_INDEXES_BY_TRANSACTION_HASHES>(&RpcServer::on_get_block_indexes_by_transaction_hashes), false } },
-  { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES_JSON>(&RpcServer::on_get_blocks_details_by_hashes), false } },
-  { "/get_transaction_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES_JSON>(&RpcServer::on_get_transaction_details_by_hashes), false } },
-  { "/get_transaction_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID_JSON>(&RpcServer::on_get_transaction_hashes_by_payment_id), false } },
+  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true, false } },
+  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), true, false } },
+  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), false, true } },
+  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::on_send_raw_tx), false, false } },
+  { "/feeaddress", { jsonMethod<COMMAND_RPC_GET_FEE_ADDRESS>(&RpcServer::on_get_fee_address), true, false } },
+  { "/collateralhash", { jsonMethod<COMMAND_RPC_GET_COLLATERAL_HASH>(&RpcServer::on_get_collateral_hash), true, false } },
+  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true, false } },
+  { "/getpeers", { jsonMethod<COMMAND_RPC_GET_PEERS>(&RpcServer::on_get_peers), true, false } },
+  { "/getpeersgray", { jsonMethod<COMMAND_RPC_GET_PEERSGRAY>(&RpcServer::on_get_peersgray), true, false } },
+  { "/get_generated_coins", { jsonMethod<COMMAND_RPC_GET_ISSUED_COINS>(&RpcServer::on_get_issued), true, true } },
+  { "/get_total_coins", { jsonMethod<COMMAND_RPC_GET_TOTAL_COINS>(&RpcServer::on_get_total), true, true } },
+  { "/get_cache_statistics", { jsonMethod<COMMAND_RPC_GET_CACHE_STATISTICS>(&RpcServer::on_get_cache_statistics), false, true } },
+  { "/get_amounts_for_account", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_OUT_AMOUNTS_FOR_ACCOUNT>(&RpcServer::on_get_transaction_out_amounts_for_account), true, true } },
+  { "/get_block_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_BLOCK_HASHES_BY_PAYMENT_ID_JSON>(&RpcServer::on_get_block_hashes_by_payment_id), false, true } },
+  { "/get_block_hashes_by_transaction_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCK_HASHES_BY_TRANSACTION_HASHES>(&RpcServer::on_get_block_hashes_by_transaction_hashes), false, true } },
+  { "/get_block_indexes_by_transaction_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCK_INDEXES_BY_TRANSACTION_HASHES>(&RpcServer::on_get_block_indexes_by_transaction_hashes), false, true } },
+  { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES_JSON>(&RpcServer::on_get_blocks_details_by_hashes), false, true } },
+  { "/get_transaction_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES_JSON>(&RpcServer::on_get_transaction_details_by_hashes), false, true } },
+  { "/get_transaction_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID_JSON>(&RpcServer::on_get_transaction_hashes_by_payment_id), false, true } },
+  { "/scan_subscribe", { jsonMethod<COMMAND_RPC_SCAN_SUBSCRIBE>(&RpcServer::on_scan_subscribe), true, false } },
+  { "/scan_unsubscribe", { jsonMethod<COMMAND_RPC_SCAN_UNSUBSCRIBE>(&RpcServer::on_scan_unsubscribe), true, false } },
+  { "/scan_get_outputs", { jsonMethod<COMMAND_RPC_SCAN_GET_OUTPUTS>(&RpcServer::on_scan_get_outputs), false, false } },
 
   // json rpc
-  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } }
+  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true, false } }
 };
 
 RpcServer::RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, Core& c, NodeServer& p2p, ICryptoNoteProtocolHandler& protocol) :
-  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(c), m_p2p(p2p), m_protocol(protocol) {
+  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(c), m_p2p(p2p), m_protocol(protocol),
+  m_threadPool(nullptr) {
+}
+
+RpcServer::~RpcServer() {
+}
+
+void RpcServer::setThreadPool(Common::ThreadPool* threadPool) {
+  m_threadPool = threadPool;
+}
+
+void RpcServer::enableScanning() {
+  m_scanner.reset(new ViewKeyScanner(m_core));
+  // One worker besides the dispatcher, so scans of a whole poll budget don't stall it when --rpc-threads is 0
+  m_scanThreadPool.reset(new Common::ThreadPool(2));
+}
+
+void RpcServer::runReadOnly(const std::function<void()>& handler) {
+  runInThreadPool(m_threadPool, handler, true);
+}
+
+void RpcServer::runUnlocked(const std::function<void()>& handler) {
+  if (m_threadPool == nullptr || m_threadPool->getThreadCount() < 2) {
+    runInThreadPool(m_scanThreadPool.get(), handler, false);
+  } else {
+    runInThreadPool(m_threadPool, handler, false);
+  }
+}
+
+void RpcServer::runInThreadPool(Common::ThreadPool* threadPool, const std::function<void()>& handler, bool lockCore) {
+  if (threadPool == nullptr || threadPool->getThreadCount() < 2) {
+    handler();
+    return;
+  }
+
+  System::Event done(m_dispatcher);
+  std::exception_ptr error;
+  threadPool->post([&] {
+    try {
+      if (lockCore) {
+        auto lock = m_core.lockForReading();
+        handler();
+      } else {
+        handler();
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    m_dispatcher.remoteSpawn([&done] { done.set(); });
+  });
+
+  // The job references this frame, so the wait must not be cut short by an interrupt
+  bool interrupted = false;
+  while (!done.get()) {
+    try {
+      done.wait();
+    } catch (System::InterruptedException&) {
+      interrupted = true;
+    }
+  }
+
+  if (interrupted) {
+    m_dispatcher.interrupt();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
 }
 
 void RpcServer::processRequest(const HttpRequest& request, HttpResponse& response) {
@@ -187,7 +315,11 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
     return;
   }
 
-  it->second.handler(this, request, response);
+  if (it->second.readOnly) {
+    runReadOnly([&] { it->second.handler(this, request, response); });
+  } else {
+    it->second.handler(this, request, response);
+  }
 }
 
 bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse& response) {
@@ -208,20 +340,20 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
     jsonResponse.setId(jsonRequest.getId()); // copy id
 
     static std::unordered_map<std::string, RpcServer::RpcHandler<JsonMemberMethod>> jsonRpcHandlers = {
-      { "f_blocks_list_json", { makeMemberMethod(&RpcServer::f_on_blocks_list_json), false } },
-      { "f_block_json", { makeMemberMethod(&RpcServer::f_on_block_json), false } },
-      { "f_transaction_json", { makeMemberMethod(&RpcServer::f_on_transaction_json), false } },
-      { "f_pool_transaction_json", { makeMemberMethod(&RpcServer::f_on_pool_transaction_json), false } },
-      { "f_on_transactions_pool_json", { makeMemberMethod(&RpcServer::f_on_transactions_pool_json), false } },
-      { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true } },
-      { "on_getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), false } },
-      { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), false } },
-      { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true } },
-      { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false } },
-      { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), false } },
-      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false } },
-      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), false } },
-      { "getalternatechains", { makeMemberMethod(&RpcServer::on_get_alternate_chains), false } },
+      { "f_blocks_list_json", { makeMemberMethod(&RpcServer::f_on_blocks_list_json), false, true } },
+      { "f_block_json", { makeMemberMethod(&RpcServer::f_on_block_json), false, true } },
+      { "f_transaction_json", { makeMemberMethod(&RpcServer::f_on_transaction_json), false, true } },
+      { "f_pool_transaction_json", { makeMemberMethod(&RpcServer::f_on_pool_transaction_json), false, true } },
+      { "f_on_transactions_pool_json", { makeMemberMethod(&RpcServer::f_on_transactions_pool_json), false, true } },
+      { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true, true } },
+      { "on_getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), false, true } },
+      { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), false, false } },
+      { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true, false } },
+      { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false, false } },
+      { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), false, true } },
+      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false, true } },
+      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), false, true } },
+      { "getalternatechains", { makeMemberMethod(&RpcServer::on_get_alternate_chains), false, true } },
     };
 
     auto it = jsonRpcHandlers.find(jsonRequest.getMethod());
@@ -233,7 +365,11 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
       throw JsonRpcError(CORE_RPC_ERROR_CODE_CORE_BUSY, "Core is busy");
     }
 
-    it->second.handler(this, jsonRequest, jsonResponse);
+    if (it->second.readOnly) {
+      runReadOnly([&] { it->second.handler(this, jsonRequest, jsonResponse); });
+    } else {
+      it->second.handler(this, jsonRequest, jsonResponse);
+    }
 
   } catch (const JsonRpcError& err) {
     jsonResponse.setError(err);
@@ -332,15 +468,16 @@ bool RpcServer::masternode_check_incoming_tx(const BinaryArray& tx_blob) {
 // Binary handlers
 //
 
-bool RpcServer::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res) {
-  // TODO code duplication see InProcessNode::doGetNewBlocks()
-  if (req.block_ids.empty()) {
-    res.status = "Failed";
+bool RpcServer::on_get_blocks(const HttpRequest& request, HttpResponse& response) {
+  boost::value_initialized<COMMAND_RPC_GET_BLOCKS_FAST::request> value;
+  COMMAND_RPC_GET_BLOCKS_FAST::request& req = value;
+  if (!loadFromBinaryKeyValue(req, request.getBody())) {
     return false;
   }
 
-  if (req.block_ids.back() != m_core.getBlockHashByIndex(0)) {
-    res.status = "Failed";
+  // TODO code duplication see InProcessNode::doGetNewBlocks()
+  if (req.block_ids.empty() || req.block_ids.back() != m_core.getBlockHashByIndex(0)) {
+    response.setBody(encodeGetBlocksResponse({}, 0, 0, "Failed"));
     return false;
   }
 
@@ -348,14 +485,13 @@ bool RpcServer::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, C
   uint32_t startBlockIndex;
   std::vector<Crypto::Hash> supplement = m_core.findBlockchainSupplement(req.block_ids, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT, totalBlockCount, startBlockIndex);
 
-  res.current_height = totalBlockCount;
-  res.start_height = startBlockIndex;
-
+  // Blocks are written into the body straight from the main chain storage
+  std::vector<RawBlockView> blocks;
   std::vector<Crypto::Hash> missedHashes;
-  m_core.getBlocks(supplement, res.blocks, missedHashes);
+  m_core.getBlockViews(supplement, blocks, missedHashes);
   assert(missedHashes.empty());
 
-  res.status = CORE_RPC_STATUS_OK;
+  response.setBody(encodeGetBlocksResponse(blocks, startBlockIndex, totalBlockCount, CORE_RPC_STATUS_OK));
   return true;
 }
 
@@ -380,7 +516,7 @@ bool RpcServer::on_query_blocks_lite(const COMMAND_RPC_QUERY_BLOCKS_LITE::reques
   uint32_t startIndex;
   uint32_t currentIndex;
   uint32_t fullOffset;
-  if (!m_core.queryBlocksLite(req.blockIds, req.timestamp, startIndex, currentIndex, fullOffset, res.items)) {
+  if (!m_core.queryBlocksLite(req.blockIds, req.timestamp, req.includeGlobalIndexes, startIndex, currentIndex, fullOffset, res.items)) {
     res.status = "Failed to perform query";
     return false;
   }
@@ -597,6 +733,18 @@ bool RpcServer::on_get_total(const COMMAND_RPC_GET_TOTAL_COINS::request& req, CO
   return true;
 }
 
+bool RpcServer::on_get_cache_statistics(const COMMAND_RPC_GET_CACHE_STATISTICS::request& req, COMMAND_RPC_GET_CACHE_STATISTICS::response& res) {
+  LookupCacheStatistics statistics = m_core.getLookupCacheStatistics();
+  res.key_image_hits = statistics.keyImageHits;
+  res.key_image_misses = statistics.keyImageMisses;
+  res.key_image_count = statistics.keyImageCount;
+  res.key_output_hits = statistics.keyOutputHits;
+  res.key_output_misses = statistics.keyOutputMisses;
+  res.key_output_count = statistics.keyOutputCount;
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
 bool RpcServer::on_get_transactions(const COMMAND_RPC_GET_TRANSACTIONS::request& req, COMMAND_RPC_GET_TRANSACTIONS::response& res) {
   std::vector<Hash> vh;
   for (const auto& tx_hex_str : req.txs_hashes) {
@@ -767,6 +915,112 @@ bool RpcServer::on_get_collateral_hash(const COMMAND_RPC_GET_COLLATERAL_HASH::re
   return false;
 }
 
+bool RpcServer::on_scan_subscribe(const COMMAND_RPC_SCAN_SUBSCRIBE::request& req, COMMAND_RPC_SCAN_SUBSCRIBE::response& res) {
+  if (!m_scanner) {
+    res.status = "Scanning RPC is disabled";
+    return false;
+  }
+
+  Crypto::SecretKey viewSecretKey;
+  if (!podFromHex(req.viewSecretKey, viewSecretKey)) {
+    res.status = "Invalid view key!";
+    return false;
+  }
+
+  std::vector<Crypto::PublicKey> spendPublicKeys;
+  spendPublicKeys.reserve(req.spendPublicKeys.size());
+  for (const std::string& spendPublicKeyString : req.spendPublicKeys) {
+    Crypto::PublicKey spendPublicKey;
+    if (!podFromHex(spendPublicKeyString, spendPublicKey)) {
+      res.status = "Invalid spend public key!";
+      return false;
+    }
+
+    spendPublicKeys.push_back(spendPublicKey);
+  }
+
+  Crypto::Hash subscriptionId;
+  if (!m_scanner->subscribe(viewSecretKey, spendPublicKeys, req.startIndex, subscriptionId)) {
+    res.status = "Subscription rejected";
+    return false;
+  }
+
+  res.subscriptionId = Common::podToHex(subscriptionId);
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_scan_unsubscribe(const COMMAND_RPC_SCAN_UNSUBSCRIBE::request& req, COMMAND_RPC_SCAN_UNSUBSCRIBE::response& res) {
+  if (!m_scanner) {
+    res.status = "Scanning RPC is disabled";
+    return false;
+  }
+
+  Crypto::Hash subscriptionId;
+  if (!podFromHex(req.subscriptionId, subscriptionId) || !m_scanner->unsubscribe(subscriptionId)) {
+    res.status = "Subscription not found";
+    return false;
+  }
+
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_scan_get_outputs(const COMMAND_RPC_SCAN_GET_OUTPUTS::request& req, COMMAND_RPC_SCAN_GET_OUTPUTS::response& res) {
+  if (!m_scanner) {
+    res.status = "Scanning RPC is disabled";
+    return false;
+  }
+
+  Crypto::Hash subscriptionId;
+  if (!podFromHex(req.subscriptionId, subscriptionId)) {
+    res.status = "Subscription not found";
+    return false;
+  }
+
+  // Only copying the blocks and looking up global indexes of the outputs found hold the core, the key derivations run
+  // while it is released
+  ViewKeyScanner::ScanJob job;
+  bool found = false;
+  runReadOnly([&] {
+    found = m_scanner->prepareScan(subscriptionId, job);
+    res.topIndex = m_core.getTopBlockIndex();
+  });
+
+  std::vector<ScannedOutput> outputs;
+  if (found) {
+    runUnlocked([&] { ViewKeyScanner::scan(job); });
+    if (ViewKeyScanner::foundOutputs(job)) {
+      runReadOnly([&] { m_scanner->resolveGlobalIndexes(job); });
+    }
+
+    found = m_scanner->getOutputs(subscriptionId, job, req.maxCount, outputs, res.scannedIndex, res.detached, res.detachIndex);
+  }
+
+  if (!found) {
+    res.status = "Subscription not found";
+    return false;
+  }
+
+  res.outputs.reserve(outputs.size());
+  for (const ScannedOutput& output : outputs) {
+    scanned_output_entry entry;
+    entry.blockIndex = output.blockIndex;
+    entry.blockHash = Common::podToHex(output.blockHash);
+    entry.transactionHash = Common::podToHex(output.transactionHash);
+    entry.transactionPublicKey = Common::podToHex(output.transactionPublicKey);
+    entry.outputIndex = output.outputIndex;
+    entry.globalOutputIndex = output.globalOutputIndex;
+    entry.amount = output.amount;
+    entry.outputKey = Common::podToHex(output.outputKey);
+    entry.spendPublicKey = Common::podToHex(output.spendPublicKey);
+    res.outputs.push_back(std::move(entry));
+  }
+
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
 
 bool RpcServer::on_get_peers(const COMMAND_RPC_GET_PEERS::request& req, COMMAND_RPC_GET_PEERS::response& res) {
   std::list<PeerlistEntry> peers_white;
@@ -816,29 +1070,27 @@ bool RpcServer::f_on_blocks_list_json(const F_COMMAND_RPC_GET_BLOCKS_LIST::reque
     last_height = 0;
   }
 
-  for (uint32_t i = static_cast<uint32_t>(req.height); i >= last_height; i--) {
-    Hash block_hash = m_core.getBlockHashByIndex(static_cast<uint32_t>(i));
-    if (!m_core.hasBlock(block_hash)) {
-      throw JsonRpc::JsonRpcError{
-        CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-        "Internal error: can't get block by height. Height = " + std::to_string(i) + '.' };
-    }
-    BlockTemplate blk = m_core.getBlockByHash(block_hash);
-    BlockDetails blkDetails = m_core.getBlockDetails(block_hash);
+  uint32_t blocks_count = static_cast<uint32_t>(req.height) - last_height + 1;
+  std::vector<BlockSummary> summaries = m_core.getBlockSummaries(last_height, blocks_count);
+  if (summaries.size() != blocks_count) {
+    throw JsonRpc::JsonRpcError{
+      CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
+      "Internal error: can't get blocks. Height = " + std::to_string(req.height) + '.' };
+  }
+
+  for (uint32_t i = blocks_count; i-- > 0;) {
+    const BlockSummary& summary = summaries[i];
 
     f_block_short_response block_short;
-    block_short.cumul_size = blkDetails.blockSize;
-    block_short.timestamp = blk.timestamp;
-    block_short.difficulty = blkDetails.difficulty;
-    block_short.reward = blkDetails.reward;
-    block_short.height = i;
-    block_short.hash = Common::podToHex(block_hash);
-    block_short.tx_count = blk.transactionHashes.size() + 1;
+    block_short.cumul_size = summary.blockSize;
+    block_short.timestamp = summary.timestamp;
+    block_short.difficulty = summary.difficulty;
+    block_short.reward = summary.reward;
+    block_short.height = last_height + i;
+    block_short.hash = Common::podToHex(m_core.getBlockHashByIndex(last_height + i));
+    block_short.tx_count = summary.transactionCount;
 
     res.blocks.push_back(block_short);
-
-    if (i == 0)
-      break;
   }
 
   res.status = CORE_RPC_STATUS_OK;
@@ -1276,9 +1528,15 @@ void RpcServer::fill_block_header_response(const BlockTemplate& blk, bool orphan
 	response.hash = Common::podToHex(hash);
 	response.difficulty = m_core.getBlockDifficulty(index);
 	response.reward = get_block_reward(blk);
-	BlockDetails blkDetails = m_core.getBlockDetails(hash);
-	response.num_txes = static_cast<uint32_t>(blkDetails.transactions.size());
-	response.block_size = blkDetails.blockSize;
+	std::vector<BlockSummary> summaries = m_core.getBlockSummaries(index, 1);
+	if (!summaries.empty() && m_core.getBlockHashByIndex(index) == hash) {
+		response.num_txes = summaries.front().transactionCount;
+		response.block_size = summaries.front().blockSize;
+	} else {
+		BlockDetails blkDetails = m_core.getBlockDetails(hash);
+		response.num_txes = static_cast<uint32_t>(blkDetails.transactions.size());
+		response.block_size = blkDetails.blockSize;
+	}
 }
 
 bool RpcServer::on_get_last_block_header(const COMMAND_RPC_GET_LAST_BLOCK_HEADER::request& req, COMMAND_RPC_GET_LAST_BLOCK_HEADER::response& res) {
@@ -23,6 +23,7 @@
 #include "HttpServer.h"
 
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
 #include <Logging/LoggerRef.h>
@@ -30,15 +31,21 @@
 #include "CoreRpcServerCommandsDefinitions.h"
 #include "JsonRpc.h"
 
+namespace Common {
+class ThreadPool;
+}
+
 namespace CryptoNote {
 
 class Core;
 class NodeServer;
+class ViewKeyScanner;
 struct ICryptoNoteProtocolHandler;
 
 class RpcServer : public HttpServer {
 public:
   RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, Core& c, NodeServer& p2p, ICryptoNoteProtocolHandler& protocol);
+  ~RpcServer();
 
   typedef std::function<bool(RpcServer*, const HttpRequest& request, HttpResponse& response)> HandlerFunction;
   bool enableCors(const std::vector<std::string>  domains);
@@ -49,6 +56,12 @@ public:
   bool setCollateralHash(const std::string& collateral_hash);
   bool masternode_check_incoming_tx(const BinaryArray& tx_blob);
 
+  // Read-only handlers run on this pool under a read lock of the core when it has workers, the pool must outlive
+  // the server
+  void setThreadPool(Common::ThreadPool* threadPool);
+  // Serves the scan_* methods finding outputs of subscribed view keys
+  void enableScanning();
+
   bool on_get_block_headers_range(const COMMAND_RPC_GET_BLOCK_HEADERS_RANGE::request& req, COMMAND_RPC_GET_BLOCK_HEADERS_RANGE::response& res, JsonRpc::JsonRpcError& error_resp);
   bool on_get_alternate_chains(const COMMAND_RPC_GET_ALTERNATE_CHAINS::request& req, COMMAND_RPC_GET_ALTERNATE_CHAINS::response& res);
 
@@ -58,6 +71,7 @@ private:
   struct RpcHandler {
     const Handler handler;
     const bool allowBusyCore;
+    const bool readOnly;
   };
 
   typedef void (RpcServer::*HandlerPtr)(const HttpRequest& request, HttpResponse& response);
@@ -65,11 +79,16 @@ private:
 
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) override;
   bool processJsonRpcRequest(const HttpRequest& request, HttpResponse& response);
+  void runReadOnly(const std::function<void()>& handler);
+  // Same as runReadOnly without the core lock, for work on data already copied out of the core. With scanning enabled
+  // it never runs on the dispatcher, the scanning pool takes it when the RPC pool has no workers.
+  void runUnlocked(const std::function<void()>& handler);
+  void runInThreadPool(Common::ThreadPool* threadPool, const std::function<void()>& handler, bool lockCore);
   bool isCoreReady();
   bool verifyCollateral();
 
   // binary handlers
-  bool on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res);
+  bool on_get_blocks(const HttpRequest& request, HttpResponse& response);
   bool on_query_blocks(const COMMAND_RPC_QUERY_BLOCKS::request& req, COMMAND_RPC_QUERY_BLOCKS::response& res);
   bool on_query_blocks_lite(const COMMAND_RPC_QUERY_BLOCKS_LITE::request& req, COMMAND_RPC_QUERY_BLOCKS_LITE::response& res);
   bool on_get_indexes(const COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::response& res);
@@ -92,9 +111,13 @@ private:
   bool on_get_peersgray(const COMMAND_RPC_GET_PEERSGRAY::request& req, COMMAND_RPC_GET_PEERSGRAY::response& res);
   bool on_get_issued(const COMMAND_RPC_GET_ISSUED_COINS::request& req, COMMAND_RPC_GET_ISSUED_COINS::response& res);
   bool on_get_total(const COMMAND_RPC_GET_TOTAL_COINS::request& req, COMMAND_RPC_GET_TOTAL_COINS::response& res);
+  bool on_get_cache_statistics(const COMMAND_RPC_GET_CACHE_STATISTICS::request& req, COMMAND_RPC_GET_CACHE_STATISTICS::response& res);
   bool on_get_fee_address(const COMMAND_RPC_GET_FEE_ADDRESS::request& req, COMMAND_RPC_GET_FEE_ADDRESS::response& res);
   bool on_get_transaction_out_amounts_for_account(const COMMAND_RPC_GET_TRANSACTION_OUT_AMOUNTS_FOR_ACCOUNT::request& req, COMMAND_RPC_GET_TRANSACTION_OUT_AMOUNTS_FOR_ACCOUNT::response& res);
   bool on_get_collateral_hash(const COMMAND_RPC_GET_COLLATERAL_HASH::request& req, COMMAND_RPC_GET_COLLATERAL_HASH::response& res);
+  bool on_scan_subscribe(const COMMAND_RPC_SCAN_SUBSCRIBE::request& req, COMMAND_RPC_SCAN_SUBSCRIBE::response& res);
+  bool on_scan_unsubscribe(const COMMAND_RPC_SCAN_UNSUBSCRIBE::request& req, COMMAND_RPC_SCAN_UNSUBSCRIBE::response& res);
+  bool on_scan_get_outputs(const COMMAND_RPC_SCAN_GET_OUTPUTS::request& req, COMMAND_RPC_SCAN_GET_OUTPUTS::response& res);
 
   // json rpc
   bool on_getblockcount(const COMMAND_RPC_GETBLOCKCOUNT::request& req, COMMAND_RPC_GETBLOCKCOUNT::response& res);
@@ -133,6 +156,9 @@ private:
   Crypto::SecretKey m_view_key = NULL_SECRET_KEY;
   Crypto::Hash m_collateral_hash = NULL_HASH;
   AccountPublicAddress m_fee_acc;
+  Common::ThreadPool* m_threadPool;
+  std::unique_ptr<ViewKeyScanner> m_scanner;
+  std::unique_ptr<Common::ThreadPool> m_scanThreadPool;
 };
 
 }
@@ -43,6 +43,8 @@ namespace CryptoNote {
     const command_line::arg_descriptor<std::string> arg_chain_file      = { "rpc-chain-file", "SSL chain file", DEFAULT_RPC_CHAIN_FILE };
     const command_line::arg_descriptor<std::string> arg_key_file        = { "rpc-key-file", "SSL key file", DEFAULT_RPC_KEY_FILE };
     const command_line::arg_descriptor<std::string> arg_dh_file         = { "rpc-dh-file", "SSL DH file", DEFAULT_RPC_DH_FILE };
+    const command_line::arg_descriptor<uint32_t> arg_rpc_threads        = { "rpc-threads", "Number of threads serving read-only RPC requests, 0 serves them on the core thread", 0 };
+    const command_line::arg_descriptor<bool> arg_rpc_enable_scanning    = { "rpc-enable-scanning", "Enable the RPC scanning the blockchain for outputs of subscribed view keys, subscribers send their private view keys to this node", false };
   }
 
 
@@ -50,7 +52,9 @@ namespace CryptoNote {
     bindIp(DEFAULT_RPC_IP),
     bindPort(DEFAULT_RPC_PORT),
     enableSSL(false),
-    bindPortSSL(RPC_DEFAULT_SSL_PORT) {
+    bindPortSSL(RPC_DEFAULT_SSL_PORT),
+    threads(0),
+    enableScanning(false) {
   }
 
   bool RpcServerConfig::isEnabledSSL() const { return enableSSL; }
@@ -62,6 +66,8 @@ namespace CryptoNote {
   std::string RpcServerConfig::getDhFile() const { return dhFile; }
   std::string RpcServerConfig::getChainFile() const { return chainFile; }
   std::string RpcServerConfig::getKeyFile() const { return keyFile; }
+  uint32_t RpcServerConfig::getThreads() const { return threads; }
+  bool RpcServerConfig::isEnabledScanning() const { return enableScanning; }
   std::string RpcServerConfig::getBindAddress() const { return bindIp + ":" + std::to_string(bindPort); }
   std::string RpcServerConfig::getBindAddressSSL() const { return bindIp + ":" + std::to_string(bindPortSSL); }
 
@@ -75,6 +81,8 @@ namespace CryptoNote {
     command_line::add_arg(desc, arg_chain_file);
     command_line::add_arg(desc, arg_key_file);
     command_line::add_arg(desc, arg_dh_file);
+    command_line::add_arg(desc, arg_rpc_threads);
+    command_line::add_arg(desc, arg_rpc_enable_scanning);
   }
 
   void RpcServerConfig::init(const boost::program_options::variables_map& vm)  {
@@ -87,6 +95,8 @@ namespace CryptoNote {
     chainFile = command_line::get_arg(vm, arg_chain_file);
     keyFile = command_line::get_arg(vm, arg_key_file);
     dhFile = command_line::get_arg(vm, arg_dh_file);
+    threads = command_line::get_arg(vm, arg_rpc_threads);
+    enableScanning = command_line::get_arg(vm, arg_rpc_enable_scanning);
   }
 
 }
@@ -42,6 +42,8 @@ public:
   std::string getDhFile() const;
   std::string getChainFile() const;
   std::string getKeyFile() const;
+  uint32_t getThreads() const;
+  bool isEnabledScanning() const;
 
   bool        enableSSL;
   uint16_t    bindPort;
@@ -52,6 +54,8 @@ public:
   std::string dhFile;
   std::string chainFile;
   std::string keyFile;
+  uint32_t    threads;
+  bool        enableScanning;
 };
 
 }
@@ -0,0 +1,380 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ViewKeyScanner.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "Common/StringTools.h"
+#include "CryptoNoteCore/CachedTransaction.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/ICore.h"
+#include "CryptoNoteCore/TransactionApi.h"
+#include "CryptoNoteCore/TransactionUtils.h"
+
+namespace CryptoNote {
+
+namespace {
+
+const size_t MAX_SUBSCRIPTIONS = 1000;
+const size_t MAX_SPEND_KEYS = 1000;
+// Blocks scanned for one poll, the subscriber polls again until scannedIndex reaches the top block
+const uint32_t SCAN_BLOCKS_PER_POLL = 100;
+// Blocks times view keys scanned for one poll, bounds the derivations a single request costs
+const uint32_t SCAN_WORK_PER_POLL = 10000;
+// Scanning of a subscription stops until it takes its outputs
+const size_t MAX_PENDING_OUTPUTS = 10000;
+// Chain switches deeper than this rescan from the oldest block still remembered
+const uint32_t SCANNED_BLOCKS_HISTORY = 1000;
+const std::chrono::hours SUBSCRIPTION_TIMEOUT(1);
+
+}
+
+ViewKeyScanner::ViewKeyScanner(const ICore& core) : m_core(core) {
+}
+
+bool ViewKeyScanner::subscribe(const Crypto::SecretKey& viewSecretKey, const std::vector<Crypto::PublicKey>& spendPublicKeys,
+                               uint32_t startIndex, Crypto::Hash& subscriptionId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  removeExpiredSubscriptions();
+  if (m_subscriptions.size() >= MAX_SUBSCRIPTIONS || spendPublicKeys.empty() || spendPublicKeys.size() > MAX_SPEND_KEYS) {
+    return false;
+  }
+
+  Subscription subscription;
+  if (!Crypto::secret_key_to_public_key(viewSecretKey, subscription.viewPublicKey)) {
+    return false;
+  }
+
+  subscription.viewSecretKey = viewSecretKey;
+  subscription.spendPublicKeys.insert(spendPublicKeys.begin(), spendPublicKeys.end());
+  subscription.nextIndex = startIndex;
+  subscription.detached = false;
+  subscription.detachIndex = 0;
+  subscription.lastPoll = std::chrono::steady_clock::now();
+
+  subscriptionId = Crypto::rand<Crypto::Hash>();
+  m_subscriptions.emplace(subscriptionId, std::move(subscription));
+  return true;
+}
+
+bool ViewKeyScanner::unsubscribe(const Crypto::Hash& subscriptionId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_subscriptions.erase(subscriptionId) > 0;
+}
+
+bool ViewKeyScanner::prepareScan(const Crypto::Hash& subscriptionId, ScanJob& job) {
+  job = ScanJob();
+
+  std::vector<std::pair<uint32_t, Crypto::Hash>> scannedBlocks;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_subscriptions.count(subscriptionId) == 0) {
+      return false;
+    }
+
+    scannedBlocks.assign(m_scannedBlocks.begin(), m_scannedBlocks.end());
+  }
+
+  // The core is read without m_mutex, so other polls and subscriptions don't wait for this one
+  uint32_t topIndex = m_core.getTopBlockIndex();
+  uint32_t detachIndex;
+  bool switched = findSwitchedBlocks(scannedBlocks, topIndex, detachIndex);
+
+  uint32_t startIndex;
+  uint32_t endIndex;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_subscriptions.find(subscriptionId);
+    if (it == m_subscriptions.end()) {
+      return false;
+    }
+
+    Subscription& polled = it->second;
+    polled.lastPoll = std::chrono::steady_clock::now();
+
+    if (switched) {
+      detachSwitchedBlocks(detachIndex);
+    }
+
+    if (polled.nextIndex > topIndex || polled.pendingOutputs.size() >= MAX_PENDING_OUTPUTS) {
+      return true;
+    }
+
+    // Other subscriptions reached within the scanned blocks share the scan
+    startIndex = polled.nextIndex;
+    endIndex = startIndex + std::min(SCAN_BLOCKS_PER_POLL, topIndex - startIndex + 1);
+    std::unordered_set<Crypto::PublicKey> viewPublicKeys;
+    for (const auto& entry : m_subscriptions) {
+      const Subscription& subscription = entry.second;
+      if (subscription.nextIndex >= startIndex && subscription.nextIndex < endIndex && subscription.pendingOutputs.size() < MAX_PENDING_OUTPUTS) {
+        viewPublicKeys.insert(subscription.viewPublicKey);
+      }
+    }
+
+    endIndex = startIndex + std::max<uint32_t>(1, std::min<uint32_t>(endIndex - startIndex, SCAN_WORK_PER_POLL / static_cast<uint32_t>(viewPublicKeys.size())));
+
+    // Subscriptions sharing a view key are checked with a single key derivation per transaction
+    std::unordered_map<Crypto::PublicKey, size_t> groupIndexes;
+    for (const auto& entry : m_subscriptions) {
+      const Subscription& subscription = entry.second;
+      if (subscription.nextIndex < startIndex || subscription.nextIndex >= endIndex || subscription.pendingOutputs.size() >= MAX_PENDING_OUTPUTS) {
+        continue;
+      }
+
+      auto group = groupIndexes.emplace(subscription.viewPublicKey, job.groups.size());
+      if (group.second) {
+        job.groups.emplace_back();
+        job.groups.back().viewSecretKey = subscription.viewSecretKey;
+      }
+
+      ScanJob::ViewKeyGroup& viewKeyGroup = job.groups[group.first->second];
+      for (const Crypto::PublicKey& spendPublicKey : subscription.spendPublicKeys) {
+        viewKeyGroup.spendPublicKeys.insert(spendPublicKey);
+        viewKeyGroup.subscribers[spendPublicKey].push_back(job.participants.size());
+      }
+
+      job.participants.push_back(ScanJob::Participant{entry.first, subscription.nextIndex, {}});
+    }
+  }
+
+  std::vector<RawBlock> rawBlocks = m_core.getBlocks(startIndex, endIndex - startIndex);
+  job.blocks.reserve(rawBlocks.size());
+  for (size_t i = 0; i < rawBlocks.size(); ++i) {
+    ScanJob::Block block;
+    block.index = startIndex + static_cast<uint32_t>(i);
+    block.hash = m_core.getBlockHashByIndex(block.index);
+    block.rawBlock = std::move(rawBlocks[i]);
+    job.blocks.push_back(std::move(block));
+  }
+
+  return true;
+}
+
+void ViewKeyScanner::scan(ScanJob& job) {
+  for (ScanJob::Block& block : job.blocks) {
+    BlockTemplate blockTemplate;
+    if (!fromBinaryArray(blockTemplate, block.rawBlock.block)) {
+      throw std::runtime_error("Could not parse block " + std::to_string(block.index));
+    }
+
+    std::vector<CachedTransaction> transactions;
+    transactions.reserve(block.rawBlock.transactions.size() + 1);
+    transactions.emplace_back(std::move(blockTemplate.baseTransaction));
+    for (const BinaryArray& rawTransaction : block.rawBlock.transactions) {
+      transactions.emplace_back(rawTransaction);
+    }
+
+    for (size_t i = 0; i < transactions.size(); ++i) {
+      const Transaction& transaction = transactions[i].getTransaction();
+      const Crypto::Hash& transactionHash = transactions[i].getTransactionHash();
+      std::unique_ptr<ITransactionReader> reader = createTransactionPrefix(transaction, transactionHash);
+      Crypto::PublicKey transactionPublicKey = reader->getTransactionPublicKey();
+
+      for (ScanJob::ViewKeyGroup& group : job.groups) {
+        Crypto::KeyDerivation derivation;
+        if (!Crypto::generate_key_derivation(transactionPublicKey, group.viewSecretKey, derivation)) {
+          continue;
+        }
+
+        std::unordered_map<Crypto::PublicKey, std::vector<uint32_t>> outputs;
+        findOutputsToSpendKeys(*reader, derivation, group.spendPublicKeys, outputs);
+        if (!outputs.empty()) {
+          block.globalIndexes.emplace(transactionHash, std::vector<uint32_t>());
+        }
+
+        for (const auto& found : outputs) {
+          for (uint32_t outputIndex : found.second) {
+            const TransactionOutput& output = transaction.outputs[outputIndex];
+
+            ScannedOutput scannedOutput;
+            scannedOutput.blockIndex = block.index;
+            scannedOutput.blockHash = block.hash;
+            scannedOutput.transactionHash = transactionHash;
+            scannedOutput.transactionPublicKey = transactionPublicKey;
+            scannedOutput.outputIndex = outputIndex;
+            scannedOutput.globalOutputIndex = 0;
+            scannedOutput.amount = output.amount;
+            scannedOutput.outputKey = boost::get<KeyOutput>(output.target).key;
+            scannedOutput.spendPublicKey = found.first;
+
+            for (size_t participantIndex : group.subscribers[found.first]) {
+              ScanJob::Participant& participant = job.participants[participantIndex];
+              if (participant.startIndex <= block.index) {
+                participant.outputs.push_back(scannedOutput);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+bool ViewKeyScanner::foundOutputs(const ScanJob& job) {
+  return std::any_of(job.participants.begin(), job.participants.end(), [](const ScanJob::Participant& participant) {
+    return !participant.outputs.empty();
+  });
+}
+
+void ViewKeyScanner::resolveGlobalIndexes(ScanJob& job) const {
+  uint32_t topIndex = m_core.getTopBlockIndex();
+  size_t blockCount = 0;
+  for (; blockCount < job.blocks.size(); ++blockCount) {
+    ScanJob::Block& block = job.blocks[blockCount];
+    if (block.index > topIndex || m_core.getBlockHashByIndex(block.index) != block.hash) {
+      break;
+    }
+
+    for (auto& entry : block.globalIndexes) {
+      if (!m_core.getTransactionGlobalIndexes(entry.first, entry.second)) {
+        throw std::runtime_error("Could not get global indexes of transaction " + Common::podToHex(entry.first));
+      }
+    }
+  }
+
+  job.blocks.erase(job.blocks.begin() + blockCount, job.blocks.end());
+
+  for (ScanJob::Participant& participant : job.participants) {
+    auto output = participant.outputs.begin();
+    for (; output != participant.outputs.end(); ++output) {
+      if (job.blocks.empty() || output->blockIndex > job.blocks.back().index) {
+        break;
+      }
+
+      const ScanJob::Block& block = job.blocks[output->blockIndex - job.blocks.front().index];
+      output->globalOutputIndex = block.globalIndexes.at(output->transactionHash).at(output->outputIndex);
+    }
+
+    participant.outputs.erase(output, participant.outputs.end());
+  }
+}
+
+bool ViewKeyScanner::getOutputs(const Crypto::Hash& subscriptionId, const ScanJob& job, size_t maxCount,
+                                std::vector<ScannedOutput>& outputs, uint32_t& scannedIndex, bool& detached, uint32_t& detachIndex) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (const ScanJob::Participant& participant : job.participants) {
+    auto it = m_subscriptions.find(participant.subscriptionId);
+    // Skipped if a chain switch or another poll moved it meanwhile
+    if (it != m_subscriptions.end() && it->second.nextIndex == participant.startIndex) {
+      applyScan(it->second, participant, job);
+    }
+  }
+
+  for (const ScanJob::Block& block : job.blocks) {
+    m_scannedBlocks[block.index] = block.hash;
+  }
+
+  if (!m_scannedBlocks.empty() && m_scannedBlocks.rbegin()->first >= SCANNED_BLOCKS_HISTORY) {
+    m_scannedBlocks.erase(m_scannedBlocks.begin(), m_scannedBlocks.lower_bound(m_scannedBlocks.rbegin()->first - SCANNED_BLOCKS_HISTORY + 1));
+  }
+
+  auto it = m_subscriptions.find(subscriptionId);
+  if (it == m_subscriptions.end()) {
+    return false;
+  }
+
+  Subscription& subscription = it->second;
+  size_t count = std::min(maxCount, subscription.pendingOutputs.size());
+  outputs.assign(subscription.pendingOutputs.begin(), subscription.pendingOutputs.begin() + count);
+  subscription.pendingOutputs.erase(subscription.pendingOutputs.begin(), subscription.pendingOutputs.begin() + count);
+
+  scannedIndex = subscription.pendingOutputs.empty() ? subscription.nextIndex : subscription.pendingOutputs.front().blockIndex;
+  detached = subscription.detached;
+  detachIndex = subscription.detachIndex;
+  subscription.detached = false;
+  return true;
+}
+
+void ViewKeyScanner::removeExpiredSubscriptions() {
+  auto now = std::chrono::steady_clock::now();
+  for (auto it = m_subscriptions.begin(); it != m_subscriptions.end();) {
+    if (now - it->second.lastPoll > SUBSCRIPTION_TIMEOUT) {
+      it = m_subscriptions.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+// Blocks are linked by hash, so the search stops at the first remembered block still in the main chain
+bool ViewKeyScanner::findSwitchedBlocks(const std::vector<std::pair<uint32_t, Crypto::Hash>>& scannedBlocks, uint32_t topIndex,
+                                        uint32_t& detachIndex) const {
+  auto firstSwitched = scannedBlocks.end();
+  while (firstSwitched != scannedBlocks.begin()) {
+    auto previous = std::prev(firstSwitched);
+    if (previous->first <= topIndex && m_core.getBlockHashByIndex(previous->first) == previous->second) {
+      break;
+    }
+
+    firstSwitched = previous;
+  }
+
+  if (firstSwitched == scannedBlocks.end()) {
+    return false;
+  }
+
+  // Blocks between the last matching and the first switched one may not be remembered, so they are rescanned too
+  detachIndex = firstSwitched == scannedBlocks.begin() ? firstSwitched->first : std::prev(firstSwitched)->first + 1;
+  return true;
+}
+
+void ViewKeyScanner::detachSwitchedBlocks(uint32_t detachIndex) {
+  m_scannedBlocks.erase(m_scannedBlocks.lower_bound(detachIndex), m_scannedBlocks.end());
+
+  for (auto& entry : m_subscriptions) {
+    Subscription& subscription = entry.second;
+    if (subscription.nextIndex <= detachIndex) {
+      continue;
+    }
+
+    while (!subscription.pendingOutputs.empty() && subscription.pendingOutputs.back().blockIndex >= detachIndex) {
+      subscription.pendingOutputs.pop_back();
+    }
+
+    subscription.detachIndex = subscription.detached ? std::min(subscription.detachIndex, detachIndex) : detachIndex;
+    subscription.detached = true;
+    subscription.nextIndex = detachIndex;
+  }
+}
+
+void ViewKeyScanner::applyScan(Subscription& subscription, const ScanJob::Participant& participant, const ScanJob& job) {
+  auto output = participant.outputs.begin();
+  for (const ScanJob::Block& block : job.blocks) {
+    if (block.index < participant.startIndex) {
+      continue;
+    }
+
+    if (subscription.pendingOutputs.size() >= MAX_PENDING_OUTPUTS) {
+      break;
+    }
+
+    for (; output != participant.outputs.end() && output->blockIndex == block.index; ++output) {
+      subscription.pendingOutputs.push_back(*output);
+    }
+
+    subscription.nextIndex = block.index + 1;
+  }
+}
+
+}
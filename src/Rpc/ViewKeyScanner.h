@@ -0,0 +1,130 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "CryptoNote.h"
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+class ICore;
+
+struct ScannedOutput {
+  uint32_t blockIndex;
+  Crypto::Hash blockHash;
+  Crypto::Hash transactionHash;
+  Crypto::PublicKey transactionPublicKey;
+  uint32_t outputIndex;
+  uint32_t globalOutputIndex;
+  uint64_t amount;
+  Crypto::PublicKey outputKey;
+  Crypto::PublicKey spendPublicKey;
+};
+
+// Finds outputs of many subscribed wallets in the main chain. Each block is read once for all subscriptions that
+// reached it and the key derivation of a transaction is computed once per view key, however many spend keys share
+// it. Scanning advances when a subscription is polled, so an idle node does no work. A poll copies the blocks in
+// prepareScan with the core locked for reading, derives keys in scan without any lock, looks up global indexes of the
+// outputs found in resolveGlobalIndexes with the core locked again and takes the outputs with getOutputs.
+class ViewKeyScanner {
+public:
+  struct ScanJob {
+    struct Block {
+      uint32_t index;
+      Crypto::Hash hash;
+      RawBlock rawBlock;
+      // Of the transactions scan found outputs in, keyed by transaction hash
+      std::unordered_map<Crypto::Hash, std::vector<uint32_t>> globalIndexes;
+    };
+
+    struct Participant {
+      Crypto::Hash subscriptionId;
+      uint32_t startIndex;
+      std::vector<ScannedOutput> outputs;
+    };
+
+    struct ViewKeyGroup {
+      Crypto::SecretKey viewSecretKey;
+      std::unordered_set<Crypto::PublicKey> spendPublicKeys;
+      // Indexes in participants
+      std::unordered_map<Crypto::PublicKey, std::vector<size_t>> subscribers;
+    };
+
+    std::vector<Block> blocks;
+    std::vector<ViewKeyGroup> groups;
+    std::vector<Participant> participants;
+  };
+
+  explicit ViewKeyScanner(const ICore& core);
+
+  // Returns false if there are too many subscriptions or spend keys
+  bool subscribe(const Crypto::SecretKey& viewSecretKey, const std::vector<Crypto::PublicKey>& spendPublicKeys,
+                 uint32_t startIndex, Crypto::Hash& subscriptionId);
+  bool unsubscribe(const Crypto::Hash& subscriptionId);
+
+  // Copies the next blocks of the subscription and of the others that reached them. The number of blocks is limited
+  // so that blocks times view keys stays within a fixed amount of work per poll.
+  bool prepareScan(const Crypto::Hash& subscriptionId, ScanJob& job);
+  static void scan(ScanJob& job);
+  static bool foundOutputs(const ScanJob& job);
+  // Blocks that left the main chain since prepareScan are dropped from the job with all blocks after them, the
+  // subscriptions scan them again from the new chain
+  void resolveGlobalIndexes(ScanJob& job) const;
+
+  // Returns up to maxCount outputs found since the previous call. Outputs of all blocks below scannedIndex have been
+  // returned. detached is set once after a chain switch, outputs returned before from blocks at detachIndex and
+  // above must be dropped then, they are reported again if they are still in the main chain.
+  bool getOutputs(const Crypto::Hash& subscriptionId, const ScanJob& job, size_t maxCount, std::vector<ScannedOutput>& outputs,
+                  uint32_t& scannedIndex, bool& detached, uint32_t& detachIndex);
+
+private:
+  struct Subscription {
+    Crypto::SecretKey viewSecretKey;
+    Crypto::PublicKey viewPublicKey;
+    std::unordered_set<Crypto::PublicKey> spendPublicKeys;
+    uint32_t nextIndex;
+    std::deque<ScannedOutput> pendingOutputs;
+    bool detached;
+    uint32_t detachIndex;
+    std::chrono::steady_clock::time_point lastPoll;
+  };
+
+  void removeExpiredSubscriptions();
+  bool findSwitchedBlocks(const std::vector<std::pair<uint32_t, Crypto::Hash>>& scannedBlocks, uint32_t topIndex,
+                          uint32_t& detachIndex) const;
+  void detachSwitchedBlocks(uint32_t detachIndex);
+  void applyScan(Subscription& subscription, const ScanJob::Participant& participant, const ScanJob& job);
+
+  const ICore& m_core;
+  std::mutex m_mutex;
+  std::unordered_map<Crypto::Hash, Subscription> m_subscriptions;
+  // Hashes of the most recently scanned blocks, to find where the main chain switched
+  std::map<uint32_t, Crypto::Hash> m_scannedBlocks;
+};
+
+}
@@ -0,0 +1,360 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "KVBinaryInputBufferSerializer.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "KVBinaryCommon.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+// A plain array value is an array whose items are arrays again, see loadValue of KVBinaryInputStreamSerializer
+uint8_t normalizeType(uint8_t type) {
+  return type == BIN_KV_SERIALIZE_TYPE_ARRAY ? (BIN_KV_SERIALIZE_TYPE_ARRAY | BIN_KV_SERIALIZE_FLAG_ARRAY) : type;
+}
+
+template <typename T>
+T readPod(const char* data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+}
+
+KVBinaryInputBufferSerializer::KVBinaryInputBufferSerializer(const void* data, size_t size) :
+  m_end(static_cast<const char*>(data) + size) {
+  const char* begin = static_cast<const char*>(data);
+  require(begin, sizeof(KVBinaryStorageBlockHeader));
+  auto hdr = readPod<KVBinaryStorageBlockHeader>(begin);
+
+  if (hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA || hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
+    throw std::runtime_error("Invalid binary storage signature");
+  }
+
+  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
+    throw std::runtime_error("Unknown binary storage format version");
+  }
+
+  // Indexing the root skips over every value, so malformed input is rejected here like the DOM parser does
+  m_scopes.push_back({false, 0, 0, 0, nullptr});
+  indexSection(begin + sizeof(hdr));
+}
+
+ISerializer::SerializerType KVBinaryInputBufferSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool KVBinaryInputBufferSerializer::beginObject(Common::StringView name) {
+  uint8_t type;
+  const char* data;
+  if (!findValue(name, type, data)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+    throw std::runtime_error("Value type is not OBJECT");
+  }
+
+  m_scopes.push_back({false, m_entries.size(), 0, 0, nullptr});
+  indexSection(data);
+  return true;
+}
+
+void KVBinaryInputBufferSerializer::endObject() {
+  assert(m_scopes.size() > 1 && !m_scopes.back().isArray);
+  m_entries.erase(m_entries.begin() + m_scopes.back().entriesBegin, m_entries.end());
+  m_scopes.pop_back();
+}
+
+bool KVBinaryInputBufferSerializer::beginArray(size_t& size, Common::StringView name) {
+  if (m_scopes.back().isArray) {
+    throw std::runtime_error("Value type is not OBJECT");
+  }
+
+  uint8_t type;
+  const char* data;
+  if (!findValue(name, type, data)) {
+    size = 0;
+    return false;
+  }
+
+  if ((type & BIN_KV_SERIALIZE_FLAG_ARRAY) == 0) {
+    throw std::runtime_error("Value type is not ARRAY");
+  }
+
+  size = readVarint(data);
+  m_scopes.push_back({true, m_entries.size(), normalizeType(type & ~BIN_KV_SERIALIZE_FLAG_ARRAY), size, data});
+  return true;
+}
+
+void KVBinaryInputBufferSerializer::endArray() {
+  assert(m_scopes.size() > 1 && m_scopes.back().isArray);
+  m_scopes.pop_back();
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+// Doubles are stored as reals and the DOM based serializer only reads integers, keep rejecting them the same way
+bool KVBinaryInputBufferSerializer::operator()(double& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool KVBinaryInputBufferSerializer::operator()(bool& value, Common::StringView name) {
+  uint8_t type;
+  const char* data;
+  if (!findValue(name, type, data)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_BOOL) {
+    throw std::runtime_error("Value type is not BOOL");
+  }
+
+  value = *data != 0;
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::operator()(std::string& value, Common::StringView name) {
+  uint8_t type;
+  const char* data;
+  if (!findValue(name, type, data)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("Value type is not STRING");
+  }
+
+  auto view = readString(data);
+  value.assign(view.getData(), view.getSize());
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::binary(void* value, size_t size, Common::StringView name) {
+  uint8_t type;
+  const char* data;
+  if (!findValue(name, type, data)) {
+    return false;
+  }
+
+  if (type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("Value type is not STRING");
+  }
+
+  auto view = readString(data);
+  if (view.getSize() != size) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  memcpy(value, view.getData(), size);
+  return true;
+}
+
+bool KVBinaryInputBufferSerializer::binary(std::string& value, Common::StringView name) {
+  return (*this)(value, name); // load as string
+}
+
+// Items of arrays are taken in order whatever name is asked for, fields of objects are looked up by name and the first
+// one wins if a name repeats
+bool KVBinaryInputBufferSerializer::findValue(Common::StringView name, uint8_t& type, const char*& data) {
+  Scope& scope = m_scopes.back();
+  if (scope.isArray) {
+    if (scope.itemsLeft == 0) {
+      throw std::runtime_error("Array index out of range");
+    }
+
+    --scope.itemsLeft;
+    type = scope.itemType;
+    data = scope.cursor;
+    scope.cursor = skipValue(data, type);
+    return true;
+  }
+
+  for (size_t i = scope.entriesBegin; i < m_entries.size(); ++i) {
+    if (m_entries[i].name == name) {
+      type = m_entries[i].type;
+      data = m_entries[i].data;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const char* KVBinaryInputBufferSerializer::indexSection(const char* data) {
+  size_t count = readVarint(data);
+  while (count--) {
+    uint8_t nameSize = readByte(data);
+    const char* name = data + 1;
+    data = require(name, nameSize);
+
+    uint8_t type = normalizeType(readByte(data));
+    ++data;
+
+    m_entries.push_back({Common::StringView(name, nameSize), type, data});
+    data = skipValue(data, type);
+  }
+
+  return data;
+}
+
+const char* KVBinaryInputBufferSerializer::skipValue(const char* data, uint8_t type) const {
+  if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+    return skipArray(data, normalizeType(type & ~BIN_KV_SERIALIZE_FLAG_ARRAY));
+  }
+
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:
+  case BIN_KV_SERIALIZE_TYPE_UINT64:
+  case BIN_KV_SERIALIZE_TYPE_DOUBLE:
+    return require(data, 8);
+  case BIN_KV_SERIALIZE_TYPE_INT32:
+  case BIN_KV_SERIALIZE_TYPE_UINT32:
+    return require(data, 4);
+  case BIN_KV_SERIALIZE_TYPE_INT16:
+  case BIN_KV_SERIALIZE_TYPE_UINT16:
+    return require(data, 2);
+  case BIN_KV_SERIALIZE_TYPE_INT8:
+  case BIN_KV_SERIALIZE_TYPE_UINT8:
+  case BIN_KV_SERIALIZE_TYPE_BOOL:
+    return require(data, 1);
+  case BIN_KV_SERIALIZE_TYPE_STRING: {
+    auto view = readString(data);
+    return view.getData() + view.getSize();
+  }
+  case BIN_KV_SERIALIZE_TYPE_OBJECT: {
+    size_t count = readVarint(data);
+    while (count--) {
+      uint8_t nameSize = readByte(data);
+      data = require(data + 1, nameSize);
+      uint8_t entryType = readByte(data);
+      data = skipValue(data + 1, normalizeType(entryType));
+    }
+
+    return data;
+  }
+  default:
+    throw std::runtime_error("Unknown data type");
+  }
+}
+
+const char* KVBinaryInputBufferSerializer::skipArray(const char* data, uint8_t itemType) const {
+  size_t count = readVarint(data);
+  while (count--) {
+    data = skipValue(data, itemType);
+  }
+
+  return data;
+}
+
+size_t KVBinaryInputBufferSerializer::readVarint(const char*& data) const {
+  uint8_t b = readByte(data);
+  size_t bytesLeft = 0;
+
+  switch (b & PORTABLE_RAW_SIZE_MARK_MASK) {
+  case PORTABLE_RAW_SIZE_MARK_BYTE:
+    bytesLeft = 0;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_WORD:
+    bytesLeft = 1;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_DWORD:
+    bytesLeft = 3;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_INT64:
+    bytesLeft = 7;
+    break;
+  }
+
+  require(data + 1, bytesLeft);
+  size_t value = b;
+  for (size_t i = 1; i <= bytesLeft; ++i) {
+    size_t n = static_cast<uint8_t>(data[i]);
+    value |= n << (i * 8);
+  }
+
+  data += bytesLeft + 1;
+  return value >> 2;
+}
+
+Common::StringView KVBinaryInputBufferSerializer::readString(const char* data) const {
+  size_t size = readVarint(data);
+  require(data, size);
+  return Common::StringView(data, size);
+}
+
+uint8_t KVBinaryInputBufferSerializer::readByte(const char* data) const {
+  require(data, 1);
+  return static_cast<uint8_t>(*data);
+}
+
+// Returns the end of the range, throws if it goes past the buffer
+const char* KVBinaryInputBufferSerializer::require(const char* data, size_t size) const {
+  if (size > static_cast<size_t>(m_end - data)) {
+    throw std::runtime_error("Unexpected end of binary storage");
+  }
+
+  return data + size;
+}
+
+// Values were bounds checked when their section or array was skipped over
+int64_t KVBinaryInputBufferSerializer::readInteger(uint8_t type, const char* data) const {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  return readPod<int64_t>(data);
+  case BIN_KV_SERIALIZE_TYPE_INT32:  return readPod<int32_t>(data);
+  case BIN_KV_SERIALIZE_TYPE_INT16:  return readPod<int16_t>(data);
+  case BIN_KV_SERIALIZE_TYPE_INT8:   return readPod<int8_t>(data);
+  case BIN_KV_SERIALIZE_TYPE_UINT64: return static_cast<int64_t>(readPod<uint64_t>(data));
+  case BIN_KV_SERIALIZE_TYPE_UINT32: return readPod<uint32_t>(data);
+  case BIN_KV_SERIALIZE_TYPE_UINT16: return readPod<uint16_t>(data);
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readPod<uint8_t>(data);
+  default:
+    throw std::runtime_error("Value type is not INTEGER");
+  }
+}
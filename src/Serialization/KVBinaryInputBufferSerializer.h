@@ -0,0 +1,102 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Reads KV binary storage in place instead of parsing it into a JsonValue first. Fields of the object being read are
+// indexed by name on beginObject, values are decoded from the buffer when requested. Accepts the same input and
+// follows the same lookup rules as KVBinaryInputStreamSerializer. The buffer must outlive the serializer.
+class KVBinaryInputBufferSerializer : public ISerializer {
+public:
+  KVBinaryInputBufferSerializer(const void* data, size_t size);
+
+  SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  // type keeps BIN_KV_SERIALIZE_FLAG_ARRAY, data points right after the type byte
+  struct Entry {
+    Common::StringView name;
+    uint8_t type;
+    const char* data;
+  };
+
+  struct Scope {
+    bool isArray;
+    size_t entriesBegin;
+    uint8_t itemType;
+    size_t itemsLeft;
+    const char* cursor;
+  };
+
+  const char* m_end;
+  std::vector<Entry> m_entries;
+  std::vector<Scope> m_scopes;
+
+  bool findValue(Common::StringView name, uint8_t& type, const char*& data);
+  const char* indexSection(const char* data);
+  const char* skipValue(const char* data, uint8_t type) const;
+  const char* skipArray(const char* data, uint8_t itemType) const;
+  uint8_t readByte(const char* data) const;
+  size_t readVarint(const char*& data) const;
+  Common::StringView readString(const char* data) const;
+  const char* require(const char* data, size_t size) const;
+  int64_t readInteger(uint8_t type, const char* data) const;
+
+  template<typename T>
+  bool getNumber(Common::StringView name, T& value) {
+    uint8_t type;
+    const char* data;
+    if (!findValue(name, type, data)) {
+      return false;
+    }
+
+    value = static_cast<T>(readInteger(type, data));
+    return true;
+  }
+};
+
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "KVBinaryStreamWriter.h"
+#include "KVBinaryCommon.h"
+
+#include <limits>
+#include <stdexcept>
+#include <Common/StreamTools.h>
+
+namespace CryptoNote {
+
+KVBinaryStreamWriter::KVBinaryStreamWriter(Common::IOutputStream& target) : m_target(target) {
+  KVBinaryStorageBlockHeader hdr;
+  hdr.m_signature_a = PORTABLE_STORAGE_SIGNATUREA;
+  hdr.m_signature_b = PORTABLE_STORAGE_SIGNATUREB;
+  hdr.m_ver = PORTABLE_STORAGE_FORMAT_VER;
+
+  Common::write(m_target, &hdr, sizeof(hdr));
+}
+
+void KVBinaryStreamWriter::beginObject(size_t fieldCount) {
+  writeArraySize(fieldCount);
+}
+
+void KVBinaryStreamWriter::beginObjectArray(Common::StringView name, size_t size) {
+  writeElementPrefix(name, BIN_KV_SERIALIZE_FLAG_ARRAY | BIN_KV_SERIALIZE_TYPE_OBJECT);
+  writeArraySize(size);
+}
+
+void KVBinaryStreamWriter::beginStringArray(Common::StringView name, size_t size) {
+  writeElementPrefix(name, BIN_KV_SERIALIZE_FLAG_ARRAY | BIN_KV_SERIALIZE_TYPE_STRING);
+  writeArraySize(size);
+}
+
+void KVBinaryStreamWriter::writeUint32(Common::StringView name, uint32_t value) {
+  writeElementPrefix(name, BIN_KV_SERIALIZE_TYPE_UINT32);
+  Common::write(m_target, &value, sizeof(value));
+}
+
+void KVBinaryStreamWriter::writeUint64(Common::StringView name, uint64_t value) {
+  writeElementPrefix(name, BIN_KV_SERIALIZE_TYPE_UINT64);
+  Common::write(m_target, &value, sizeof(value));
+}
+
+void KVBinaryStreamWriter::writeString(Common::StringView name, const void* data, size_t size) {
+  writeElementPrefix(name, BIN_KV_SERIALIZE_TYPE_STRING);
+  writeString(data, size);
+}
+
+void KVBinaryStreamWriter::writeString(const void* data, size_t size) {
+  writeArraySize(size);
+  Common::write(m_target, data, size);
+}
+
+void KVBinaryStreamWriter::writeElementPrefix(Common::StringView name, uint8_t type) {
+  if (name.getSize() > std::numeric_limits<uint8_t>::max()) {
+    throw std::runtime_error("Element name is too long");
+  }
+
+  uint8_t length = static_cast<uint8_t>(name.getSize());
+  Common::write(m_target, &length, sizeof(length));
+  Common::write(m_target, name.getData(), length);
+  Common::write(m_target, &type, sizeof(type));
+}
+
+void KVBinaryStreamWriter::writeArraySize(size_t size) {
+  if (size <= 63) {
+    uint8_t value = static_cast<uint8_t>((size << 2) | PORTABLE_RAW_SIZE_MARK_BYTE);
+    Common::write(m_target, &value, sizeof(value));
+  } else if (size <= 16383) {
+    uint16_t value = static_cast<uint16_t>((size << 2) | PORTABLE_RAW_SIZE_MARK_WORD);
+    Common::write(m_target, &value, sizeof(value));
+  } else if (size <= 1073741823) {
+    uint32_t value = static_cast<uint32_t>((size << 2) | PORTABLE_RAW_SIZE_MARK_DWORD);
+    Common::write(m_target, &value, sizeof(value));
+  } else {
+    if (size > 4611686018427387903) {
+      throw std::runtime_error("failed to pack varint - too big amount");
+    }
+
+    uint64_t value = (static_cast<uint64_t>(size) << 2) | PORTABLE_RAW_SIZE_MARK_INT64;
+    Common::write(m_target, &value, sizeof(value));
+  }
+}
+
+}
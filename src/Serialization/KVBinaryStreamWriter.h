@@ -0,0 +1,55 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Common/IOutputStream.h>
+#include <Common/StringView.h>
+
+namespace CryptoNote {
+
+// Writes KV binary storage straight into the target stream. KVBinaryOutputStreamSerializer buffers every object to
+// count its fields and copies it into the parent when the object ends, here the caller passes the number of fields
+// and array elements up front, so large blobs are copied once. Values are encoded the same way the serializer does.
+class KVBinaryStreamWriter {
+public:
+  // Writes the storage header, the root object has to be started next
+  explicit KVBinaryStreamWriter(Common::IOutputStream& target);
+
+  // Root object or an element of an object array
+  void beginObject(size_t fieldCount);
+  void beginObjectArray(Common::StringView name, size_t size);
+  void beginStringArray(Common::StringView name, size_t size);
+
+  void writeUint32(Common::StringView name, uint32_t value);
+  void writeUint64(Common::StringView name, uint64_t value);
+  void writeString(Common::StringView name, const void* data, size_t size);
+
+  // Element of a string array
+  void writeString(const void* data, size_t size);
+
+private:
+  void writeElementPrefix(Common::StringView name, uint8_t type);
+  void writeArraySize(size_t size);
+
+  Common::IOutputStream& m_target;
+};
+
+}
@@ -23,6 +23,7 @@
 #include <Common/StringOutputStream.h>
 #include "JsonInputStreamSerializer.h"
 #include "JsonOutputStreamSerializer.h"
+#include "KVBinaryInputBufferSerializer.h"
 #include "KVBinaryInputStreamSerializer.h"
 #include "KVBinaryOutputStreamSerializer.h"
 
@@ -122,8 +123,7 @@ std::string storeToBinaryKeyValue(const T& v) {
 template <typename T>
 bool loadFromBinaryKeyValue(T& v, const std::string& buf) {
   try {
-    Common::MemoryInputStream stream(buf.data(), buf.size());
-    KVBinaryInputStreamSerializer s(stream);
+    KVBinaryInputBufferSerializer s(buf.data(), buf.size());
     serialize(v, s);
     return true;
   } catch (std::exception&) {
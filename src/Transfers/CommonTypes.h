@@ -38,6 +38,8 @@ struct CompleteBlock {
   boost::optional<CryptoNote::BlockTemplate> block;
   // first transaction is always coinbase
   std::list<std::shared_ptr<ITransactionReader>> transactions;
+  // global output indexes of the transactions above in the same order, empty if the node didn't provide them
+  std::vector<std::vector<uint32_t>> globalIndexes;
 };
 
 }
@@ -18,13 +18,17 @@
 
 #include "TransfersConsumer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <numeric>
+#include <thread>
 
 #include "CommonTypes.h"
-#include "Common/BlockingQueue.h"
+#include "Common/ThreadPool.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionApi.h"
+#include "CryptoNoteCore/TransactionUtils.h"
 
 #include "IWallet.h"
 #include "INode.h"
@@ -50,55 +54,51 @@ private:
     Crypto::Hash m_txHash;
 };
 
-void checkOutputKey(
-  const KeyDerivation& derivation,
-  const PublicKey& key,
-  size_t keyIndex,
-  size_t outputIndex,
-  const std::unordered_set<PublicKey>& spendKeys,
-  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
-
-  PublicKey spendKey;
-  underive_public_key(derivation, keyIndex, key, spendKey);
-
-  if (spendKeys.find(spendKey) != spendKeys.end()) {
-    outputs[spendKey].push_back(static_cast<uint32_t>(outputIndex));
-  }
-
-}
-
 void findMyOutputs(
   const ITransactionReader& tx,
   const SecretKey& viewSecretKey,
   const std::unordered_set<PublicKey>& spendKeys,
   std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
 
-  auto txPublicKey = tx.getTransactionPublicKey();
   KeyDerivation derivation;
-
-  if (!generate_key_derivation( txPublicKey, viewSecretKey, derivation)) {
+  if (!generate_key_derivation(tx.getTransactionPublicKey(), viewSecretKey, derivation)) {
     return;
   }
 
-  size_t keyIndex = 0;
-  size_t outputCount = tx.getOutputCount();
-
-  for (size_t idx = 0; idx < outputCount; ++idx) {
-
-    auto outType = tx.getOutputType(size_t(idx));
+  findOutputsToSpendKeys(tx, derivation, spendKeys, outputs);
+}
 
-    if (outType == TransactionTypes::OutputType::Key) {
+// Scans a batch of transactions: all key derivations first, then all output keys, so each pass runs one kind of
+// group operation over a contiguous batch
+void findMyOutputs(
+  const std::vector<const ITransactionReader*>& txs,
+  const SecretKey& viewSecretKey,
+  const std::unordered_set<PublicKey>& spendKeys,
+  std::vector<std::unordered_map<PublicKey, std::vector<uint32_t>>>& outputs) {
 
-      uint64_t amount;
-      KeyOutput out;
-      tx.getOutput(idx, out, amount);
-      checkOutputKey(derivation, out.key, keyIndex, idx, spendKeys, outputs);
-      ++keyIndex;
+  std::vector<KeyDerivation> derivations(txs.size());
+  std::vector<bool> derived(txs.size());
+  for (size_t i = 0; i < txs.size(); ++i) {
+    derived[i] = generate_key_derivation(txs[i]->getTransactionPublicKey(), viewSecretKey, derivations[i]);
+  }
 
+  outputs.resize(txs.size());
+  for (size_t i = 0; i < txs.size(); ++i) {
+    if (derived[i]) {
+      findOutputsToSpendKeys(*txs[i], derivations[i], spendKeys, outputs[i]);
     }
   }
 }
 
+// Transactions handed to a scanning job at once
+const size_t SCAN_BATCH_SIZE = 32;
+
+// Long-lived workers shared by all consumers, so a sync batch doesn't start threads of its own
+Common::ThreadPool& getScanningThreadPool() {
+  static Common::ThreadPool threadPool(std::max<size_t>(std::thread::hardware_concurrency(), 1));
+  return threadPool;
+}
+
 std::vector<Crypto::Hash> getBlockHashes(const CryptoNote::CompleteBlock* blocks, size_t count) {
   std::vector<Crypto::Hash> result;
   result.reserve(count);
@@ -207,96 +207,98 @@ uint32_t TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t st
   struct Tx {
     TransactionBlockInfo blockInfo;
     const ITransactionReader* tx;
+    const std::vector<uint32_t>* knownGlobalIdxs;
     bool isLastTransactionInBlock;
   };
 
   struct PreprocessedTx : Tx, PreprocessInfo {};
 
   std::vector<PreprocessedTx> preprocessedTransactions;
-  std::mutex preprocessedTransactionsMutex;
+  size_t emptyBlockCount = 0;
 
-  size_t workers = std::thread::hardware_concurrency();
-  if (workers == 0) {
-    workers = 2;
-  }
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto& block = blocks[i].block;
 
-  BlockingQueue<Tx> inputQueue(workers * 2);
+    if (!block.is_initialized()) {
+      ++emptyBlockCount;
+      continue;
+    }
 
-  std::atomic<bool> stopProcessing(false);
-  std::atomic<size_t> emptyBlockCount(0);
+    // filter by syncStartTimestamp
+    if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
+      ++emptyBlockCount;
+      continue;
+    }
 
-  auto pushingThread = std::async(std::launch::async, [&] {
-    for( uint32_t i = 0; i < count && !stopProcessing; ++i) {
-      const auto& block = blocks[i].block;
+    TransactionBlockInfo blockInfo;
+    blockInfo.height = startHeight + i;
+    blockInfo.timestamp = block->timestamp;
+    blockInfo.transactionIndex = 0; // position in block
 
-      if (!block.is_initialized()) {
-        ++emptyBlockCount;
+    for (const auto& tx : blocks[i].transactions) {
+      auto pubKey = tx->getTransactionPublicKey();
+      if (pubKey == NULL_PUBLIC_KEY) {
+        ++blockInfo.transactionIndex;
         continue;
       }
 
-      // filter by syncStartTimestamp
-      if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
-        ++emptyBlockCount;
-        continue;
-      }
+      const auto& blockGlobalIdxs = blocks[i].globalIndexes;
+      const std::vector<uint32_t>* globalIdxs =
+        blockInfo.transactionIndex < blockGlobalIdxs.size() ? &blockGlobalIdxs[blockInfo.transactionIndex] : nullptr;
 
-      TransactionBlockInfo blockInfo;
-      blockInfo.height = startHeight + i;
-      blockInfo.timestamp = block->timestamp;
-      blockInfo.transactionIndex = 0; // position in block
-
-      for (const auto& tx : blocks[i].transactions) {
-        auto pubKey = tx->getTransactionPublicKey();
-        if (pubKey == NULL_PUBLIC_KEY) {
-          ++blockInfo.transactionIndex;
-          continue;
-        }
-
-        bool isLastTransactionInBlock = blockInfo.transactionIndex + 1 == blocks[i].transactions.size();
-        Tx item = { blockInfo, tx.get(), isLastTransactionInBlock };
-        inputQueue.push(item);
-        ++blockInfo.transactionIndex;
-      }
+      bool isLastTransactionInBlock = blockInfo.transactionIndex + 1 == blocks[i].transactions.size();
+      PreprocessedTx item;
+      static_cast<Tx&>(item) = { blockInfo, tx.get(), globalIdxs, isLastTransactionInBlock };
+      preprocessedTransactions.push_back(std::move(item));
+      ++blockInfo.transactionIndex;
     }
+  }
 
-    inputQueue.close();
-  });
+  // Every batch owns its slice of preprocessedTransactions and its error slot, so workers don't share anything
+  // mutable and the results stay in block order
+  size_t batchCount = (preprocessedTransactions.size() + SCAN_BATCH_SIZE - 1) / SCAN_BATCH_SIZE;
+  std::vector<std::error_code> batchErrors(batchCount);
+  std::atomic<bool> stopProcessing(false);
 
-  auto processingFunction = [&] {
-    Tx item;
-    std::error_code ec;
-    while (!stopProcessing && inputQueue.pop(item)) {
-      PreprocessedTx output;
-      static_cast<Tx&>(output) = item;
+  auto processBatch = [&](size_t batchIndex) {
+    if (stopProcessing) {
+      return;
+    }
+
+    size_t begin = batchIndex * SCAN_BATCH_SIZE;
+    size_t end = std::min(begin + SCAN_BATCH_SIZE, preprocessedTransactions.size());
+
+    std::vector<const ITransactionReader*> txs;
+    txs.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+      txs.push_back(preprocessedTransactions[i].tx);
+    }
 
-      ec = preprocessOutputs(item.blockInfo, *item.tx, output);
+    std::vector<std::unordered_map<PublicKey, std::vector<uint32_t>>> outputs;
+    findMyOutputs(txs, m_viewSecret, m_spendKeys, outputs);
+
+    for (size_t i = begin; i < end && !stopProcessing; ++i) {
+      auto& item = preprocessedTransactions[i];
+      std::error_code ec = preprocessOutputs(item.blockInfo, *item.tx, outputs[i - begin], item.knownGlobalIdxs, item);
       if (ec) {
+        batchErrors[batchIndex] = ec;
         stopProcessing = true;
-        break;
       }
-
-      std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
-      preprocessedTransactions.push_back(std::move(output));
     }
-    return ec;
   };
 
-  std::vector<std::future<std::error_code>> processingThreads;
-  for (size_t i = 0; i < workers; ++i) {
-    processingThreads.push_back(std::async(std::launch::async, processingFunction));
+  std::error_code processingError;
+  try {
+    getScanningThreadPool().parallelFor(batchCount, processBatch);
+  } catch (const std::system_error& e) {
+    processingError = e.code();
+  } catch (const std::exception&) {
+    processingError = std::make_error_code(std::errc::operation_canceled);
   }
 
-  std::error_code processingError;
-  for (auto& f : processingThreads) {
-    try {
-      std::error_code ec = f.get();
-      if (!processingError && ec) {
-        processingError = ec;
-      }
-    } catch (const std::system_error& e) {
-      processingError = e.code();
-    } catch (const std::exception&) {
-      processingError = std::make_error_code(std::errc::operation_canceled);
+  for (const auto& ec : batchErrors) {
+    if (!processingError && ec) {
+      processingError = ec;
     }
   }
 
@@ -311,11 +313,6 @@ uint32_t TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t st
   std::vector<Crypto::Hash> blockHashes = getBlockHashes(blocks, count);
   m_observerManager.notify(&IBlockchainConsumerObserver::onBlocksAdded, this, blockHashes);
 
-  // sort by block height and transaction index in block
-  std::sort(preprocessedTransactions.begin(), preprocessedTransactions.end(), [](const PreprocessedTx& a, const PreprocessedTx& b) {
-    return std::tie(a.blockInfo.height, a.blockInfo.transactionIndex) < std::tie(b.blockInfo.height, b.blockInfo.transactionIndex);
-  });
-
   uint32_t processedBlockCount = static_cast<uint32_t>(emptyBlockCount);
   try {
     for (const auto& tx : preprocessedTransactions) {
@@ -469,10 +466,15 @@ std::error_code createTransfers(
   return std::error_code();
 }
 
-std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info) {
+std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+  const std::vector<uint32_t>* knownGlobalIdxs, PreprocessInfo& info) {
   std::unordered_map<PublicKey, std::vector<uint32_t>> outputs;
   findMyOutputs(tx, m_viewSecret, m_spendKeys, outputs);
+  return preprocessOutputs(blockInfo, tx, outputs, knownGlobalIdxs, info);
+}
 
+std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+  const std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs, const std::vector<uint32_t>* knownGlobalIdxs, PreprocessInfo& info) {
   if (outputs.empty()) {
     return std::error_code();
   }
@@ -480,9 +482,14 @@ std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo&
   std::error_code errorCode;
   auto txHash = tx.getTransactionHash();
   if (blockInfo.height != WALLET_UNCONFIRMED_TRANSACTION_HEIGHT) {
-    errorCode = getGlobalIndices(reinterpret_cast<const Hash&>(txHash), info.globalIdxs);
-    if (errorCode) {
-      return errorCode;
+    // Indexes delivered along with the block spare a request to the node, older nodes don't send them
+    if (knownGlobalIdxs != nullptr && knownGlobalIdxs->size() == tx.getOutputCount()) {
+      info.globalIdxs = *knownGlobalIdxs;
+    } else {
+      errorCode = getGlobalIndices(reinterpret_cast<const Hash&>(txHash), info.globalIdxs);
+      if (errorCode) {
+        return errorCode;
+      }
     }
   }
 
@@ -502,7 +509,7 @@ std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo&
 
 std::error_code TransfersConsumer::processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx) {
   PreprocessInfo info;
-  auto ec = preprocessOutputs(blockInfo, tx, info);
+  auto ec = preprocessOutputs(blockInfo, tx, nullptr, info);
   if (ec) {
     return ec;
   }
@@ -70,7 +70,10 @@ private:
     std::vector<uint32_t> globalIdxs;
   };
 
-  std::error_code preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info);
+  std::error_code preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, const std::vector<uint32_t>* knownGlobalIdxs,
+    PreprocessInfo& info);
+  std::error_code preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+    const std::unordered_map<Crypto::PublicKey, std::vector<uint32_t>>& outputs, const std::vector<uint32_t>* knownGlobalIdxs, PreprocessInfo& info);
   std::error_code processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx);
   void processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, const PreprocessInfo& info);
   void processOutputs(const TransactionBlockInfo& blockInfo, TransfersSubscription& sub, const ITransactionReader& tx,
@@ -1603,6 +1603,38 @@ void ge_tobytes(unsigned char *s, const ge_p2 *h) {
   s[31] ^= fe_isnegative(x) << 7;
 }
 
+/* Same as ge_tobytes on each of the count points, with one field inversion shared by all of them (Montgomery's
+   trick). scratch must hold count field elements. */
+
+void ge_tobytes_batch(unsigned char *s, const ge_p2 *h, fe *scratch, size_t count) {
+  fe recip;
+  fe zinv;
+  fe x;
+  fe y;
+  size_t i;
+
+  if (count == 0) {
+    return;
+  }
+  fe_copy(scratch[0], h[0].Z);
+  for (i = 1; i < count; i++) {
+    fe_mul(scratch[i], scratch[i - 1], h[i].Z);
+  }
+  fe_invert(recip, scratch[count - 1]);
+  for (i = count - 1; i > 0; i--) {
+    fe_mul(zinv, recip, scratch[i - 1]);
+    fe_mul(recip, recip, h[i].Z);
+    fe_mul(x, h[i].X, zinv);
+    fe_mul(y, h[i].Y, zinv);
+    fe_tobytes(s + 32 * i, y);
+    s[32 * i + 31] ^= fe_isnegative(x) << 7;
+  }
+  fe_mul(x, h[0].X, recip);
+  fe_mul(y, h[0].Y, recip);
+  fe_tobytes(s, y);
+  s[31] ^= fe_isnegative(x) << 7;
+}
+
 /* From sc_reduce.c */
 
 /*
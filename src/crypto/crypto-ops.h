@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 /* From fe.h */
 
 typedef int32_t fe[10];
@@ -103,6 +105,7 @@ void sc_reduce(unsigned char *);
 void ge_scalarmult(ge_p2 *, const unsigned char *, const ge_p3 *);
 void ge_double_scalarmult_precomp_vartime(ge_p2 *, const unsigned char *, const ge_p3 *, const unsigned char *, const ge_dsmp);
 int ge_check_subgroup_precomp_vartime(const ge_dsmp);
+void ge_tobytes_batch(unsigned char *, const ge_p2 *, fe *, size_t);
 void ge_mul8(ge_p1p1 *, const ge_p2 *);
 extern const fe fe_ma2;
 extern const fe fe_ma;
@@ -27,6 +27,7 @@
 #include <cstring>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "Common/Varint.h"
 #include "crypto.h"
@@ -472,5 +473,79 @@ namespace Crypto {
     sc_sub(reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&sum));
     return sc_isnonzero(reinterpret_cast<unsigned char*>(&h)) == 0;
   }
+
+  void crypto_ops::check_ring_signatures(const RingSignatureToCheck *checks, size_t count, bool checkKeyImage, bool *results) {
+    size_t total_pubs = 0;
+    for (size_t j = 0; j < count; j++) {
+      total_pubs += checks[j].pubs_count;
+    }
+
+    // The ring points are computed for every signature first, so that they are all converted to bytes together. A
+    // single multi-scalar multiplication can't replace them, each point is hashed into the challenge.
+    std::vector<ge_p2> points(2 * total_pubs);
+    std::vector<EllipticCurveScalar> sums(count);
+    std::vector<size_t> offsets(count);
+    size_t used = 0;
+    for (size_t j = 0; j < count; j++) {
+      const RingSignatureToCheck &check = checks[j];
+      ge_p3 image_unp;
+      ge_dsmp image_pre;
+      size_t i;
+      results[j] = false;
+      offsets[j] = used;
+#if !defined(NDEBUG)
+      for (i = 0; i < check.pubs_count; i++) {
+        assert(check_key(*check.pubs[i]));
+      }
+#endif
+      if (ge_frombytes_vartime(&image_unp, reinterpret_cast<const unsigned char*>(check.image)) != 0) {
+        continue;
+      }
+      ge_dsm_precomp(image_pre, &image_unp);
+      if (checkKeyImage && ge_check_subgroup_precomp_vartime(image_pre) != 0) {
+        continue;
+      }
+      sc_0(reinterpret_cast<unsigned char*>(&sums[j]));
+      for (i = 0; i < check.pubs_count; i++) {
+        const unsigned char *sig = reinterpret_cast<const unsigned char*>(&check.sig[i]);
+        ge_p3 tmp3;
+        if (sc_check(sig) != 0 || sc_check(sig + 32) != 0) {
+          break;
+        }
+        if (ge_frombytes_vartime(&tmp3, reinterpret_cast<const unsigned char*>(&*check.pubs[i])) != 0) {
+          abort();
+        }
+        ge_double_scalarmult_base_vartime(&points[used + 2 * i], sig, &tmp3, sig + 32);
+        hash_to_ec(*check.pubs[i], tmp3);
+        ge_double_scalarmult_precomp_vartime(&points[used + 2 * i + 1], sig + 32, &tmp3, sig, image_pre);
+        sc_add(reinterpret_cast<unsigned char*>(&sums[j]), reinterpret_cast<unsigned char*>(&sums[j]), sig);
+      }
+      if (i != check.pubs_count) {
+        continue;
+      }
+      results[j] = true;
+      used += 2 * check.pubs_count;
+    }
+
+    std::vector<EllipticCurvePoint> point_bytes(used);
+    std::unique_ptr<fe[]> scratch(new fe[used + 1]);
+    ge_tobytes_batch(reinterpret_cast<unsigned char*>(point_bytes.data()), points.data(), scratch.get(), used);
+
+    std::vector<uint8_t> comm;
+    for (size_t j = 0; j < count; j++) {
+      const RingSignatureToCheck &check = checks[j];
+      EllipticCurveScalar h;
+      if (!results[j]) {
+        continue;
+      }
+      comm.resize(rs_comm_size(check.pubs_count));
+      rs_comm *const buf = reinterpret_cast<rs_comm *>(comm.data());
+      buf->h = *check.prefix_hash;
+      memcpy(buf->ab, point_bytes.data() + offsets[j], check.pubs_count * sizeof(ec_point_pair));
+      hash_to_scalar(buf, rs_comm_size(check.pubs_count), h);
+      sc_sub(reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&sums[j]));
+      results[j] = sc_isnonzero(reinterpret_cast<unsigned char*>(&h)) == 0;
+    }
+  }
 }
 
@@ -45,6 +45,16 @@ struct EllipticCurveScalar {
   uint8_t data[32];
 };
 
+  /* Arguments of one check_ring_signature call in a check_ring_signatures batch
+   */
+  struct RingSignatureToCheck {
+    const Hash *prefix_hash;
+    const KeyImage *image;
+    const PublicKey *const *pubs;
+    size_t pubs_count;
+    const Signature *sig;
+  };
+
   class crypto_ops {
     crypto_ops();
     crypto_ops(const crypto_ops &);
@@ -97,6 +107,8 @@ struct EllipticCurveScalar {
       const PublicKey *const *, size_t, const Signature *, bool);
     friend bool check_ring_signature(const Hash &, const KeyImage &,
       const PublicKey *const *, size_t, const Signature *, bool);
+    static void check_ring_signatures(const RingSignatureToCheck *, size_t, bool, bool *);
+    friend void check_ring_signatures(const RingSignatureToCheck *, size_t, bool, bool *);
   };
 
   /* Generate a value filled with random bytes.
@@ -250,6 +262,13 @@ struct EllipticCurveScalar {
     return crypto_ops::check_ring_signature(prefix_hash, image, pubs, pubs_count, sig, checkKeyImage);
   }
 
+  /* Same as check_ring_signature for each signature of the batch, the ring points of all of them are converted to
+   * bytes with a single field inversion.
+   */
+  inline void check_ring_signatures(const RingSignatureToCheck *checks, size_t count, bool checkKeyImage, bool *results) {
+    crypto_ops::check_ring_signatures(checks, count, checkKeyImage, results);
+  }
+
   /* Variants with vector<const PublicKey *> parameters.
    */
   inline void generate_ring_signature(const Hash &prefix_hash, const KeyImage &image,
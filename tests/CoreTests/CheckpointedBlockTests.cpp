@@ -0,0 +1,187 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include <Common/StringTools.h>
+#include <crypto/crypto.h>
+#include <crypto/random.h>
+
+#include "CryptoNoteCore/AddBlockErrorCondition.h"
+#include "CryptoNoteCore/AddBlockErrors.h"
+#include "CryptoNoteCore/BlockValidationErrors.h"
+#include "CryptoNoteCore/CachedBlock.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/TransactionValidationErrors.h"
+
+#include "CoreTestFixture.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint64_t MAX_AMOUNT = std::numeric_limits<uint64_t>::max();
+
+KeyInput makeInput(uint64_t amount, const Crypto::KeyImage& keyImage = Crypto::rand<Crypto::KeyImage>()) {
+  KeyInput input;
+  input.amount = amount;
+  input.outputIndexes = {0};
+  input.keyImage = keyImage;
+  return input;
+}
+
+Transaction makeTransaction(const std::vector<TransactionInput>& inputs, const std::vector<uint64_t>& outputAmounts) {
+  Transaction transaction;
+  transaction.version = CURRENT_TRANSACTION_VERSION;
+  transaction.unlockTime = 0;
+  transaction.inputs = inputs;
+  for (auto amount : outputAmounts) {
+    Crypto::SecretKey secretKey;
+    KeyOutput target;
+    Crypto::generate_keys(target.key, secretKey);
+    transaction.outputs.push_back(TransactionOutput{amount, target});
+  }
+
+  for (const auto& input : inputs) {
+    size_t signatureCount = input.type() == typeid(KeyInput) ? boost::get<KeyInput>(input).outputIndexes.size() : 0;
+    transaction.signatures.emplace_back(signatureCount);
+  }
+
+  return transaction;
+}
+
+// Checkpointed blocks get a reduced transaction check, every block here is at the first index above the genesis block
+class CheckpointedBlockTest : public CoreTestFixture {
+protected:
+  // The block template is taken from a core without checkpoints, the core is then recreated with the checkpoint
+  BlockTemplate makeBlock(const std::vector<Transaction>& transactions) {
+    AccountPublicAddress address;
+    Crypto::SecretKey secretKey;
+    Crypto::generate_keys(address.spendPublicKey, secretKey);
+    Crypto::generate_keys(address.viewPublicKey, secretKey);
+
+    BlockTemplate block;
+    Difficulty difficulty;
+    uint32_t height;
+    EXPECT_TRUE(core->getBlockTemplate(block, address, BinaryArray(), difficulty, height));
+    for (const auto& transaction : transactions) {
+      block.transactionHashes.push_back(getObjectHash(transaction));
+    }
+
+    return block;
+  }
+
+  RawBlock makeRawBlock(const BlockTemplate& block, const std::vector<Transaction>& transactions) {
+    RawBlock rawBlock;
+    rawBlock.block = toBinaryArray(block);
+    for (const auto& transaction : transactions) {
+      rawBlock.transactions.push_back(toBinaryArray(transaction));
+    }
+
+    return rawBlock;
+  }
+
+  void checkpoint(uint32_t index, const Crypto::Hash& hash) {
+    Checkpoints checkpoints(logger);
+    ASSERT_TRUE(checkpoints.addCheckpoint(index, Common::podToHex(hash)));
+    createCore(std::move(checkpoints));
+  }
+
+  std::error_code addCheckpointedBlock(const std::vector<Transaction>& transactions) {
+    BlockTemplate block = makeBlock(transactions);
+    checkpoint(1, CachedBlock(block).getBlockHash());
+    return core->addBlock(makeRawBlock(block, transactions));
+  }
+};
+
+}
+
+TEST_F(CheckpointedBlockTest, acceptsMatchingBlock) {
+  auto result = addCheckpointedBlock({makeTransaction({makeInput(100)}, {60, 40})});
+  EXPECT_EQ(make_error_code(error::AddBlockErrorCode::ADDED_TO_MAIN), result);
+  EXPECT_EQ(1, core->getTopBlockIndex());
+}
+
+TEST_F(CheckpointedBlockTest, rejectsBlockNotMatchingCheckpoint) {
+  std::vector<Transaction> transactions = {makeTransaction({makeInput(100)}, {100})};
+  BlockTemplate block = makeBlock(transactions);
+  checkpoint(1, Crypto::rand<Crypto::Hash>());
+
+  auto result = core->addBlock(makeRawBlock(block, transactions));
+  EXPECT_EQ(make_error_code(error::BlockValidationError::CHECKPOINT_BLOCK_HASH_MISMATCH), result);
+}
+
+TEST_F(CheckpointedBlockTest, rejectsTransactionNotListedInBlock) {
+  std::vector<Transaction> listed = {makeTransaction({makeInput(100)}, {100})};
+  std::vector<Transaction> sent = {makeTransaction({makeInput(100)}, {100})};
+  BlockTemplate block = makeBlock(listed);
+  checkpoint(1, CachedBlock(block).getBlockHash());
+
+  auto result = core->addBlock(makeRawBlock(block, sent));
+  EXPECT_EQ(make_error_code(error::BlockValidationError::TRANSACTION_HASH_MISMATCH), result);
+}
+
+TEST_F(CheckpointedBlockTest, rejectsInputOfUnknownType) {
+  BaseInput input;
+  input.blockIndex = 1;
+  auto result = addCheckpointedBlock({makeTransaction({input}, {100})});
+  EXPECT_EQ(make_error_code(error::TransactionValidationError::INPUT_UNKNOWN_TYPE), result);
+}
+
+TEST_F(CheckpointedBlockTest, rejectsKeyImageSpentTwice) {
+  auto keyImage = Crypto::rand<Crypto::KeyImage>();
+  auto result = addCheckpointedBlock({
+    makeTransaction({makeInput(100, keyImage)}, {100}),
+    makeTransaction({makeInput(200, keyImage)}, {200})});
+  EXPECT_EQ(make_error_code(error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT), result);
+}
+
+TEST_F(CheckpointedBlockTest, rejectsInputsAmountOverflow) {
+  auto result = addCheckpointedBlock({makeTransaction({makeInput(MAX_AMOUNT), makeInput(2)}, {1})});
+  EXPECT_EQ(make_error_code(error::TransactionValidationError::INPUTS_AMOUNT_OVERFLOW), result);
+}
+
+TEST_F(CheckpointedBlockTest, rejectsOutputsAmountOverflow) {
+  auto result = addCheckpointedBlock({makeTransaction({makeInput(MAX_AMOUNT)}, {MAX_AMOUNT, 2})});
+  EXPECT_EQ(make_error_code(error::TransactionValidationError::OUTPUTS_AMOUNT_OVERFLOW), result);
+}
+
+TEST_F(CheckpointedBlockTest, rejectsOutputsExceedingInputs) {
+  auto result = addCheckpointedBlock({makeTransaction({makeInput(100)}, {101})});
+  EXPECT_EQ(make_error_code(error::TransactionValidationError::WRONG_AMOUNT), result);
+}
+
+TEST_F(CheckpointedBlockTest, rejectsCumulativeFeeOverflow) {
+  auto result = addCheckpointedBlock({
+    makeTransaction({makeInput(MAX_AMOUNT / 2 + 2)}, {1}),
+    makeTransaction({makeInput(MAX_AMOUNT / 2 + 2)}, {1})});
+  EXPECT_EQ(make_error_code(error::BlockValidationError::CUMULATIVE_FEE_OVERFLOW), result);
+}
+
+// A zero amount output is only caught by the full check, which a block between checkpoints gets
+TEST_F(CheckpointedBlockTest, fullyValidatesBlockBetweenCheckpoints) {
+  std::vector<Transaction> transactions = {makeTransaction({makeInput(100)}, {100, 0})};
+  BlockTemplate block = makeBlock(transactions);
+  checkpoint(2, Crypto::rand<Crypto::Hash>());
+  ASSERT_TRUE(core->isInCheckpointZone(1));
+
+  auto result = core->addBlock(makeRawBlock(block, transactions));
+  EXPECT_EQ(make_error_code(error::TransactionValidationError::OUTPUT_ZERO_AMOUNT), result);
+  EXPECT_EQ(0, core->getTopBlockIndex());
+}
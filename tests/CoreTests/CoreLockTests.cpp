@@ -0,0 +1,112 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Timer.h>
+
+#include "CoreTestFixture.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::chrono::milliseconds READER_HOLD_TIME(1000);
+const std::chrono::milliseconds TICK(10);
+
+class CoreLockTest : public CoreTestFixture {
+};
+
+}
+
+// A reader on another thread holds the core for a while, the dispatcher keeps running other contexts while a writer waits
+TEST_F(CoreLockTest, writerDoesNotBlockDispatcherWhileReaderHoldsLock) {
+  std::promise<void> locked;
+  std::thread reader([&] {
+    auto lock = core->lockForReading();
+    locked.set_value();
+    std::this_thread::sleep_for(READER_HOLD_TIME);
+  });
+
+  locked.get_future().wait();
+
+  System::ContextGroup contextGroup(dispatcher);
+  bool saved = false;
+  size_t ticks = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::duration saveTime;
+
+  contextGroup.spawn([&] {
+    core->save();
+    saveTime = std::chrono::steady_clock::now() - start;
+    saved = true;
+  });
+
+  contextGroup.spawn([&] {
+    System::Timer timer(dispatcher);
+    while (!saved) {
+      timer.sleep(TICK);
+      ++ticks;
+    }
+  });
+
+  contextGroup.wait();
+  reader.join();
+
+  EXPECT_GE(saveTime, READER_HOLD_TIME / 2);
+  // Most of the wait was spent running the other context
+  EXPECT_GE(ticks, static_cast<size_t>(READER_HOLD_TIME / TICK / 4));
+}
+
+// Writers queued behind a reader get the core in the order they asked for it, and readers get it again after them
+TEST_F(CoreLockTest, writersWaitingForReaderKeepOrder) {
+  std::promise<void> locked;
+  std::thread reader([&] {
+    auto lock = core->lockForReading();
+    locked.set_value();
+    std::this_thread::sleep_for(READER_HOLD_TIME / 4);
+  });
+
+  locked.get_future().wait();
+
+  System::ContextGroup contextGroup(dispatcher);
+  std::vector<size_t> order;
+  for (size_t i = 0; i < 3; ++i) {
+    contextGroup.spawn([&, i] {
+      core->save();
+      order.push_back(i);
+    });
+  }
+
+  contextGroup.wait();
+  reader.join();
+
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2}), order);
+
+  std::thread nextReader([&] {
+    auto lock = core->lockForReading();
+  });
+
+  nextReader.join();
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include <System/Dispatcher.h>
+
+#include "CryptoNoteCore/Checkpoints.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/DataBaseConfig.h"
+#include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "Logging/ConsoleLogger.h"
+#include "../Common/VectorMainChainStorage.h"
+
+// Core with only the genesis block, backed by a database in a temporary directory
+class CoreTestFixture : public ::testing::Test {
+public:
+  CoreTestFixture() :
+    logger(Logging::ERROR),
+    currency(CryptoNote::CurrencyBuilder(logger).currency()),
+    database(logger),
+    dataDir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    boost::filesystem::create_directories(dataDir);
+
+    CryptoNote::DataBaseConfig dbConfig;
+    dbConfig.setDataDir(dataDir.string());
+    dbConfig.setConfigFolderDefaulted(false);
+    database.init(dbConfig);
+  }
+
+  ~CoreTestFixture() {
+    core.reset();
+    database.shutdown();
+
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(dataDir, ignore);
+  }
+
+  virtual void SetUp() override {
+    createCore(CryptoNote::Checkpoints(logger));
+  }
+
+protected:
+  void createCore(CryptoNote::Checkpoints&& checkpoints) {
+    core.reset();
+    core.reset(new CryptoNote::Core(currency, logger, std::move(checkpoints), dispatcher,
+      std::unique_ptr<CryptoNote::IBlockchainCacheFactory>(new CryptoNote::DatabaseBlockchainCacheFactory(database, logger)),
+      CryptoNote::createVectorMainChainStorage(currency)));
+    core->load();
+  }
+
+  Logging::ConsoleLogger logger;
+  CryptoNote::Currency currency;
+  CryptoNote::RocksDBWrapper database;
+  boost::filesystem::path dataDir;
+  System::Dispatcher dispatcher;
+  std::unique_ptr<CryptoNote::Core> core;
+};
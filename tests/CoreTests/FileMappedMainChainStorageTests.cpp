@@ -0,0 +1,136 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/FileMappedMainChainStorage.h"
+#include "CryptoNoteCore/MainChainStorage.h"
+#include "Logging/ConsoleLogger.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+RawBlock makeBlock(uint8_t fill, size_t transactionCount) {
+  RawBlock block;
+  block.block.assign(100, fill);
+  for (size_t i = 0; i < transactionCount; ++i) {
+    block.transactions.emplace_back(50 + i, static_cast<uint8_t>(fill + i + 1));
+  }
+
+  return block;
+}
+
+void expectBlock(const RawBlock& expected, const RawBlock& actual) {
+  EXPECT_EQ(expected.block, actual.block);
+  EXPECT_EQ(expected.transactions, actual.transactions);
+}
+
+class FileMappedMainChainStorageTest : public ::testing::Test {
+public:
+  FileMappedMainChainStorageTest() :
+    logger(Logging::ERROR),
+    currency(CurrencyBuilder(logger).currency()),
+    dataDir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()),
+    blocksFilename(dataDir / currency.blocksFileName()),
+    indexesFilename(dataDir / currency.blockIndexesFileName()) {
+    boost::filesystem::create_directories(dataDir);
+  }
+
+  ~FileMappedMainChainStorageTest() {
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(dataDir, ignore);
+  }
+
+protected:
+  Logging::ConsoleLogger logger;
+  Currency currency;
+  boost::filesystem::path dataDir;
+  boost::filesystem::path blocksFilename;
+  boost::filesystem::path indexesFilename;
+};
+
+}
+
+TEST_F(FileMappedMainChainStorageTest, viewSurvivesPopAndPush) {
+  auto storage = createFileMappedMainChainStorage(dataDir.string(), currency);
+  RawBlock popped = makeBlock(1, 2);
+  storage->pushBlock(popped);
+
+  RawBlockView view = storage->getBlockViewByIndex(1);
+  storage->popBlock();
+  storage->pushBlock(makeBlock(7, 3));
+
+  expectBlock(popped, view.toRawBlock());
+  expectBlock(makeBlock(7, 3), storage->getBlockByIndex(1));
+}
+
+TEST_F(FileMappedMainChainStorageTest, reopenKeepsBlocks) {
+  {
+    auto storage = createFileMappedMainChainStorage(dataDir.string(), currency);
+    storage->pushBlock(makeBlock(1, 1));
+    storage->pushBlock(makeBlock(2, 0));
+    storage->popBlock();
+  }
+
+  auto storage = createFileMappedMainChainStorage(dataDir.string(), currency);
+  ASSERT_EQ(2, storage->getBlockCount());
+  expectBlock(makeBlock(1, 1), storage->getBlockByIndex(1));
+
+  storage->pushBlock(makeBlock(3, 2));
+  expectBlock(makeBlock(3, 2), storage->getBlockByIndex(2));
+}
+
+TEST_F(FileMappedMainChainStorageTest, importRemovesSwappedStorageFiles) {
+  {
+    auto swappedStorage = createSwappedMainChainStorage(dataDir.string(), currency);
+    swappedStorage->pushBlock(makeBlock(1, 1));
+    swappedStorage->pushBlock(makeBlock(2, 2));
+  }
+
+  RawBlock genesis;
+  genesis.block = toBinaryArray(currency.genesisBlock());
+  auto storage = createFileMappedMainChainStorage(dataDir.string(), currency);
+
+  EXPECT_FALSE(boost::filesystem::exists(blocksFilename));
+  EXPECT_FALSE(boost::filesystem::exists(indexesFilename));
+  ASSERT_EQ(3, storage->getBlockCount());
+  expectBlock(genesis, storage->getBlockByIndex(0));
+  expectBlock(makeBlock(2, 2), storage->getBlockByIndex(2));
+}
+
+// Old files left next to a mapped storage mean the import was interrupted, it is redone from the start
+TEST_F(FileMappedMainChainStorageTest, interruptedImportIsRedone) {
+  {
+    auto storage = createFileMappedMainChainStorage(dataDir.string(), currency);
+    storage->pushBlock(makeBlock(9, 1));
+  }
+
+  {
+    MainChainStorage swappedStorage(blocksFilename.string(), indexesFilename.string());
+    swappedStorage.pushBlock(makeBlock(0, 0));
+    swappedStorage.pushBlock(makeBlock(1, 1));
+  }
+
+  auto storage = createFileMappedMainChainStorage(dataDir.string(), currency);
+  ASSERT_EQ(2, storage->getBlockCount());
+  expectBlock(makeBlock(0, 0), storage->getBlockByIndex(0));
+  expectBlock(makeBlock(1, 1), storage->getBlockByIndex(1));
+}
@@ -0,0 +1,240 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include <Common/StringTools.h>
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/InterruptedException.h>
+#include <System/Ipv4Address.h>
+#include <System/TcpConnection.h>
+#include <System/TcpConnector.h>
+#include <System/Timer.h>
+
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/Checkpoints.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/DataBaseConfig.h"
+#include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
+#include "Logging/ConsoleLogger.h"
+#include "P2p/LevinProtocol.h"
+#include "P2p/NetNode.h"
+#include "P2p/P2pNetworks.h"
+#include "P2p/P2pProtocolDefinitions.h"
+#include "../Common/VectorMainChainStorage.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint16_t NODE_PORT = 6670;
+const uint16_t CLOSED_PORT = 6671;
+
+// Core, protocol handler and node server on their own dispatcher thread, as the daemon runs them
+class TestNode {
+public:
+  explicit TestNode(const std::string& dataDir) : m_logger(Logging::ERROR), m_dataDir(dataDir) {
+    std::promise<std::string> initPromise;
+    std::future<std::string> initFuture = initPromise.get_future();
+    m_thread = std::thread([this, &initPromise] { run(initPromise); });
+
+    std::string initError = initFuture.get();
+    if (!initError.empty()) {
+      m_thread.join();
+      throw std::runtime_error(initError);
+    }
+  }
+
+  ~TestNode() {
+    m_node->sendStopSignal();
+    m_thread.join();
+  }
+
+private:
+  void run(std::promise<std::string>& initPromise) {
+    System::Dispatcher dispatcher;
+    Currency currency = CurrencyBuilder(m_logger).currency();
+    RocksDBWrapper database(m_logger);
+    std::unique_ptr<Core> core;
+    std::unique_ptr<CryptoNoteProtocolHandler> protocol;
+
+    try {
+      DataBaseConfig dbConfig;
+      dbConfig.setDataDir(m_dataDir);
+      dbConfig.setConfigFolderDefaulted(false);
+      database.init(dbConfig);
+
+      core.reset(new Core(currency, m_logger, Checkpoints(m_logger), dispatcher,
+        std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, m_logger)),
+        createVectorMainChainStorage(currency)));
+      core->load();
+
+      protocol.reset(new CryptoNoteProtocolHandler(currency, dispatcher, *core, nullptr, m_logger));
+      m_node.reset(new NodeServer(dispatcher, *protocol, m_logger));
+      protocol->set_p2p_endpoint(m_node.get());
+
+      // The only peer to connect to is closed, so the node waits for incoming connections
+      NetworkAddress closedPeer;
+      Common::parseIpAddressAndPort(closedPeer.ip, closedPeer.port, "127.0.0.1:" + std::to_string(CLOSED_PORT));
+
+      NetNodeConfig config;
+      config.setBindIp("127.0.0.1");
+      config.setBindPort(NODE_PORT);
+      config.setExternalPort(0);
+      config.setAllowLocalIp(true);
+      config.setHideMyPort(true);
+      config.setConfigFolder(m_dataDir);
+      config.setP2pStateFilename(parameters::P2P_NET_DATA_FILENAME);
+      config.setExclusiveNodes({closedPeer});
+      if (!m_node->init(config)) {
+        throw std::runtime_error("Failed to init the node server");
+      }
+    } catch (std::exception& e) {
+      initPromise.set_value(e.what());
+      return;
+    }
+
+    initPromise.set_value(std::string());
+    m_node->run();
+    m_node->deinit();
+    protocol->set_p2p_endpoint(nullptr);
+    m_node.reset();
+    protocol.reset();
+    core.reset();
+    database.shutdown();
+  }
+
+  Logging::ConsoleLogger m_logger;
+  std::string m_dataDir;
+  std::unique_ptr<NodeServer> m_node;
+  std::thread m_thread;
+};
+
+class BlockRequestTimeoutTest : public ::testing::Test {
+public:
+  BlockRequestTimeoutTest() : m_dataDir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    boost::filesystem::create_directories(m_dataDir);
+  }
+
+  ~BlockRequestTimeoutTest() {
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(m_dataDir, ignore);
+  }
+
+protected:
+  boost::filesystem::path m_dataDir;
+};
+
+// Reads until a command with the given id arrives, false if the connection closes before
+bool readUntil(LevinProtocol& protocol, uint32_t command, LevinProtocol::Command& cmd) {
+  while (protocol.readCommand(cmd)) {
+    if (cmd.command == command) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}
+
+// The peer claims a longer chain, answers the chain request and never sends the blocks requested then
+TEST_F(BlockRequestTimeoutTest, silentPeerIsDisconnected) {
+  TestNode node(m_dataDir.string());
+
+  System::Dispatcher dispatcher;
+  System::ContextGroup contextGroup(dispatcher);
+  bool blocksRequested = false;
+  bool closed = false;
+  std::chrono::steady_clock::duration silence;
+
+  auto peer = [&] {
+    System::TcpConnection connection = System::TcpConnector(dispatcher).connect(System::Ipv4Address("127.0.0.1"), NODE_PORT);
+    LevinProtocol protocol(connection);
+
+    COMMAND_HANDSHAKE::request handshake;
+    handshake.node_data.network_id = BYTECOIN_NETWORK;
+    handshake.node_data.version = P2PProtocolVersion::CURRENT;
+    handshake.node_data.local_time = time(nullptr);
+    handshake.node_data.my_port = 0;
+    handshake.node_data.peer_id = 1;
+    handshake.payload_data.current_height = 10;
+    handshake.payload_data.top_id = Crypto::rand<Crypto::Hash>();
+
+    COMMAND_HANDSHAKE::response handshakeResponse;
+    ASSERT_TRUE(protocol.invoke(COMMAND_HANDSHAKE::ID, handshake, handshakeResponse));
+
+    LevinProtocol::Command cmd;
+    ASSERT_TRUE(readUntil(protocol, NOTIFY_REQUEST_CHAIN::ID, cmd));
+
+    NOTIFY_RESPONSE_CHAIN_ENTRY::request chain;
+    chain.start_height = 0;
+    chain.total_height = 10;
+    chain.m_block_ids = {handshakeResponse.payload_data.top_id, Crypto::rand<Crypto::Hash>(), Crypto::rand<Crypto::Hash>()};
+    protocol.notify(NOTIFY_RESPONSE_CHAIN_ENTRY::ID, chain, 0);
+
+    ASSERT_TRUE(readUntil(protocol, NOTIFY_REQUEST_GET_OBJECTS::ID, cmd));
+    blocksRequested = true;
+    auto requestTime = std::chrono::steady_clock::now();
+
+    try {
+      while (protocol.readCommand(cmd)) {
+      }
+    } catch (System::InterruptedException&) {
+      throw;
+    } catch (std::exception&) {
+      // Reset instead of an orderly close
+    }
+
+    closed = true;
+    silence = std::chrono::steady_clock::now() - requestTime;
+  };
+
+  // Whichever finishes first, the peer or the timeout, stops the other
+  contextGroup.spawn([&] {
+    try {
+      peer();
+      contextGroup.interrupt();
+    } catch (System::InterruptedException&) {
+    }
+  });
+
+  contextGroup.spawn([&] {
+    try {
+      System::Timer(dispatcher).sleep(std::chrono::milliseconds(BLOCKS_SYNCHRONIZING_REQUEST_TIMEOUT) + std::chrono::seconds(30));
+      contextGroup.interrupt();
+    } catch (System::InterruptedException&) {
+    }
+  });
+
+  contextGroup.wait();
+
+  ASSERT_TRUE(blocksRequested);
+  ASSERT_TRUE(closed);
+  EXPECT_GE(silence, std::chrono::milliseconds(BLOCKS_SYNCHRONIZING_REQUEST_TIMEOUT));
+}
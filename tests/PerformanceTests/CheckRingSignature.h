@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
 #include "CryptoNoteCore/Account.h"
@@ -28,7 +29,7 @@
 #include "MultiTransactionTestBase.h"
 
 template<size_t a_ring_size>
-class test_check_ring_signature : private multi_tx_test_base<a_ring_size>
+class test_check_ring_signature : protected multi_tx_test_base<a_ring_size>
 {
   static_assert(0 < a_ring_size, "ring_size must be greater than 0");
 
@@ -64,8 +65,44 @@ public:
     return Crypto::check_ring_signature(m_tx_prefix_hash, txin.keyImage, this->m_public_key_ptrs, ring_size, m_tx.signatures[0].data(), true);
   }
 
-private:
+protected:
   CryptoNote::AccountBase m_alice;
   CryptoNote::Transaction m_tx;
   Crypto::Hash m_tx_prefix_hash;
 };
+
+template<size_t a_ring_size, size_t a_signature_count>
+class test_check_ring_signatures : private test_check_ring_signature<a_ring_size>
+{
+  static_assert(0 < a_signature_count, "signature_count must be greater than 0");
+
+public:
+  static const size_t loop_count = a_ring_size * a_signature_count < 100 ? 100 : 10;
+  static const size_t ring_size = a_ring_size;
+  static const size_t signature_count = a_signature_count;
+
+  typedef test_check_ring_signature<a_ring_size> base_class;
+
+  bool init()
+  {
+    if (!base_class::init())
+      return false;
+
+    const CryptoNote::KeyInput& txin = boost::get<CryptoNote::KeyInput>(this->m_tx.inputs[0]);
+    for (size_t i = 0; i < signature_count; ++i) {
+      m_checks[i] = { &this->m_tx_prefix_hash, &txin.keyImage, this->m_public_key_ptrs, ring_size, this->m_tx.signatures[0].data() };
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    Crypto::check_ring_signatures(m_checks, signature_count, true, m_results);
+    return std::all_of(m_results, m_results + signature_count, [](bool valid) { return valid; });
+  }
+
+private:
+  Crypto::RingSignatureToCheck m_checks[signature_count];
+  bool m_results[signature_count];
+};
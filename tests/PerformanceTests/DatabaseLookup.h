@@ -0,0 +1,130 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/BlockchainReadBatch.h"
+#include "CryptoNoteCore/BlockchainWriteBatch.h"
+#include "CryptoNoteCore/DataBaseConfig.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "Logging/ConsoleLogger.h"
+#include "crypto/crypto.h"
+
+// Spent key image lookups, half of them missing, against a database filled with synthetic blocks. Prints the database
+// size on disk, so running it with and without column families compares both layouts.
+template<bool a_column_families>
+class test_database_lookup
+{
+public:
+  static const size_t loop_count = 1000;
+  static const size_t block_count = 2000;
+  static const size_t transactions_per_block = 10;
+  static const size_t lookups_per_call = 100;
+
+  test_database_lookup() : m_logger(Logging::ERROR), m_db(m_logger)
+  {
+  }
+
+  ~test_database_lookup()
+  {
+    m_db.shutdown();
+    boost::filesystem::remove_all(m_dataDir);
+  }
+
+  bool init()
+  {
+    m_dataDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(m_dataDir);
+    m_config.setDataDir(m_dataDir.string());
+    m_config.setUseColumnFamilies(a_column_families);
+
+    m_db.init(m_config);
+    for (uint32_t blockIndex = 0; blockIndex < block_count; ++blockIndex)
+    {
+      std::unordered_set<Crypto::KeyImage> keyImages;
+      CryptoNote::RawBlock rawBlock;
+      rawBlock.block = makeBinary(300);
+      for (size_t i = 0; i < transactions_per_block; ++i)
+      {
+        keyImages.insert(Crypto::rand<Crypto::KeyImage>());
+        rawBlock.transactions.push_back(makeBinary(600));
+      }
+
+      m_keyImages.insert(m_keyImages.end(), keyImages.begin(), keyImages.end());
+
+      CryptoNote::BlockchainWriteBatch batch;
+      batch.insertSpentKeyImages(blockIndex, keyImages).insertRawBlock(blockIndex, rawBlock);
+      if (m_db.write(batch))
+        return false;
+    }
+
+    // Reopen so lookups go to the table files rather than the memtables
+    m_db.shutdown();
+    m_db.init(m_config);
+
+    uint64_t size = 0;
+    for (boost::filesystem::recursive_directory_iterator it(m_dataDir), end; it != end; ++it)
+    {
+      if (boost::filesystem::is_regular_file(it->path()))
+        size += boost::filesystem::file_size(it->path());
+    }
+
+    std::cout << "  database size: " << size / 1024 << " KB" << std::endl;
+    return true;
+  }
+
+  bool test()
+  {
+    CryptoNote::BlockchainReadBatch batch;
+    for (size_t i = 0; i < lookups_per_call; ++i)
+    {
+      if (i % 2 == 0)
+        batch.requestBlockIndexBySpentKeyImage(m_keyImages[(m_next++) % m_keyImages.size()]);
+      else
+        batch.requestBlockIndexBySpentKeyImage(Crypto::rand<Crypto::KeyImage>());
+    }
+
+    return !m_db.read(batch);
+  }
+
+private:
+  // Keys and hashes make up most of a real transaction, the rest is amounts and small integers
+  static CryptoNote::BinaryArray makeBinary(size_t size)
+  {
+    CryptoNote::BinaryArray binary(size, 0);
+    for (size_t offset = 0; offset + 64 <= size; offset += 64)
+    {
+      Crypto::Hash hash = Crypto::rand<Crypto::Hash>();
+      std::copy(hash.data, hash.data + sizeof(hash.data), binary.begin() + offset);
+    }
+
+    return binary;
+  }
+
+  Logging::ConsoleLogger m_logger;
+  CryptoNote::RocksDBWrapper m_db;
+  CryptoNote::DataBaseConfig m_config;
+  boost::filesystem::path m_dataDir;
+  std::vector<Crypto::KeyImage> m_keyImages;
+  size_t m_next = 0;
+};
@@ -0,0 +1,121 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/MemoryInputStream.h"
+#include "Common/StringOutputStream.h"
+#include "Serialization/KVBinaryInputBufferSerializer.h"
+#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryOutputStreamSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+#include "crypto/crypto.h"
+
+// Decoding of a NOTIFY_RESPONSE_GET_OBJECTS message as sent during sync, 100 blocks with a mix of small and large
+// transactions. The structures have the wire layout of the protocol handler's, which are private to it.
+template<bool a_buffer_serializer>
+class test_kv_binary_deserialization
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t block_count = 100;
+
+  struct sync_block
+  {
+    std::string block;
+    std::vector<std::string> txs;
+
+    void serialize(CryptoNote::ISerializer& s)
+    {
+      KV_MEMBER(block)
+      KV_MEMBER(txs)
+    }
+  };
+
+  struct sync_response
+  {
+    std::vector<std::string> txs;
+    std::vector<sync_block> blocks;
+    std::vector<Crypto::Hash> missed_ids;
+    uint32_t current_blockchain_height;
+
+    void serialize(CryptoNote::ISerializer& s)
+    {
+      KV_MEMBER(txs)
+      KV_MEMBER(blocks)
+      serializeAsBinary(missed_ids, "missed_ids", s);
+      KV_MEMBER(current_blockchain_height)
+    }
+  };
+
+  bool init()
+  {
+    sync_response response;
+    response.current_blockchain_height = 1000000;
+    for (size_t i = 0; i < block_count; ++i)
+    {
+      sync_block block;
+      block.block = makeString(250);
+      for (size_t j = 0; j < 2 + i % 15; ++j)
+        block.txs.push_back(makeString(j % 5 == 0 ? 4000 : 450));
+
+      response.blocks.push_back(std::move(block));
+    }
+
+    CryptoNote::KVBinaryOutputStreamSerializer serializer;
+    response.serialize(serializer);
+    Common::StringOutputStream stream(m_payload);
+    serializer.dump(stream);
+    return true;
+  }
+
+  bool test()
+  {
+    sync_response response;
+    if (a_buffer_serializer)
+    {
+      CryptoNote::KVBinaryInputBufferSerializer serializer(m_payload.data(), m_payload.size());
+      response.serialize(serializer);
+    }
+    else
+    {
+      Common::MemoryInputStream stream(m_payload.data(), m_payload.size());
+      CryptoNote::KVBinaryInputStreamSerializer serializer(stream);
+      response.serialize(serializer);
+    }
+
+    return response.blocks.size() == block_count;
+  }
+
+private:
+  static std::string makeString(size_t size)
+  {
+    std::string result(size, '\0');
+    for (size_t offset = 0; offset + 32 <= size; offset += 32)
+    {
+      Crypto::Hash hash = Crypto::rand<Crypto::Hash>();
+      std::copy(hash.data, hash.data + sizeof(hash.data), result.begin() + offset);
+    }
+
+    return result;
+  }
+
+  std::string m_payload;
+};
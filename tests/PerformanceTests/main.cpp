@@ -22,12 +22,14 @@
 #include "ConstructTransaction.h"
 #include "CheckRingSignature.h"
 #include "CryptoNoteSlowHash.h"
+#include "DatabaseLookup.h"
 #include "DerivePublicKey.h"
 #include "DeriveSecretKey.h"
 #include "GenerateKeyDerivation.h"
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
 #include "IsOutToAccount.h"
+#include "KVBinaryDeserialization.h"
 
 int main(int argc, char** argv)
 {
@@ -63,6 +65,12 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE1(test_check_ring_signature, 10);
   TEST_PERFORMANCE1(test_check_ring_signature, 100);
 
+  TEST_PERFORMANCE2(test_check_ring_signatures, 1, 1);
+  TEST_PERFORMANCE2(test_check_ring_signatures, 2, 1);
+  TEST_PERFORMANCE2(test_check_ring_signatures, 10, 1);
+  TEST_PERFORMANCE2(test_check_ring_signatures, 100, 1);
+  TEST_PERFORMANCE2(test_check_ring_signatures, 10, 10);
+
   TEST_PERFORMANCE0(test_is_out_to_acc);
   TEST_PERFORMANCE0(test_generate_key_image_helper);
   TEST_PERFORMANCE0(test_generate_key_derivation);
@@ -72,6 +80,12 @@ int main(int argc, char** argv)
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
 
+  TEST_PERFORMANCE1(test_database_lookup, false);
+  TEST_PERFORMANCE1(test_database_lookup, true);
+
+  TEST_PERFORMANCE1(test_kv_binary_deserialization, false);
+  TEST_PERFORMANCE1(test_kv_binary_deserialization, true);
+
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
   return 0;
@@ -0,0 +1,204 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "crypto/crypto.h"
+
+extern "C" {
+#include "crypto/crypto-ops.h"
+}
+
+using namespace Crypto;
+
+namespace {
+
+struct RingSignature {
+  Hash prefixHash;
+  KeyImage image;
+  std::vector<PublicKey> pubs;
+  std::vector<const PublicKey*> pubPointers;
+  std::vector<Signature> sigs;
+
+  RingSignature(const RingSignature&) = delete;
+  RingSignature& operator=(const RingSignature&) = delete;
+
+  RingSignature(size_t ringSize, size_t realIndex) : pubs(ringSize), sigs(ringSize) {
+    SecretKey secretKey;
+    for (size_t i = 0; i < ringSize; ++i) {
+      SecretKey otherKey;
+      generate_keys(pubs[i], i == realIndex ? secretKey : otherKey);
+      pubPointers.push_back(&pubs[i]);
+    }
+
+    prefixHash = rand<Hash>();
+    generate_key_image(pubs[realIndex], secretKey, image);
+    generate_ring_signature(prefixHash, image, pubPointers.data(), ringSize, secretKey, realIndex, sigs.data());
+  }
+
+  RingSignatureToCheck toCheck() const {
+    return RingSignatureToCheck{&prefixHash, &image, pubPointers.data(), pubPointers.size(), sigs.data()};
+  }
+
+  bool check() const {
+    return check_ring_signature(prefixHash, image, pubPointers.data(), pubPointers.size(), sigs.data(), true);
+  }
+};
+
+// Each batch result must agree with the single signature check and with the expectation
+void checkBatch(const std::vector<std::unique_ptr<RingSignature>>& signatures, const std::vector<bool>& expected) {
+  std::vector<RingSignatureToCheck> checks;
+  for (const auto& signature : signatures) {
+    checks.push_back(signature->toCheck());
+  }
+
+  std::unique_ptr<bool[]> results(new bool[checks.size()]);
+  check_ring_signatures(checks.data(), checks.size(), true, results.get());
+  for (size_t i = 0; i < signatures.size(); ++i) {
+    EXPECT_EQ(expected[i], results[i]) << "signature " << i;
+    EXPECT_EQ(signatures[i]->check(), results[i]) << "signature " << i;
+  }
+}
+
+// Points with unrelated Z coordinates, as the ring member arithmetic leaves them
+std::vector<ge_p2> randomPoints(size_t count) {
+  std::vector<ge_p2> points(count);
+  for (auto& point : points) {
+    PublicKey publicKey;
+    SecretKey secretKey;
+    generate_keys(publicKey, secretKey);
+
+    ge_p3 base;
+    EXPECT_EQ(0, ge_frombytes_vartime(&base, reinterpret_cast<const unsigned char*>(&publicKey)));
+    EllipticCurveScalar a = rand<EllipticCurveScalar>();
+    EllipticCurveScalar b = rand<EllipticCurveScalar>();
+    sc_reduce32(reinterpret_cast<unsigned char*>(&a));
+    sc_reduce32(reinterpret_cast<unsigned char*>(&b));
+    ge_double_scalarmult_base_vartime(&point, reinterpret_cast<const unsigned char*>(&a), &base,
+      reinterpret_cast<const unsigned char*>(&b));
+  }
+
+  return points;
+}
+
+void checkToBytesBatch(size_t count) {
+  std::vector<ge_p2> points = randomPoints(count);
+  std::vector<unsigned char> batch(32 * count);
+  std::unique_ptr<fe[]> scratch(new fe[count]);
+  ge_tobytes_batch(batch.data(), points.data(), scratch.get(), count);
+
+  for (size_t i = 0; i < count; ++i) {
+    unsigned char single[32];
+    ge_tobytes(single, &points[i]);
+    EXPECT_EQ(0, std::memcmp(single, batch.data() + 32 * i, 32)) << "point " << i << " of " << count;
+  }
+}
+
+TEST(GeToBytesBatchTest, matchesSingleConversion) {
+  checkToBytesBatch(1);
+  checkToBytesBatch(2);
+  checkToBytesBatch(17);
+}
+
+TEST(GeToBytesBatchTest, acceptsEmptyBatch) {
+  ge_tobytes_batch(nullptr, nullptr, nullptr, 0);
+}
+
+class RingSignatureBatchTest : public ::testing::Test {
+public:
+  // Ring sizes vary so corrupted signatures sit between valid ones of different shapes
+  RingSignatureBatchTest() {
+    const size_t ringSizes[] = {1, 3, 2, 5, 1, 4, 3};
+    for (size_t i = 0; i < sizeof(ringSizes) / sizeof(ringSizes[0]); ++i) {
+      m_signatures.emplace_back(new RingSignature(ringSizes[i], i % ringSizes[i]));
+    }
+  }
+
+protected:
+  std::vector<std::unique_ptr<RingSignature>> m_signatures;
+};
+
+TEST_F(RingSignatureBatchTest, acceptsValidSignatures) {
+  checkBatch(m_signatures, std::vector<bool>(m_signatures.size(), true));
+}
+
+TEST_F(RingSignatureBatchTest, acceptsEmptyBatch) {
+  check_ring_signatures(nullptr, 0, true, nullptr);
+}
+
+TEST_F(RingSignatureBatchTest, rejectsTamperedScalar) {
+  m_signatures[3]->sigs[2].data[40] ^= 1;
+  std::vector<bool> expected(m_signatures.size(), true);
+  expected[3] = false;
+  checkBatch(m_signatures, expected);
+}
+
+TEST_F(RingSignatureBatchTest, rejectsTamperedPrefixHash) {
+  m_signatures[2]->prefixHash.data[0] ^= 1;
+  std::vector<bool> expected(m_signatures.size(), true);
+  expected[2] = false;
+  checkBatch(m_signatures, expected);
+}
+
+TEST_F(RingSignatureBatchTest, rejectsKeyImageOfOtherKey) {
+  PublicKey publicKey;
+  SecretKey secretKey;
+  generate_keys(publicKey, secretKey);
+  generate_key_image(publicKey, secretKey, m_signatures[5]->image);
+
+  std::vector<bool> expected(m_signatures.size(), true);
+  expected[5] = false;
+  checkBatch(m_signatures, expected);
+}
+
+TEST_F(RingSignatureBatchTest, rejectsKeyImageNotOnCurve) {
+  PublicKey notOnCurve;
+  do {
+    notOnCurve = rand<PublicKey>();
+  } while (check_key(notOnCurve));
+
+  std::memcpy(&m_signatures[1]->image, &notOnCurve, sizeof(notOnCurve));
+  std::vector<bool> expected(m_signatures.size(), true);
+  expected[1] = false;
+  checkBatch(m_signatures, expected);
+}
+
+TEST_F(RingSignatureBatchTest, rejectsNonCanonicalScalarInMiddleOfBatch) {
+  // Above the group order, the single check rejects it before any point arithmetic
+  std::memset(m_signatures[3]->sigs[1].data + 32, 0xff, 32);
+  std::vector<bool> expected(m_signatures.size(), true);
+  expected[3] = false;
+  checkBatch(m_signatures, expected);
+}
+
+TEST_F(RingSignatureBatchTest, rejectsSeveralCorruptedSignatures) {
+  m_signatures[0]->sigs[0].data[0] ^= 0x80;
+  m_signatures[4]->prefixHash.data[31] ^= 0x80;
+  m_signatures[6]->sigs[2].data[63] = 0xff;
+  std::vector<bool> expected(m_signatures.size(), true);
+  expected[0] = false;
+  expected[4] = false;
+  expected[6] = false;
+  checkBatch(m_signatures, expected);
+}
+
+}
@@ -0,0 +1,300 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdexcept>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/ICore.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "Rpc/ViewKeyScanner.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+// Main chain of blocks whose base transactions pay one output each, the rest of the core is not used by the scanner
+class TestCore : public ICore {
+public:
+  void pushBlock(const AccountPublicAddress& address, uint64_t amount) {
+    KeyPair transactionKey = generateKeyPair();
+    Crypto::KeyDerivation derivation;
+    Crypto::generate_key_derivation(address.viewPublicKey, transactionKey.secretKey, derivation);
+
+    KeyOutput output;
+    Crypto::derive_public_key(derivation, 0, address.spendPublicKey, output.key);
+
+    BlockTemplate block = boost::value_initialized<BlockTemplate>();
+    block.majorVersion = BLOCK_MAJOR_VERSION_1;
+    block.baseTransaction.version = CURRENT_TRANSACTION_VERSION;
+    block.baseTransaction.unlockTime = 0;
+    block.baseTransaction.inputs.push_back(BaseInput{static_cast<uint32_t>(m_blocks.size())});
+    block.baseTransaction.outputs.push_back(TransactionOutput{amount, output});
+    addTransactionPublicKeyToExtra(block.baseTransaction.extra, transactionKey.publicKey);
+
+    m_globalIndexes[getObjectHash(block.baseTransaction)] = {static_cast<uint32_t>(m_blocks.size())};
+    m_hashes.push_back(Crypto::rand<Crypto::Hash>());
+    m_blocks.push_back(RawBlock{toBinaryArray(block), {}});
+  }
+
+  void popBlock() {
+    m_blocks.pop_back();
+    m_hashes.pop_back();
+  }
+
+  uint32_t getTopBlockIndex() const override { return static_cast<uint32_t>(m_blocks.size()) - 1; }
+  Crypto::Hash getBlockHashByIndex(uint32_t blockIndex) const override { return m_hashes.at(blockIndex); }
+
+  std::vector<RawBlock> getBlocks(uint32_t startIndex, uint32_t count) const override {
+    return std::vector<RawBlock>(m_blocks.begin() + startIndex, m_blocks.begin() + startIndex + count);
+  }
+
+  bool getTransactionGlobalIndexes(const Crypto::Hash& transactionHash, std::vector<uint32_t>& globalIndexes) const override {
+    auto it = m_globalIndexes.find(transactionHash);
+    if (it == m_globalIndexes.end()) {
+      return false;
+    }
+
+    globalIndexes = it->second;
+    return true;
+  }
+
+  bool addMessageQueue(MessageQueue<BlockchainMessage>&) override { throw std::logic_error("Not implemented"); }
+  bool removeMessageQueue(MessageQueue<BlockchainMessage>&) override { throw std::logic_error("Not implemented"); }
+  Crypto::Hash getTopBlockHash() const override { throw std::logic_error("Not implemented"); }
+  uint64_t getBlockTimestampByIndex(uint32_t) const override { throw std::logic_error("Not implemented"); }
+  bool hasBlock(const Crypto::Hash&) const override { throw std::logic_error("Not implemented"); }
+  BlockTemplate getBlockByIndex(uint32_t) const override { throw std::logic_error("Not implemented"); }
+  BlockTemplate getBlockByHash(const Crypto::Hash&) const override { throw std::logic_error("Not implemented"); }
+  std::vector<Crypto::Hash> buildSparseChain() const override { throw std::logic_error("Not implemented"); }
+  std::vector<Crypto::Hash> findBlockchainSupplement(const std::vector<Crypto::Hash>&, size_t, uint32_t&, uint32_t&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  void getBlocks(const std::vector<Crypto::Hash>&, std::vector<RawBlock>&, std::vector<Crypto::Hash>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  void getBlockViews(const std::vector<Crypto::Hash>&, std::vector<RawBlockView>&, std::vector<Crypto::Hash>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  bool queryBlocks(const std::vector<Crypto::Hash>&, uint64_t, uint32_t&, uint32_t&, uint32_t&, std::vector<BlockFullInfo>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  bool queryBlocksLite(const std::vector<Crypto::Hash>&, uint64_t, bool, uint32_t&, uint32_t&, uint32_t&,
+                       std::vector<BlockShortInfo>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  bool hasTransaction(const Crypto::Hash&) const override { throw std::logic_error("Not implemented"); }
+  void getTransactions(const std::vector<Crypto::Hash>&, std::vector<BinaryArray>&, std::vector<Crypto::Hash>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  Difficulty getBlockDifficulty(uint32_t) const override { throw std::logic_error("Not implemented"); }
+  Difficulty getDifficultyForNextBlock() const override { throw std::logic_error("Not implemented"); }
+  bool isInCheckpointZone(uint32_t) const override { throw std::logic_error("Not implemented"); }
+  std::error_code addBlock(const CachedBlock&, RawBlock&&) override { throw std::logic_error("Not implemented"); }
+  std::error_code addBlock(const CachedBlock&, RawBlock&&, std::vector<CachedTransaction>&&) override {
+    throw std::logic_error("Not implemented");
+  }
+  std::error_code addBlock(RawBlock&&) override { throw std::logic_error("Not implemented"); }
+  std::error_code submitBlock(BinaryArray&&) override { throw std::logic_error("Not implemented"); }
+  bool getRandomOutputs(uint64_t, uint16_t, std::vector<uint32_t>&, std::vector<Crypto::PublicKey>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  bool addTransactionToPool(const BinaryArray&) override { throw std::logic_error("Not implemented"); }
+  std::vector<bool> addTransactionsToPool(const std::vector<BinaryArray>&) override { throw std::logic_error("Not implemented"); }
+  std::vector<Crypto::Hash> getPoolTransactionHashes() const override { throw std::logic_error("Not implemented"); }
+  void getPoolTransactions(const std::vector<Crypto::Hash>&, std::vector<BinaryArray>&, std::vector<Crypto::Hash>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  bool getPoolChanges(const Crypto::Hash&, const std::vector<Crypto::Hash>&, std::vector<BinaryArray>&,
+                      std::vector<Crypto::Hash>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  bool getPoolChangesLite(const Crypto::Hash&, const std::vector<Crypto::Hash>&, std::vector<TransactionPrefixInfo>&,
+                          std::vector<Crypto::Hash>&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  bool getBlockTemplate(BlockTemplate&, const AccountPublicAddress&, const BinaryArray&, Difficulty&, uint32_t&) const override {
+    throw std::logic_error("Not implemented");
+  }
+  CoreStatistics getCoreStatistics() const override { throw std::logic_error("Not implemented"); }
+  LookupCacheStatistics getLookupCacheStatistics() const override { throw std::logic_error("Not implemented"); }
+  void save() override { throw std::logic_error("Not implemented"); }
+  void load() override { throw std::logic_error("Not implemented"); }
+  BlockDetails getBlockDetails(const Crypto::Hash&) const override { throw std::logic_error("Not implemented"); }
+  std::vector<BlockSummary> getBlockSummaries(uint32_t, uint32_t) const override { throw std::logic_error("Not implemented"); }
+  TransactionDetails getTransactionDetails(const Crypto::Hash&) const override { throw std::logic_error("Not implemented"); }
+  std::vector<Crypto::Hash> getAlternativeBlockHashesByIndex(uint32_t) const override { throw std::logic_error("Not implemented"); }
+  std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t, size_t) const override { throw std::logic_error("Not implemented"); }
+  std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash&) const override {
+    throw std::logic_error("Not implemented");
+  }
+
+private:
+  std::vector<RawBlock> m_blocks;
+  std::vector<Crypto::Hash> m_hashes;
+  std::unordered_map<Crypto::Hash, std::vector<uint32_t>> m_globalIndexes;
+};
+
+class ViewKeyScannerTest : public ::testing::Test {
+public:
+  ViewKeyScannerTest() : m_scanner(m_core) {
+    m_viewKey = generateKeyPair();
+    m_spendKey = generateKeyPair();
+    m_address.viewPublicKey = m_viewKey.publicKey;
+    m_address.spendPublicKey = m_spendKey.publicKey;
+  }
+
+  std::vector<ScannedOutput> poll(const Crypto::Hash& subscriptionId, uint32_t& scannedIndex, bool& detached, uint32_t& detachIndex) {
+    ViewKeyScanner::ScanJob job;
+    std::vector<ScannedOutput> outputs;
+    EXPECT_TRUE(m_scanner.prepareScan(subscriptionId, job));
+    ViewKeyScanner::scan(job);
+    m_scanner.resolveGlobalIndexes(job);
+    EXPECT_TRUE(m_scanner.getOutputs(subscriptionId, job, 1000, outputs, scannedIndex, detached, detachIndex));
+    return outputs;
+  }
+
+protected:
+  TestCore m_core;
+  ViewKeyScanner m_scanner;
+  KeyPair m_viewKey;
+  KeyPair m_spendKey;
+  AccountPublicAddress m_address;
+};
+
+TEST_F(ViewKeyScannerTest, chainSwitchRewindsToFirstSwitchedBlock) {
+  for (uint64_t amount = 1; amount <= 5; ++amount) {
+    m_core.pushBlock(m_address, amount);
+  }
+
+  Crypto::Hash subscriptionId;
+  ASSERT_TRUE(m_scanner.subscribe(m_viewKey.secretKey, {m_spendKey.publicKey}, 0, subscriptionId));
+
+  uint32_t scannedIndex;
+  bool detached;
+  uint32_t detachIndex;
+  std::vector<ScannedOutput> outputs = poll(subscriptionId, scannedIndex, detached, detachIndex);
+  ASSERT_EQ(5, outputs.size());
+  ASSERT_EQ(5, scannedIndex);
+  ASSERT_FALSE(detached);
+  for (uint32_t i = 0; i < 5; ++i) {
+    ASSERT_EQ(i, outputs[i].blockIndex);
+    ASSERT_EQ(i, outputs[i].globalOutputIndex);
+    ASSERT_EQ(i + 1, outputs[i].amount);
+    ASSERT_EQ(m_spendKey.publicKey, outputs[i].spendPublicKey);
+  }
+
+  // Blocks 3 and 4 are replaced by a longer chain
+  m_core.popBlock();
+  m_core.popBlock();
+  for (uint64_t amount = 30; amount < 33; ++amount) {
+    m_core.pushBlock(m_address, amount);
+  }
+
+  outputs = poll(subscriptionId, scannedIndex, detached, detachIndex);
+  ASSERT_TRUE(detached);
+  ASSERT_EQ(3, detachIndex);
+  ASSERT_EQ(6, scannedIndex);
+  ASSERT_EQ(3, outputs.size());
+  for (uint32_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(3 + i, outputs[i].blockIndex);
+    ASSERT_EQ(30 + i, outputs[i].amount);
+  }
+
+  outputs = poll(subscriptionId, scannedIndex, detached, detachIndex);
+  ASSERT_FALSE(detached);
+  ASSERT_TRUE(outputs.empty());
+}
+
+TEST_F(ViewKeyScannerTest, chainSwitchDropsPendingOutputsOfSwitchedBlocks) {
+  for (uint64_t amount = 1; amount <= 4; ++amount) {
+    m_core.pushBlock(m_address, amount);
+  }
+
+  Crypto::Hash subscriptionId;
+  ASSERT_TRUE(m_scanner.subscribe(m_viewKey.secretKey, {m_spendKey.publicKey}, 0, subscriptionId));
+
+  // Only the first output is taken, the others stay pending when the chain switches
+  ViewKeyScanner::ScanJob job;
+  std::vector<ScannedOutput> outputs;
+  uint32_t scannedIndex;
+  bool detached;
+  uint32_t detachIndex;
+  ASSERT_TRUE(m_scanner.prepareScan(subscriptionId, job));
+  ViewKeyScanner::scan(job);
+  m_scanner.resolveGlobalIndexes(job);
+  ASSERT_TRUE(m_scanner.getOutputs(subscriptionId, job, 1, outputs, scannedIndex, detached, detachIndex));
+  ASSERT_EQ(1, outputs.size());
+  ASSERT_EQ(1, scannedIndex);
+
+  m_core.popBlock();
+  m_core.popBlock();
+  m_core.popBlock();
+  m_core.pushBlock(m_address, 20);
+
+  outputs = poll(subscriptionId, scannedIndex, detached, detachIndex);
+  ASSERT_TRUE(detached);
+  ASSERT_EQ(1, detachIndex);
+  ASSERT_EQ(2, scannedIndex);
+  ASSERT_EQ(1, outputs.size());
+  ASSERT_EQ(1, outputs[0].blockIndex);
+  ASSERT_EQ(20, outputs[0].amount);
+}
+
+
+// Blocks copied before a chain switch aren't reported, the subscription scans the new chain from the first of them
+TEST_F(ViewKeyScannerTest, chainSwitchDuringScanDropsSwitchedBlocks) {
+  for (uint64_t amount = 1; amount <= 3; ++amount) {
+    m_core.pushBlock(m_address, amount);
+  }
+
+  Crypto::Hash subscriptionId;
+  ASSERT_TRUE(m_scanner.subscribe(m_viewKey.secretKey, {m_spendKey.publicKey}, 0, subscriptionId));
+
+  ViewKeyScanner::ScanJob job;
+  std::vector<ScannedOutput> outputs;
+  uint32_t scannedIndex;
+  bool detached;
+  uint32_t detachIndex;
+  ASSERT_TRUE(m_scanner.prepareScan(subscriptionId, job));
+  ViewKeyScanner::scan(job);
+
+  m_core.popBlock();
+  m_core.pushBlock(m_address, 20);
+
+  m_scanner.resolveGlobalIndexes(job);
+  ASSERT_TRUE(m_scanner.getOutputs(subscriptionId, job, 1000, outputs, scannedIndex, detached, detachIndex));
+  ASSERT_FALSE(detached);
+  ASSERT_EQ(2, scannedIndex);
+  ASSERT_EQ(2, outputs.size());
+  ASSERT_EQ(1, outputs[1].blockIndex);
+  ASSERT_EQ(1, outputs[1].globalOutputIndex);
+
+  outputs = poll(subscriptionId, scannedIndex, detached, detachIndex);
+  ASSERT_FALSE(detached);
+  ASSERT_EQ(3, scannedIndex);
+  ASSERT_EQ(1, outputs.size());
+  ASSERT_EQ(2, outputs[0].blockIndex);
+  ASSERT_EQ(2, outputs[0].globalOutputIndex);
+  ASSERT_EQ(20, outputs[0].amount);
+}
+
+}
@@ -0,0 +1,347 @@
+// Copyright (c) 2026, The Talleo developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <array>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/MemoryInputStream.h"
+#include "Common/StringOutputStream.h"
+#include "Serialization/KVBinaryCommon.h"
+#include "Serialization/KVBinaryInputBufferSerializer.h"
+#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryOutputStreamSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+struct Item {
+  uint64_t amount = 0;
+  std::string key;
+  bool spent = false;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(amount)
+    KV_MEMBER(key)
+    KV_MEMBER(spent)
+  }
+
+  bool operator==(const Item& other) const {
+    return std::tie(amount, key, spent) == std::tie(other.amount, other.key, other.spent);
+  }
+};
+
+struct Message {
+  uint8_t version = 0;
+  int16_t delta = 0;
+  uint16_t port = 0;
+  int32_t offset = 0;
+  uint32_t height = 0;
+  int64_t balance = 0;
+  uint64_t total = 0;
+  bool flag = false;
+  std::string name;
+  std::array<uint8_t, 8> id = {};
+  std::string blob;
+  Item item;
+  std::vector<Item> items;
+  std::vector<std::string> blobs;
+  std::vector<uint32_t> heights;
+  std::vector<uint64_t> packed;
+  std::map<std::string, uint64_t> amounts;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(version)
+    KV_MEMBER(delta)
+    KV_MEMBER(port)
+    KV_MEMBER(offset)
+    KV_MEMBER(height)
+    KV_MEMBER(balance)
+    KV_MEMBER(total)
+    KV_MEMBER(flag)
+    KV_MEMBER(name)
+    KV_MEMBER(id)
+    s.binary(blob, "blob");
+    KV_MEMBER(item)
+    KV_MEMBER(items)
+    KV_MEMBER(blobs)
+    KV_MEMBER(heights)
+    serializeAsBinary(packed, "packed", s);
+    KV_MEMBER(amounts)
+  }
+
+  bool operator==(const Message& other) const {
+    return std::tie(version, delta, port, offset, height, balance, total, flag, name, id, blob, item, items, blobs, heights,
+      packed, amounts) == std::tie(other.version, other.delta, other.port, other.offset, other.height, other.balance,
+      other.total, other.flag, other.name, other.id, other.blob, other.item, other.items, other.blobs, other.heights,
+      other.packed, other.amounts);
+  }
+};
+
+// Reads a subset of the fields of Message in a different order, plus fields it doesn't have
+struct PartialMessage {
+  std::vector<Item> items;
+  std::string name;
+  uint64_t missingNumber = 7;
+  std::string missingString = "default";
+  Item missingItem;
+  std::vector<uint32_t> missingHeights = {1, 2};
+  Item item;
+  uint32_t height = 0;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(items)
+    KV_MEMBER(name)
+    KV_MEMBER(missingNumber)
+    KV_MEMBER(missingString)
+    KV_MEMBER(missingItem)
+    KV_MEMBER(missingHeights)
+    KV_MEMBER(item)
+    KV_MEMBER(height)
+  }
+
+  bool operator==(const PartialMessage& other) const {
+    return std::tie(items, name, missingNumber, missingString, missingItem, missingHeights, item, height) ==
+      std::tie(other.items, other.name, other.missingNumber, other.missingString, other.missingItem, other.missingHeights,
+      other.item, other.height);
+  }
+};
+
+Item makeItem(uint64_t amount, const std::string& key, bool spent) {
+  Item item;
+  item.amount = amount;
+  item.key = key;
+  item.spent = spent;
+  return item;
+}
+
+Message makeMessage() {
+  Message message;
+  message.version = 200;
+  message.delta = -300;
+  message.port = 60000;
+  message.offset = -70000;
+  message.height = 4000000000;
+  message.balance = -5000000000;
+  message.total = 18000000000000000000ull;
+  message.flag = true;
+  message.name = "talleo";
+  message.id = {{1, 2, 3, 4, 5, 6, 7, 8}};
+  message.blob = std::string("\0\1\2binary\xff", 10);
+  message.item = makeItem(10, "first", true);
+  for (uint64_t i = 0; i < 100; ++i) {
+    message.items.push_back(makeItem(i * 1000, std::string(i % 7, static_cast<char>('a' + i % 26)), i % 2 == 0));
+  }
+
+  message.blobs = {"", std::string(300, 'x'), std::string(70000, 'y')};
+  message.heights = {0, 1, 1000000};
+  message.packed = {5, 6, 7};
+  message.amounts = {{"a", 1}, {"b", 2}};
+  return message;
+}
+
+template <typename T>
+std::string store(T& value) {
+  KVBinaryOutputStreamSerializer serializer;
+  serialize(value, serializer);
+
+  std::string result;
+  Common::StringOutputStream stream(result);
+  serializer.dump(stream);
+  return result;
+}
+
+template <typename T>
+T loadWithStreamSerializer(const std::string& data) {
+  Common::MemoryInputStream stream(data.data(), data.size());
+  KVBinaryInputStreamSerializer serializer(stream);
+  T value;
+  serialize(value, serializer);
+  return value;
+}
+
+// The input is copied to a buffer of its exact size, so reading past the end is caught by address sanitizer builds
+template <typename T>
+T loadWithBufferSerializer(const std::string& data) {
+  std::vector<char> buffer(data.begin(), data.end());
+  KVBinaryInputBufferSerializer serializer(buffer.data(), buffer.size());
+  T value;
+  serialize(value, serializer);
+  return value;
+}
+
+template <typename T>
+void expectSameResult(const std::string& data) {
+  EXPECT_TRUE(loadWithStreamSerializer<T>(data) == loadWithBufferSerializer<T>(data));
+}
+
+template <typename T>
+void expectBothThrow(const std::string& data) {
+  EXPECT_THROW(loadWithStreamSerializer<T>(data), std::exception);
+  EXPECT_THROW(loadWithBufferSerializer<T>(data), std::exception);
+}
+
+std::string header(uint32_t signatureA = PORTABLE_STORAGE_SIGNATUREA, uint8_t version = PORTABLE_STORAGE_FORMAT_VER) {
+  KVBinaryStorageBlockHeader hdr;
+  hdr.m_signature_a = signatureA;
+  hdr.m_signature_b = PORTABLE_STORAGE_SIGNATUREB;
+  hdr.m_ver = version;
+  return std::string(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+}
+
+std::string varint(uint64_t value, uint8_t sizeMark) {
+  static const size_t SIZES[] = {1, 2, 4, 8};
+  value = (value << 2) | sizeMark;
+  return std::string(reinterpret_cast<const char*>(&value), SIZES[sizeMark]);
+}
+
+std::string varint(uint64_t value) {
+  return varint(value, value < 64 ? PORTABLE_RAW_SIZE_MARK_BYTE : PORTABLE_RAW_SIZE_MARK_DWORD);
+}
+
+std::string entry(const std::string& name, uint8_t type) {
+  return std::string(1, static_cast<char>(name.size())) + name + std::string(1, static_cast<char>(type));
+}
+
+std::string uint64Value(uint64_t value) {
+  return std::string(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}
+
+TEST(KVBinaryInputBufferSerializerTest, readsWhatWasWritten) {
+  Message message = makeMessage();
+  std::string data = store(message);
+
+  EXPECT_TRUE(message == loadWithBufferSerializer<Message>(data));
+  expectSameResult<Message>(data);
+}
+
+TEST(KVBinaryInputBufferSerializerTest, readsEmptyObject) {
+  Message message;
+  std::string data = store(message);
+
+  EXPECT_TRUE(message == loadWithBufferSerializer<Message>(data));
+  expectSameResult<Message>(data);
+}
+
+TEST(KVBinaryInputBufferSerializerTest, readsFieldsInAnyOrderAndKeepsMissingOnes) {
+  Message message = makeMessage();
+  std::string data = store(message);
+
+  PartialMessage partial = loadWithBufferSerializer<PartialMessage>(data);
+  EXPECT_EQ(message.items.size(), partial.items.size());
+  EXPECT_TRUE(message.item == partial.item);
+  EXPECT_EQ(message.name, partial.name);
+  EXPECT_EQ(message.height, partial.height);
+  EXPECT_EQ(7, partial.missingNumber);
+  EXPECT_EQ("default", partial.missingString);
+  EXPECT_TRUE(Item() == partial.missingItem);
+  // Containers not found are cleared, empty ones aren't written at all
+  EXPECT_TRUE(partial.missingHeights.empty());
+  expectSameResult<PartialMessage>(data);
+}
+
+TEST(KVBinaryInputBufferSerializerTest, readsNestedObjects) {
+  std::string data = header() + varint(1) +
+    entry("item", BIN_KV_SERIALIZE_TYPE_OBJECT) + varint(2) +
+      entry("nested", BIN_KV_SERIALIZE_TYPE_OBJECT) + varint(1) +
+        entry("amount", BIN_KV_SERIALIZE_TYPE_UINT64) + uint64Value(1) +
+      entry("amount", BIN_KV_SERIALIZE_TYPE_UINT64) + uint64Value(2);
+
+  Message message = loadWithBufferSerializer<Message>(data);
+  EXPECT_EQ(2, message.item.amount);
+  expectSameResult<Message>(data);
+}
+
+// A repeated name keeps its first value in both serializers
+TEST(KVBinaryInputBufferSerializerTest, firstOfRepeatedFieldsWins) {
+  std::string data = header() + varint(2) +
+    entry("amount", BIN_KV_SERIALIZE_TYPE_UINT64) + uint64Value(1) +
+    entry("amount", BIN_KV_SERIALIZE_TYPE_UINT64) + uint64Value(2);
+
+  EXPECT_EQ(1, loadWithBufferSerializer<Item>(data).amount);
+  expectSameResult<Item>(data);
+}
+
+TEST(KVBinaryInputBufferSerializerTest, readsWideVarints) {
+  std::string data = header() + varint(1, PORTABLE_RAW_SIZE_MARK_INT64) +
+    entry("key", BIN_KV_SERIALIZE_TYPE_STRING) + varint(3, PORTABLE_RAW_SIZE_MARK_WORD) + "abc";
+
+  EXPECT_EQ("abc", loadWithBufferSerializer<Item>(data).key);
+  expectSameResult<Item>(data);
+}
+
+TEST(KVBinaryInputBufferSerializerTest, rejectsInvalidRoot) {
+  expectBothThrow<Item>("");
+  expectBothThrow<Item>(header().substr(0, sizeof(KVBinaryStorageBlockHeader) - 1));
+  expectBothThrow<Item>(header(PORTABLE_STORAGE_SIGNATUREA + 1) + varint(0));
+  expectBothThrow<Item>(header(PORTABLE_STORAGE_SIGNATUREA, PORTABLE_STORAGE_FORMAT_VER + 1) + varint(0));
+  expectBothThrow<Item>(header());
+}
+
+TEST(KVBinaryInputBufferSerializerTest, rejectsTruncatedInput) {
+  Message message = makeMessage();
+  message.blobs.resize(2);
+  std::string data = store(message);
+
+  for (size_t size = 0; size < data.size(); ++size) {
+    SCOPED_TRACE(size);
+    expectBothThrow<Message>(data.substr(0, size));
+  }
+}
+
+TEST(KVBinaryInputBufferSerializerTest, rejectsBadVarints) {
+  expectBothThrow<Item>(header() + varint(1, PORTABLE_RAW_SIZE_MARK_INT64).substr(0, 5));
+  expectBothThrow<Item>(header() + varint(1) + entry("key", BIN_KV_SERIALIZE_TYPE_STRING) +
+    varint(3, PORTABLE_RAW_SIZE_MARK_DWORD).substr(0, 2));
+}
+
+TEST(KVBinaryInputBufferSerializerTest, rejectsOversizedCounts) {
+  std::string field = entry("amount", BIN_KV_SERIALIZE_TYPE_UINT64) + uint64Value(1);
+  expectBothThrow<Item>(header() + varint(1000) + field);
+  expectBothThrow<Item>(header() + varint(1) + entry("key", BIN_KV_SERIALIZE_TYPE_STRING) + varint(1 << 20) + "abc");
+  expectBothThrow<Message>(header() + varint(1) +
+    entry("items", BIN_KV_SERIALIZE_TYPE_OBJECT | BIN_KV_SERIALIZE_FLAG_ARRAY) + varint(1000) + varint(0));
+  expectBothThrow<Message>(header() + varint(1) +
+    entry("heights", BIN_KV_SERIALIZE_TYPE_UINT32 | BIN_KV_SERIALIZE_FLAG_ARRAY) + varint(3) + uint64Value(1));
+}
+
+TEST(KVBinaryInputBufferSerializerTest, rejectsUnknownTypeTags) {
+  expectBothThrow<Item>(header() + varint(1) + entry("amount", 0) + uint64Value(1));
+  expectBothThrow<Item>(header() + varint(1) + entry("amount", BIN_KV_SERIALIZE_TYPE_ARRAY + 1) + uint64Value(1));
+  expectBothThrow<Message>(header() + varint(1) +
+    entry("items", (BIN_KV_SERIALIZE_TYPE_ARRAY + 1) | BIN_KV_SERIALIZE_FLAG_ARRAY) + varint(1) + uint64Value(1));
+}
+
+TEST(KVBinaryInputBufferSerializerTest, rejectsValuesOfWrongType) {
+  expectBothThrow<Item>(header() + varint(1) + entry("amount", BIN_KV_SERIALIZE_TYPE_STRING) + varint(1) + "1");
+  expectBothThrow<Item>(header() + varint(1) + entry("key", BIN_KV_SERIALIZE_TYPE_UINT64) + uint64Value(1));
+  expectBothThrow<Item>(header() + varint(1) + entry("spent", BIN_KV_SERIALIZE_TYPE_UINT8) + "\1");
+  expectBothThrow<Message>(header() + varint(1) + entry("item", BIN_KV_SERIALIZE_TYPE_UINT64) + uint64Value(1));
+  expectBothThrow<Message>(header() + varint(1) + entry("items", BIN_KV_SERIALIZE_TYPE_UINT64) + uint64Value(1));
+  expectBothThrow<Message>(header() + varint(1) +
+    entry("items", BIN_KV_SERIALIZE_TYPE_UINT64 | BIN_KV_SERIALIZE_FLAG_ARRAY) + varint(1) + uint64Value(1));
+  expectBothThrow<Message>(header() + varint(1) + entry("id", BIN_KV_SERIALIZE_TYPE_STRING) + varint(3) + "abc");
+}
@@ -18,6 +18,7 @@
 #include <cstddef>
 #include <cstring>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -46,6 +47,16 @@ int main(int argc, char *argv[]) {
   string cmd;
   size_t test = 0;
   bool error = false;
+  // Ring signatures are checked once more in a single batch at the end
+  struct RingSignatureTest {
+    size_t test;
+    chash prefix_hash;
+    Crypto::KeyImage image;
+    vector<Crypto::PublicKey> pubs;
+    vector<Crypto::Signature> sigs;
+    bool expected;
+  };
+  vector<RingSignatureTest> ring_signature_tests;
   setup_random();
   if (argc != 2) {
     cerr << "invalid arguments" << endl;
@@ -254,6 +265,7 @@ int main(int argc, char *argv[]) {
       if (expected != actual) {
         goto error;
       }
+      ring_signature_tests.push_back({ test, prefix_hash, image, vpubs, sigs, expected });
     } else {
       throw ios_base::failure("Unknown function: " + cmd);
     }
@@ -262,5 +274,22 @@ error:
     cerr << "Wrong result on test " << test << endl;
     error = true;
   }
+  vector<vector<const Crypto::PublicKey *>> ring_signature_pubs(ring_signature_tests.size());
+  vector<Crypto::RingSignatureToCheck> ring_signature_checks;
+  for (size_t i = 0; i < ring_signature_tests.size(); i++) {
+    const RingSignatureTest &t = ring_signature_tests[i];
+    for (const Crypto::PublicKey &pub : t.pubs) {
+      ring_signature_pubs[i].push_back(&pub);
+    }
+    ring_signature_checks.push_back({ &t.prefix_hash, &t.image, ring_signature_pubs[i].data(), t.pubs.size(), t.sigs.data() });
+  }
+  unique_ptr<bool[]> ring_signature_results(new bool[ring_signature_checks.size() + 1]);
+  check_ring_signatures(ring_signature_checks.data(), ring_signature_checks.size(), true, ring_signature_results.get());
+  for (size_t i = 0; i < ring_signature_tests.size(); i++) {
+    if (ring_signature_results[i] != ring_signature_tests[i].expected) {
+      cerr << "Wrong batch result on test " << ring_signature_tests[i].test << endl;
+      error = true;
+    }
+  }
   return error ? 1 : 0;
 }